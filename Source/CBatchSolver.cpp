@@ -0,0 +1,181 @@
+/******************************************************************************/
+/**
+@file         CBatchSolver.cpp
+@copyright
+*
+@description  Gaussian elimination of many small systems of the same size.
+*******************************************************************************/
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC optimize("tree-vectorize") // Not part of -O2 before GCC 12
+#endif
+#include <cmath>
+#include "CBatchSolver.h"
+#include "CProfiler.h"
+
+#define FOR_LANES(lx) for (size_t lx{}; lx < Lanes; lx++)
+
+/* METHOD *********************************************************************/
+/**
+  Ctor
+@param      n: Size of the matrices
+@param numRhs: Number of right hand sides
+*******************************************************************************/
+CBatchSolver::CBatchSolver(size_t n, size_t numRhs)
+	: m_N(n)
+	, m_NumRhs(numRhs)
+	, m_A(n * n)
+	, m_B(n * numRhs)
+	, m_Det()
+	, m_Singular()
+{
+	clear();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Sets all matrix elements and right hand sides to 0.
+*******************************************************************************/
+void CBatchSolver::clear()
+{
+	const SLanes zero{};
+	m_A.assign(m_A.size(), zero);
+	m_B.assign(m_B.size(), zero);
+	m_Det = zero;
+	m_Singular = zero;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Gaussian elimination with partial pivoting of all lanes, the right hand
+  sides are transformed along. Determinants are available afterwards.
+*******************************************************************************/
+void CBatchSolver::factorize()
+{
+	PROFILE_SCOPE("batchFactorize");
+	const size_t n{m_N};
+	FOR_LANES(lx)
+	{
+		m_Det.v[lx] = 1.0;
+		m_Singular.v[lx] = 0.0;
+	}
+	for (size_t k{}; k < n; k++)
+	{
+		// Pivot row per lane (as double: same vector width as the data).
+		SLanes best(elemA(k, k));
+		SLanes piv;
+		FOR_LANES(lx)
+		{
+			best.v[lx] = fabs(best.v[lx]);
+			piv.v[lx] = double(k);
+		}
+		for (size_t r{k + 1}; r < n; r++)
+		{
+			const SLanes& ar(elemA(r, k));
+			FOR_LANES(lx)
+			{
+				const double val{fabs(ar.v[lx])};
+				const bool larger{val > best.v[lx]};
+				best.v[lx] = larger ? val : best.v[lx];
+				piv.v[lx] = larger ? double(r) : piv.v[lx];
+			}
+		}
+		FOR_LANES(lx)
+		{
+			m_Singular.v[lx] = best.v[lx] == 0.0 ? 1.0 : m_Singular.v[lx];
+			m_Det.v[lx] = piv.v[lx] != double(k) ? -m_Det.v[lx] : m_Det.v[lx];
+		}
+		// Masked exchange of row k and the pivot row.
+		for (size_t r{k + 1}; r < n; r++)
+		{
+			for (size_t c{k}; c < n + m_NumRhs; c++)
+			{
+				SLanes& x(c < n ? elemA(k, c) : elemB(k, c - n));
+				SLanes& y(c < n ? elemA(r, c) : elemB(r, c - n));
+				FOR_LANES(lx)
+				{
+					const bool swap{piv.v[lx] == double(r)};
+					const double xv{x.v[lx]};
+					const double yv{y.v[lx]};
+					x.v[lx] = swap ? yv : xv;
+					y.v[lx] = swap ? xv : yv;
+				}
+			}
+		}
+		SLanes inv;
+		const SLanes& akk(elemA(k, k));
+		FOR_LANES(lx)
+		{
+			m_Det.v[lx] *= akk.v[lx];
+			inv.v[lx] = 1.0 / (akk.v[lx] == 0.0 ? 1.0 : akk.v[lx]);
+		}
+		for (size_t r{k + 1}; r < n; r++)
+		{	// Clear column below
+			SLanes f(elemA(r, k));
+			FOR_LANES(lx)
+			{
+				f.v[lx] *= inv.v[lx];
+			}
+			for (size_t c{k + 1}; c < n; c++)
+			{
+				SLanes& arc(elemA(r, c));
+				const SLanes& akc(elemA(k, c));
+				FOR_LANES(lx)
+				{
+					arc.v[lx] -= f.v[lx] * akc.v[lx];
+				}
+			}
+			for (size_t c{}; c < m_NumRhs; c++)
+			{
+				SLanes& brc(elemB(r, c));
+				const SLanes& bkc(elemB(k, c));
+				FOR_LANES(lx)
+				{
+					brc.v[lx] -= f.v[lx] * bkc.v[lx];
+				}
+			}
+			elemA(r, k) = f;
+		}
+	}
+	FOR_LANES(lx)
+	{
+		m_Det.v[lx] = m_Singular.v[lx] != 0.0 ? 0.0 : m_Det.v[lx];
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Back substitution, the right hand sides are replaced by the solutions.
+@precondition factorize(). Results of singular lanes are undefined.
+*******************************************************************************/
+void CBatchSolver::solve()
+{
+	PROFILE_SCOPE("batchSolve");
+	const size_t n{m_N};
+	for (size_t r{n}; r-- > 0;)
+	{
+		SLanes inv;
+		const SLanes& arr(elemA(r, r));
+		FOR_LANES(lx)
+		{
+			inv.v[lx] = 1.0 / (arr.v[lx] == 0.0 ? 1.0 : arr.v[lx]);
+		}
+		for (size_t k{}; k < m_NumRhs; k++)
+		{
+			SLanes sum(elemB(r, k));
+			for (size_t c{r + 1}; c < n; c++)
+			{
+				const SLanes& arc(elemA(r, c));
+				const SLanes& bck(elemB(c, k));
+				FOR_LANES(lx)
+				{
+					sum.v[lx] -= arc.v[lx] * bck.v[lx];
+				}
+			}
+			FOR_LANES(lx)
+			{
+				sum.v[lx] *= inv.v[lx];
+			}
+			elemB(r, k) = sum;
+		}
+	}
+}
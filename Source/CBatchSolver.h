@@ -0,0 +1,54 @@
+/******************************************************************************/
+/**
+@file         CBatchSolver.h
+@copyright
+*
+@description  Gaussian elimination of many small systems of the same size.
+*******************************************************************************/
+#ifndef CBATCHSOLVER_H
+#define CBATCHSOLVER_H
+
+#include <cstddef>
+#include <vector>
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Solves up to Lanes systems A x = b of the same size n at once. The matrices
+  are stored as structure of arrays (one value per lane for each element), all
+  loops run over the lanes without branches (pivot choice and row exchange use
+  per-lane masks), so the compiler vectorizes them (SSE2 by default, AVX2 or
+  AVX-512 with -mavx2 / -mavx512f). Unused lanes compute garbage.
+  Pivoting and singularity test (exact zero pivot) follow matrix<T>::Det().
+  Independent of Qt.
+*******************************************************************************/
+class CBatchSolver
+{
+public:
+	enum { Lanes = 8 };
+private:
+	struct SLanes
+	{
+		double v[Lanes];
+	};
+	size_t m_N;
+	size_t m_NumRhs;
+	std::vector<SLanes> m_A; // n x n, row major
+	std::vector<SLanes> m_B; // n x numRhs, row major
+	SLanes m_Det;
+	SLanes m_Singular;       // 1 for singular matrices
+	SLanes& elemA(size_t r, size_t c) { return m_A[r * m_N + c]; }
+	SLanes& elemB(size_t r, size_t k) { return m_B[r * m_NumRhs + k]; }
+public:
+	CBatchSolver(size_t n, size_t numRhs = 0);
+	void clear();
+	size_t size() const { return m_N; }
+	double& a(size_t lane, size_t r, size_t c) { return m_A[r * m_N + c].v[lane]; }
+	double& b(size_t lane, size_t r, size_t k) { return m_B[r * m_NumRhs + k].v[lane]; }
+	void factorize();
+	void solve();
+	double det(size_t lane) const { return m_Det.v[lane]; }
+	bool singular(size_t lane) const { return m_Singular.v[lane] != 0; }
+	double x(size_t lane, size_t r, size_t k) const { return m_B[r * m_NumRhs + k].v[lane]; }
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include <QtPrintSupport/QPrinter>
 #include <QtWidgets/QHBoxLayout>
 #include <QtWidgets/QPushButton>
+#include <QtGui/QTextCursor>
+#include <QtGui/QTextDocument>
+#include <QtGui/QTextFrame>
 #include <QtWidgets/QTextBrowser>
 #include "CDlgHtml.h"
 #include "Util.h"
@@ -21,6 +24,7 @@ attribute makes this interaction possible.
 CDlgHtml::CDlgHtml(const QString& html, QWidget* parent)
   : QDialog(parent)
   , m_TextBrowser()
+  , m_Sections()
 {
   setWindowTitle("Kanon ouput: Dimensions and exponent matrix");
   QVBoxLayout* loMain{new QVBoxLayout};
@@ -48,6 +52,31 @@ CDlgHtml::CDlgHtml(const QString& html, QWidget* parent)
   m_TextBrowser->setFont(fnt);
 }
 
+/* METHOD *********************************************************************/
+/**
+  Replaces the content of a section; sections up to index are appended if
+  missing. Each section is a frame of the document, so the other sections
+  keep their layout and the view its scroll position.
+@param index: 0-based
+@param  html: Fragment (no head and body tags)
+*******************************************************************************/
+void CDlgHtml::setSection(size_t index, const QString& html)
+{
+  QTextDocument* doc{m_TextBrowser->document()};
+  while (m_Sections.size() <= index)
+  {
+    QTextCursor cursor(doc->rootFrame()->lastCursorPosition());
+    m_Sections.push_back(cursor.insertFrame(QTextFrameFormat()));
+  }
+  QTextFrame* frame{m_Sections[index]};
+  QTextCursor cursor(frame->firstCursorPosition());
+  cursor.beginEditBlock();
+  cursor.setPosition(frame->lastPosition(), QTextCursor::KeepAnchor);
+  cursor.removeSelectedText();
+  cursor.insertHtml(html);
+  cursor.endEditBlock();
+}
+
 /* METHOD *********************************************************************/
 /**
 *******************************************************************************/
@@ -2,20 +2,26 @@
 #ifndef CDLGHTML_H
 #define CDLGHTML_H
 
+#include <vector>
 #include <QtWidgets/QDialog>
 
 class QTextBrowser;
+class QTextFrame;
 
 /* CLASS DECLARATION **********************************************************/
 /**
+  Shows a HTML page. A page given in sections (see setSection()) is updated
+  in place: only the changed sections of the document are laid out again.
 *******************************************************************************/
 class CDlgHtml : public QDialog
 {
 	Q_OBJECT
 public:
   CDlgHtml(const QString& html, QWidget* parent = nullptr);
+  void setSection(size_t index, const QString& html);
 private:
   QTextBrowser* m_TextBrowser;
+  std::vector<QTextFrame*> m_Sections; // Frames in the document of m_TextBrowser
   QSize sizeHint() const { return QSize(750, 600); }
   void keyPressEvent(QKeyEvent*) override;
 private slots:
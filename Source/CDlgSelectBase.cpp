@@ -1,6 +1,7 @@
 // Base class for dialog diplaying a selection table.
 #include <QSignalMapper>
 #include <QtWidgets/QCheckBox>
+#include <QtWidgets/QHeaderView>
 #include <QtWidgets/QLayout>
 #include <QtWidgets/QPushButton>
 #include "CDlgSelectBase.h"
@@ -11,7 +12,7 @@
 /**
   Ctor.
 *******************************************************************************/
-CDlgSelectBase::CDlgSelectBase(QWidget* parent, const QString& title, QAbstractTableModel* tableModel, unsigned bgcolor)
+CDlgSelectBase::CDlgSelectBase(QWidget* parent, const QString& title, QAbstractItemModel* tableModel, unsigned bgcolor)
   : QDialog(parent)
   , m_Title(title)
   , m_BoxLayout(new QHBoxLayout)
@@ -26,6 +27,9 @@ CDlgSelectBase::CDlgSelectBase(QWidget* parent, const QString& title, QAbstractT
   m_TableView->setSelectionBehavior(QAbstractItemView::SelectRows);
   m_TableView->setSortingEnabled(true);
   m_TableView->setSelectionMode(QAbstractItemView::SingleSelection);
+  // Uniform row heights: The view needs no per-row layout.
+  m_TableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  m_TableView->verticalHeader()->setDefaultSectionSize(19);
   if (bgcolor != 0)
   {
     QPalette pal(m_TableView->palette());
@@ -113,14 +117,6 @@ void CDlgSelectBase::resizeColumns()
     m_TableView->resizeColumnToContents(cx);
   }
 }
-void CDlgSelectBase::resizeRows()
-{
-  for (int rx{}; rx < m_TableView->model()->rowCount(); rx++)
-  {
-    m_TableView->setRowHeight(rx, 19);
-  }
-}
-
 void CDlgSelectBase::updateTitle(int numRow, const QString& info)
 {
   if (numRow >= 0)
@@ -6,7 +6,7 @@
 
 /* FORWARD DECLARATIONS *******************************************************/
 class CTableView;
-class QAbstractTableModel;
+class QAbstractItemModel;
 class QBoxLayout;
 class QBoxLayout;
 class QCheckBox;
@@ -29,7 +29,7 @@ protected:
   CTableView* m_TableView;
   unsigned m_ExecPk;
 public:
-  CDlgSelectBase(QWidget* parent, const QString& title, QAbstractTableModel*, unsigned bgcolor = 0);
+  CDlgSelectBase(QWidget* parent, const QString& title, QAbstractItemModel*, unsigned bgcolor = 0);
   QPushButton* addButton(const QString& text, const char* method, const QString& toolTip="");
   QPushButton* addButton(QSignalMapper*, const QString& text, int mapVal, const QString& toolTip="");
   QCheckBox* addCheckBox(QSignalMapper*, const QString& text, int mapVal, const QString& toolTip);
@@ -37,7 +37,6 @@ public:
   CTableView* tableView() const { return m_TableView; }
   QBoxLayout* buttonBoxLayout() const;
   void resizeColumns();
-  void resizeRows();
   void updateTitle(int numRow = -1, const QString& info = "");
   unsigned execPk() const { return m_ExecPk; }
   void virtual onCurrentChanged(const QModelIndex&) {}
@@ -4,19 +4,58 @@
 #include <QKeyEvent>
 #include <QSignalMapper>
 #include <QtCore/QDir>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QSortFilterProxyModel>
+#include <QtCore/QTimer>
 #include <QtWidgets/QCheckBox>
 #include <QtWidgets/QHeaderView>
+#include <QtWidgets/QLineEdit>
+#include "CDlgHtml.h"
 #include "CDlgInput.h"
 #include "CDlgSelectModel.h"
+#include "CModelArchive.h"
 #include "CModelData.h"
+#include "CProfiler.h"
+#include "HtmlOutput.h"
 #include "strutil.h"
 #include "Util.h"
 
 namespace
 {
-	enum { idClose, idCopy, idEdit, idDelete, idFilter, idOk, };
+	enum { idClose, idCopy, idEdit, idDelete, idDuplicates, idFilter, idOk, };
 }
 
+/* CLASS DECLARATION **********************************************************/
+/**
+  Filters and sorts the model list for the view. The list itself stays sorted
+  by pathname, CModelData::refreshLibrary() inserts/removes rows one by one.
+*******************************************************************************/
+class CModelFilterModel : public QSortFilterProxyModel
+{
+public:
+	CModelFilterModel() : QSortFilterProxyModel()
+	{
+		setSourceModel(CModelData::getTableModel());
+		setDynamicSortFilter(true);
+	}
+	void updateFilter() { invalidateFilter(); }
+	void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override
+	{
+		CModelData::sortColumn(column); // Restored by the next dialog
+		QSortFilterProxyModel::sort(column, order);
+	}
+protected:
+	bool filterAcceptsRow(int sourceRow, const QModelIndex&) const override
+	{
+		return CDlgSelectModel::acceptsRow(size_t(sourceRow));
+	}
+	bool lessThan(const QModelIndex& left, const QModelIndex& right) const override
+	{
+		return CModelData::lessThan(left.column(), CModelData::at(size_t(left.row())),
+			CModelData::at(size_t(right.row())));
+	}
+};
+
 /* STATIC INITIALIZATION ******************************************************/
 string   CDlgSelectModel::s_FilterDynamics;
 string   CDlgSelectModel::s_FilterName;
@@ -24,26 +63,52 @@ string   CDlgSelectModel::s_FilterQm;
 string   CDlgSelectModel::s_FilterReactionDiffusion;
 string   CDlgSelectModel::s_FilterStatics;
 string   CDlgSelectModel::s_FilterTag;
+string   CDlgSelectModel::s_Search;
+bool     CDlgSelectModel::s_SearchIsQuery;
+std::unordered_set<string> CDlgSelectModel::s_SearchHits;
 
 /* METHOD *********************************************************************/
 /**
 *******************************************************************************/
 CDlgSelectModel::CDlgSelectModel(QWidget* parent, const string& pathnameToFocus)
-	: CDlgSelectBase(parent, "Kanon: Predefined models", CModelData::getTableModel(), 0xF8FFFF)
+	: CDlgSelectBase(parent, "Kanon: Predefined models", new CModelFilterModel, 0xF8FFFF)
 	, m_UsePathnameToFocus(true)
 	, m_PathnameToEdit()
 	, m_PathnameToFocus(pathnameToFocus)
+	, m_Proxy(static_cast<CModelFilterModel*>(tableView()->model()))
+	, m_RefreshTimer(new QTimer(this))
+	, m_Watcher(new QFileSystemWatcher(QStringList(pathToData().c_str()), this))
+	, m_SearchBox(new QLineEdit(s_Search.c_str(), this))
+	, m_SearchError()
 {
-	CModelData::setTableView(tableView()); // To keep focus during sort
+	m_Proxy->setParent(this);
+	m_SearchBox->setPlaceholderText("Search");
+	m_SearchBox->setClearButtonEnabled(true);
+	m_SearchBox->setToolTip("Normal vector, e.g. \"2, 1; 1, 1\" (coordinates; fields),\n"
+		"critical dimension, e.g. \"4\", \"4 +- 0.1\" or \"3.5 .. 4.5\",\n"
+		"or a part of the name.");
+	buttonBoxLayout()->addWidget(m_SearchBox);
+	connect(m_SearchBox, SIGNAL(textChanged(const QString&)), this, SLOT(onSearch()));
 	QSignalMapper* signMap{new QSignalMapper(this)};
 	addButton(signMap, "&Edit", idEdit, "Edit selected model.");
 	addButton(signMap, "&Delete..", idDelete, "Delete selected model.");
 	addButton(signMap, "&Copy..", idCopy, "Copy selected model");
 	addButton(signMap, "&Filter..", idFilter, "Restrict list by name\nand attributes.");
+	addButton(signMap, "D&uplicates..", idDuplicates, "List models differing only in the\n"
+		"order of terms, fields or coordinates.");
 	connect(signMap, SIGNAL(mapped(int)), this, SLOT(onSignMap(int)));
 	connect(tableView(), SIGNAL(doubleClicked(const QModelIndex&)), this, SLOT(onEdit(const QModelIndex&)));
-	readModelFiles();
-	resizeColumns();
+	// The library stays in memory, only changes of the directory (archive) are applied.
+	refreshModelFiles();
+	m_RefreshTimer->setSingleShot(true);
+	m_RefreshTimer->setInterval(250);
+	connect(m_Watcher, SIGNAL(directoryChanged(const QString&)), m_RefreshTimer, SLOT(start()));
+	connect(m_Watcher, SIGNAL(fileChanged(const QString&)), m_RefreshTimer, SLOT(start()));
+	connect(m_RefreshTimer, SIGNAL(timeout()), this, SLOT(onDirectoryChanged()));
+	if (CModelData::sortColumn() >= 0)
+	{
+		m_TableView->sortByColumn(CModelData::sortColumn(), Qt::AscendingOrder);
+	}
 	applyFilter();
 	//	setWindowIcon(QIcon(":/images/Param32.png"));
 	m_TableView->setColumnWidth(CModelData::colNumCoord, 85);
@@ -59,100 +124,181 @@ CDlgSelectModel::CDlgSelectModel(QWidget* parent, const string& pathnameToFocus)
 
 /* METHOD *********************************************************************/
 /**
+  Loads new and modified model files, removes deleted ones from the list.
+@return true when the list changed
 *******************************************************************************/
-void CDlgSelectModel::readModelFiles()
+bool CDlgSelectModel::refreshModelFiles()
 {
-	CModelData::clear();
-	QDir dir(pathToData().c_str(), "*.kxm");
-	dir.setFilter(QDir::Files);
-	dir.setSorting(QDir::Name);
-	const QFileInfoList fileInfo(dir.entryInfoList());
-	for (int fx{}; fx < fileInfo.size(); ++fx)
+	std::vector<string> errMsgs;
+	const bool changed{CModelData::refreshLibrary(pathToData(), errMsgs)};
+	CModelData::updateWatcher(*m_Watcher, pathToData());
+	for (const auto& errMsg : errMsgs)
 	{
-		const string filename(fileInfo.at(fx).absoluteFilePath().toStdString());
-		CModelData data;
-		try
-		{
-			string errMsg;
-			data.loadData(filename, errMsg);
-			if (!errMsg.empty())
-			{
-				msgBoxCritical(errMsg, this);
-			}
-		}
-		catch (const std::exception& e)
-		{	// Should not be reached anymore. -
-			msgBoxCritical(e.what(), this);
-			continue;
+		msgBoxCritical(errMsg, this);
+	}
+	return changed;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Models of an archive cannot be copied or deleted here (see CModelArchive::pack()).
+@return true if the library is an archive; a message has been shown.
+*******************************************************************************/
+bool CDlgSelectModel::isReadOnly()
+{
+	if (!CModelArchive::isArchive(pathToData()))
+	{
+		return false;
+	}
+	msgBox(this, ("The models are packed into an archive:\n" + pathToData()
+		+ "\nEdit the directory they were packed from.").c_str());
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Slot: Files in the model directory were added, removed or modified, or the
+  archive was replaced (see CModelData::updateWatcher()).
+  Filter, sort order and selection are kept by the proxy model.
+*******************************************************************************/
+void CDlgSelectModel::onDirectoryChanged()
+{
+	if (refreshModelFiles())
+	{
+		if (s_SearchIsQuery)
+		{	// New and modified entries are not yet in the search result.
+			applyFilter();
 		}
-		CModelData& mod(CModelData::at(CModelData::size() - 1));
-		double critDim;
-		if (!mod.determineCritDim(critDim))
+		updateTitle(m_Proxy->rowCount(), filterInfo());
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Slot: Text of the search box changed.
+*******************************************************************************/
+void CDlgSelectModel::onSearch()
+{
+	s_Search = m_SearchBox->text().toStdString();
+	applyFilter();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Looks up s_Search in the signature index of the list.
+  Texts which are no index query are matched against the names (see acceptsRow()).
+*******************************************************************************/
+void CDlgSelectModel::updateSearch()
+{
+	PROFILE_SCOPE("search");
+	s_SearchHits.clear();
+	std::vector<size_t> rows;
+	string errMsg;
+	s_SearchIsQuery = !s_Search.empty() && CModelData::signatureIndex().query(s_Search, rows, errMsg);
+	for (const size_t row : rows)
+	{
+		s_SearchHits.insert(CModelData::at(row).pathname());
+	}
+	m_SearchError = errMsg;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return true if the model passes the filter
+*******************************************************************************/
+bool CDlgSelectModel::accepts(const CModelData& mod)
+{
+	return stringMatchesFilter(s_FilterName, mod.name(), eCaseInsensitive)
+		&& stringMatchesFilter(s_FilterTag, mod.category(), eCaseInsensitive)
+		&& (s_FilterDynamics.empty() || mod.isDynamics())
+		&& (s_FilterQm.empty() || mod.isQuantumFieldTheory())
+		&& (s_FilterReactionDiffusion.empty() || mod.isReactionDiffusion())
+		&& (s_FilterStatics.empty() || mod.isStatics());
+}
+
+/* METHOD *********************************************************************/
+/**
+@param row: Row of the list
+@return true if the model passes the filter and the search
+*******************************************************************************/
+bool CDlgSelectModel::acceptsRow(size_t row)
+{
+	const CModelData& mod(CModelData::at(row));
+	if (s_SearchIsQuery)
+	{
+		if (!s_SearchHits.count(mod.pathname()))
 		{
-			continue;
+			return false;
 		}
-		for (size_t tx{}; tx < mod.modelOrder(); tx++)
-		{	// Attempt terms as interaction until OK.
-			try
-			{
-				if (mod.determineCanonicalDimensions(tx))
-				{
-					mod.determineNormalVector();
-					break;
-				}
-			}
-			catch (...)
-			{	// Ignore
-			}
+	}
+	else if (!s_Search.empty() && !contains(toLower(mod.name()), toLower(s_Search)))
+	{
+		return false;
+	}
+	return accepts(mod);
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Filter description for the title
+*******************************************************************************/
+QString CDlgSelectModel::filterInfo() const
+{
+	QString info(s_FilterName.empty() ? QString() : QString(", Filter: ") + s_FilterName.c_str());
+	if (!s_Search.empty())
+	{
+		info += QString(", Search: ") + s_Search.c_str();
+		if (!m_SearchError.empty())
+		{
+			info += QString(" (") + m_SearchError.c_str() + ")";
 		}
 	}
+	return info;
+}
+
+/* METHOD *********************************************************************/
+/**
+@param index: Index of the view
+@return Model of a row of the view, or nullptr
+*******************************************************************************/
+CModelData* CDlgSelectModel::modelAt(const QModelIndex& index) const
+{
+	const QModelIndex sourceIndex(m_Proxy->mapToSource(index));
+	return sourceIndex.isValid() ? &CModelData::at(size_t(sourceIndex.row())) : nullptr;
 }
 
 /* METHOD *********************************************************************/
 /**
+  Re-filters the list and selects m_PathnameToFocus, if visible.
 *******************************************************************************/
 void CDlgSelectModel::applyFilter()
 {
-	CModelData::updateView();
-	size_t numVisible{};
-	int rowToFocus{-1};
-	CModelData::sort(-1);
-	for (size_t px{}; px < CModelData::size(); px++)
-	{
-		const CModelData& mod(CModelData::at(px));
-		const bool show{
-			stringMatchesFilter(s_FilterName, mod.name(), eCaseInsensitive)
-			&& stringMatchesFilter(s_FilterTag, mod.category(), eCaseInsensitive)
-			&& (s_FilterDynamics.empty() || mod.isDynamics())
-			&& (s_FilterQm.empty() || mod.isQuantumFieldTheory())
-			&& (s_FilterReactionDiffusion.empty() || mod.isReactionDiffusion())
-			&& (s_FilterStatics.empty() || mod.isStatics())
-			};
-		CModelData::setRowHidden(px, !show);
-		if (show)
+	PROFILE_SCOPE("applyFilter");
+	updateSearch();
+	m_Proxy->updateFilter();
+	QModelIndex focus;
+	const size_t ix{CModelData::find(m_PathnameToFocus)};
+	if (!m_PathnameToFocus.empty() && ix < CModelData::size())
+	{	// Select edited model
+		focus = m_Proxy->mapFromSource(CModelData::getTableModel()->index(int(ix), 0));
+		if (focus.isValid())
 		{
-			numVisible++;
-			if (!m_PathnameToFocus.empty() && m_PathnameToFocus == mod.pathname())
-			{	// Select edited model
-				m_PathnameToFocus.clear();
-				rowToFocus = px;
-			}
+			m_PathnameToFocus.clear();
 		}
 	}
 	if (m_UsePathnameToFocus)
 	{
 		m_UsePathnameToFocus = false;
-		if (rowToFocus < 0)
+		if (!focus.isValid())
 		{
-			rowToFocus = 0;
+			focus = m_Proxy->index(0, 0);
 		}
 	}
-	CModelData::updateView();
-	resizeRows();
-	updateTitle(numVisible, s_FilterName.empty() ? QString() : QString(", Filter: ") + s_FilterName.c_str());
-	if (rowToFocus >= 0)
+	updateTitle(m_Proxy->rowCount(), filterInfo());
+	if (focus.isValid())
 	{
-		m_TableView->selectRow(rowToFocus);
+		m_TableView->selectRow(focus.row());
+		m_TableView->scrollTo(focus);
 	}
 }
 
@@ -172,7 +318,7 @@ void CDlgSelectModel::onEdit(const QModelIndex& index)
 	const int row{index.row()};
 	if (row >= 0 && index.isValid())
 	{
-		m_PathnameToEdit = CModelData::at(row).pathname();
+		m_PathnameToEdit = modelAt(index)->pathname();
 		accept();
 	}
 }
@@ -188,12 +334,17 @@ void CDlgSelectModel::onSignMap(int id)
 	case idCopy:
 		if (index.isValid())
 		{
-			const int row{index.row()};
-			const CModelData& modSrc(CModelData::at(row));
-			if (modSrc.pathname().empty())
+			CModelData& modSrc(*modelAt(index));
+			if (modSrc.pathname().empty() || isReadOnly())
 			{
 				return;
 			}
+			string errMsg;
+			if (!modSrc.ensureLoaded(errMsg))
+			{	// List entries are loaded without monomials.
+				msgBoxCritical(errMsg, this);
+				return;
+			}
 			string strFilename;
 			string strName(modSrc.name() + "_Copy");
 			for (;;)
@@ -232,7 +383,7 @@ void CDlgSelectModel::onSignMap(int id)
 							strFilename = extractFilename(strFilename);
 							m_PathnameToFocus = dir.absoluteFilePath(strFilename.c_str()).toStdString();
 							m_UsePathnameToFocus = true;
-							readModelFiles();
+							refreshModelFiles();
 							applyFilter();
 							break;
 						}
@@ -249,8 +400,8 @@ void CDlgSelectModel::onSignMap(int id)
 		if (index.isValid())
 		{
 			const int row{index.row()};
-			const CModelData& mod{CModelData::at(row)};
-			if (mod.pathname().empty())
+			const CModelData& mod{*modelAt(index)};
+			if (mod.pathname().empty() || isReadOnly())
 			{
 				return;
 			}
@@ -261,16 +412,16 @@ void CDlgSelectModel::onSignMap(int id)
 				if (0 == unlink(mod.pathname().c_str()))
 				{
 					int rowFocus{row + 1};
-					if (rowFocus >= int(CModelData::size()))
+					if (rowFocus >= m_Proxy->rowCount())
 					{	// Take predecessor.
 						rowFocus -= 2;
 					}
-					if (size_t(rowFocus) < CModelData::size())
+					if (rowFocus >= 0 && rowFocus < m_Proxy->rowCount())
 					{
 						m_UsePathnameToFocus = true;
-						m_PathnameToFocus = CModelData::at(rowFocus).pathname();
+						m_PathnameToFocus = modelAt(m_Proxy->index(rowFocus, 0))->pathname();
 					}
-					readModelFiles();
+					refreshModelFiles();
 					applyFilter();
 				}
 				else
@@ -289,6 +440,12 @@ void CDlgSelectModel::onSignMap(int id)
 	case idFilter:
 		onFilter();
 		break;
+	case idDuplicates:
+		{
+			CDlgHtml dlg(htmlDuplicateReport().c_str(), this);
+			dlg.exec();
+		}
+		break;
 	case idClose:
 		reject();
 		break;
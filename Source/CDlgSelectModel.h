@@ -1,10 +1,18 @@
 #ifndef CDLGSELECTMODEL_H
 #define CDLGSELECTMODEL_H
 
+#include <string>
+#include <unordered_set>
+#include <vector>
 #include "CDlgSelectBase.h"
 
 /* FORWARD DECLARATIONS *******************************************************/
+class CModelData;
+class CModelFilterModel;
+class QLineEdit;
+class QFileSystemWatcher;
 class QModelIndex;
+class QTimer;
 
 /* CONSTANT DECLARATIONS ******************************************************/
 /* CLASS DECLARATIONS *********************************************************/
@@ -23,14 +31,28 @@ private:
 	static std::string s_FilterReactionDiffusion;
 	static std::string s_FilterStatics;
 	static std::string s_FilterTag;
+	static std::string s_Search;            // Text of the search box
+	static bool s_SearchIsQuery;            // s_Search is an index query
+	static std::unordered_set<std::string> s_SearchHits; // Pathnames found: rows move on refreshes
 	std::string m_PathnameToEdit;
 	std::string m_PathnameToFocus;
+	CModelFilterModel* m_Proxy;       // Filter and sort order of the view
+	QTimer* m_RefreshTimer;           // Collects directory change notifications
+	QFileSystemWatcher* m_Watcher;    // Of the directory and files, or the archive (see pathToData())
+	QLineEdit* m_SearchBox;
+	std::string m_SearchError;        // Invalid index query
 	 
 	void applyFilter();
+	QString filterInfo() const;
+	CModelData* modelAt(const QModelIndex&) const;
 	void onFilter();
-	void readModelFiles();
+	bool isReadOnly();
+	bool refreshModelFiles();
+	void updateSearch();
 public:
 	CDlgSelectModel(QWidget* parent, const std::string& pathnameToFocus);
+	static bool accepts(const CModelData&);
+	static bool acceptsRow(size_t row);
 	std::string pathnameSelected() const { return m_PathnameToEdit; }
 	QSize sizeHint() const override;
 	void keyPressEvent(QKeyEvent*) override;
@@ -38,6 +60,8 @@ public:
 private slots:
 	void onSignMap(int);
 	void onEdit(const QModelIndex&);
+	void onDirectoryChanged();
+	void onSearch();
 };
 
 #endif
@@ -0,0 +1,178 @@
+/******************************************************************************/
+/**
+@file         CEditHistory.cpp
+@copyright
+*
+@description  Undo/redo history of the edited model.
+*******************************************************************************/
+#include "CEditHistory.h"
+#include "CModelData.h"
+#include "CProfiler.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+	/* FUNCTION *******************************************************************/
+	/**
+	@return Key identifying a term: its glyphs and its comment
+	*******************************************************************************/
+	string termKey(const CFormula& term)
+	{
+		return term.paintKey(model()) + '\0' + term.comment();
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Ctor
+*******************************************************************************/
+CEditHistory::CEditHistory()
+	: m_States()
+	, m_Current()
+	, m_Index()
+{
+}
+
+/* METHOD *********************************************************************/
+/**
+  Removes all states (a model has been loaded or closed).
+*******************************************************************************/
+void CEditHistory::clear()
+{
+	m_States.clear();
+	m_Current = 0;
+	m_Index.clear();
+}
+
+/* METHOD *********************************************************************/
+/**
+@return The term of the current state equal to term, or a new one
+*******************************************************************************/
+CEditHistory::TTerm CEditHistory::share(const CFormula& term) const
+{
+	const string key(termKey(term));
+	const auto it = m_Index.find(key);
+	if (it != m_Index.end())
+	{
+		return it->second;
+	}
+	PROFILE_COUNT("undoTermsCopied", 1);
+	std::shared_ptr<STerm> ret(std::make_shared<STerm>());
+	ret->formula = term;
+	ret->formula.setFocus(false);
+	ret->key = key;
+	return ret;
+}
+
+/* FUNCTION *******************************************************************/
+/**
+@return Key comparing coordinates and fields of states
+*******************************************************************************/
+string CEditHistory::coordsFieldsKey(const vector<CGlyphCoordField>& coords,
+	const vector<CGlyphCoordField>& fields)
+{
+	string ret;
+	for (const auto* glyphs : {&coords, &fields})
+	{
+		for (const auto& glyph : *glyphs)
+		{
+			glyph.appendPaintKey(ret, model());
+			ret += '\0' + glyph.comment() + '\0';
+		}
+		ret += '|';
+	}
+	return ret;
+}
+
+/* FUNCTION *******************************************************************/
+/**
+@return true if the states differ at most in the interaction and evaluation
+*******************************************************************************/
+bool CEditHistory::sameContent(const SState& x, const SState& y)
+{
+	return x.terms == y.terms && x.coordsFieldsKey == y.coordsFieldsKey;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Makes state the current one, following the current state; states which
+  could be redone are dropped. If the content (terms, coordinates and
+  fields) is unchanged, only the interaction and evaluation of the current
+  state are updated instead.
+@param state: Terms obtained by share(); moved from
+@return true if a state has been added
+*******************************************************************************/
+bool CEditHistory::record(SState& state)
+{
+	if (!m_States.empty() && sameContent(m_States[m_Current], state))
+	{
+		SState& current(m_States[m_Current]);
+		current.rxInteraction = state.rxInteraction;
+		current.rxInteractionSingular = state.rxInteractionSingular;
+		current.isCritical = state.isCritical;
+		current.critDim = state.critDim;
+		current.rank = state.rank;
+		current.evaluation = std::move(state.evaluation);
+		return false;
+	}
+	if (!m_States.empty())
+	{
+		m_States.erase(m_States.begin() + m_Current + 1, m_States.end());
+	}
+	m_States.push_back(std::move(state));
+	while (m_States.size() > MaxStates)
+	{
+		m_States.pop_front();
+	}
+	m_Current = m_States.size() - 1;
+	reindex();
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Indexes the terms of the current state (see share()).
+*******************************************************************************/
+void CEditHistory::reindex()
+{
+	m_Index.clear();
+	if (!m_States.empty())
+	{
+		for (const auto& term : m_States[m_Current].terms)
+		{
+			m_Index.emplace(term->key, term);
+		}
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+@return State to restore, nullptr if none
+*******************************************************************************/
+const CEditHistory::SState* CEditHistory::undo()
+{
+	if (!canUndo())
+	{
+		return nullptr;
+	}
+	m_Current--;
+	reindex();
+	return &m_States[m_Current];
+}
+
+/* METHOD *********************************************************************/
+/**
+@return State to restore, nullptr if none
+*******************************************************************************/
+const CEditHistory::SState* CEditHistory::redo()
+{
+	if (!canRedo())
+	{
+		return nullptr;
+	}
+	m_Current++;
+	reindex();
+	return &m_States[m_Current];
+}
@@ -0,0 +1,72 @@
+/******************************************************************************/
+/**
+@file         CEditHistory.h
+@copyright
+*
+@description  Undo/redo history of the edited model.
+*******************************************************************************/
+#ifndef CEDITHISTORY_H
+#define CEDITHISTORY_H
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CFormula.h"
+#include "CGlyph.h"
+#include "CNumerics.h"
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Snapshots of the edited model, one per edit (see CGuiMatrix::recordEdit()).
+  Terms are immutable and shared: a snapshot holds one pointer per term, only
+  changed terms are copied (share()). Each snapshot keeps the evaluation of its
+  state, so undo/redo display the critical dimension without solving again.
+  A new edit drops the states which could be redone; the oldest states are
+  dropped beyond MaxStates.
+*******************************************************************************/
+class CEditHistory
+{
+public:
+	struct STerm
+	{
+		CFormula formula;
+		std::string key;                 // Paint key and comment, identifies equal terms
+	};
+	typedef std::shared_ptr<const STerm> TTerm;
+	struct SState
+	{
+		std::vector<TTerm> terms;
+		std::vector<CGlyphCoordField> coords;
+		std::vector<CGlyphCoordField> fields;
+		std::string coordsFieldsKey;     // Paint keys and comments of coords and fields
+		int rxInteraction;
+		bool rxInteractionSingular;
+		bool isCritical;                 // As displayed, see CWndMain::displayCritDim()
+		double critDim;
+		int rank;
+		SEvaluation evaluation;          // See CModelData::evaluation()
+	};
+	enum { MaxStates = 200 };
+private:
+	std::deque<SState> m_States;         // Oldest first
+	size_t m_Current;                    // Index of the state shown
+	std::unordered_map<std::string, TTerm> m_Index; // Terms of the current state by key
+	void reindex();
+	static bool sameContent(const SState&, const SState&);
+public:
+	CEditHistory();
+	void clear();
+	TTerm share(const CFormula& term) const;
+	static std::string coordsFieldsKey(const std::vector<CGlyphCoordField>& coords,
+		const std::vector<CGlyphCoordField>& fields);
+	bool record(SState& state);
+	const SState* current() const { return m_States.empty() ? nullptr : &m_States[m_Current]; }
+	bool canUndo() const { return m_Current > 0; }
+	bool canRedo() const { return m_Current + 1 < m_States.size(); }
+	const SState* undo();
+	const SState* redo();
+};
+
+#endif
@@ -0,0 +1,322 @@
+/******************************************************************************/
+/**
+@file         CExpMatrix.cpp
+@copyright
+*
+@description  Compact exponent matrix of a model, independent of Qt.
+*******************************************************************************/
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include "CExpMatrix.h"
+#include "strutil.h"
+
+using std::vector;
+
+namespace
+{
+	// Bound for the number of column orders tried (ties of column signatures).
+	const size_t MaxColumnOrders{40320};
+	// Combines exponent and coefficient of sigma into one value (canonicalHash(sigmaExps))
+	const int SigmaRadix{256};
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Finalizer of splitmix64.
+	*******************************************************************************/
+	uint64_t mix64(uint64_t x)
+	{
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		x ^= x >> 31;
+		return x;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Sorts the terms [begin, end) (expD first, then the columns in the given order).
+	@return Rows, flattened
+	*******************************************************************************/
+	void sortedRows(const CExpMatrix& m, const vector<size_t>& columns, size_t begin, size_t end,
+		vector<int>& dest)
+	{
+		const size_t width{1 + columns.size()};
+		vector<vector<int>> rows(end - begin, vector<int>(width));
+		for (size_t tx{begin}; tx < end; tx++)
+		{
+			vector<int>& row(rows[tx - begin]);
+			row[0] = m.getExpD(tx);
+			for (size_t cx{}; cx < columns.size(); cx++)
+			{
+				row[1 + cx] = m.getExp(tx, columns[cx]);
+			}
+		}
+		std::sort(rows.begin(), rows.end());
+		for (const auto& row : rows)
+		{
+			dest.insert(dest.end(), row.begin(), row.end());
+		}
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Hex digits
+*******************************************************************************/
+std::string SHash128::toString() const
+{
+	return ::toString("%016llx%016llx", (unsigned long long)hi, (unsigned long long)lo);
+}
+
+/* METHOD *********************************************************************/
+/**
+  Columns are grouped (d-dimensional coordinate, other coordinates, fields) and
+  ordered within the groups by their sorted values. Orders of columns with equal
+  values are all tried, for each order the terms are sorted; the lexicographically
+  smallest result is the canonical form.
+  Beyond MaxColumnOrders ties are not resolved: equivalent models then might
+  get different forms (never equal forms for non equivalent models).
+@return Matrix with permuted terms and columns
+*******************************************************************************/
+CExpMatrix CExpMatrix::canonical() const
+{
+	const size_t numNormal{std::min(numTerm(), order())};
+	struct SColumn
+	{
+		int group;
+		vector<int> values; // Sorted
+		size_t cx;
+		bool operator<(const SColumn& rhs) const
+		{
+			return group != rhs.group ? group < rhs.group : values < rhs.values;
+		}
+		bool tied(const SColumn& rhs) const { return group == rhs.group && values == rhs.values; }
+	};
+	vector<SColumn> cols(order());
+	for (size_t cx{}; cx < order(); cx++)
+	{
+		SColumn& col(cols[cx]);
+		col.group = cx == 0 ? 0 : cx < m_NumCoord ? 1 : 2;
+		col.cx = cx;
+		for (size_t tx{}; tx < numTerm(); tx++)
+		{	// Normal and extra terms separated
+			col.values.push_back(getExp(tx, cx) * 2 + (tx < numNormal ? 0 : 1));
+		}
+		std::sort(col.values.begin(), col.values.end());
+	}
+	std::stable_sort(cols.begin(), cols.end());
+	// Ranges of tied columns
+	vector<std::pair<size_t, size_t>> ties;
+	size_t numOrders{1};
+	for (size_t cx{}; cx < cols.size();)
+	{
+		size_t end{cx + 1};
+		while (end < cols.size() && cols[cx].tied(cols[end]))
+		{
+			numOrders *= end - cx + 1;
+			++end;
+		}
+		if (end - cx > 1)
+		{
+			ties.push_back({cx, end});
+		}
+		cx = end;
+		numOrders = std::min(numOrders, MaxColumnOrders + 1);
+	}
+	vector<size_t> columns(cols.size());
+	for (size_t cx{}; cx < cols.size(); cx++)
+	{
+		columns[cx] = cols[cx].cx;
+	}
+	if (numOrders > MaxColumnOrders)
+	{
+		ties.clear();
+	}
+	for (const auto& tie : ties)
+	{
+		std::sort(columns.begin() + tie.first, columns.begin() + tie.second);
+	}
+	vector<int> best;
+	vector<size_t> bestColumns(columns);
+	for (;;)
+	{
+		vector<int> rows;
+		sortedRows(*this, columns, 0, numNormal, rows);
+		sortedRows(*this, columns, numNormal, numTerm(), rows);
+		if (best.empty() || rows < best)
+		{
+			best.swap(rows);
+			bestColumns = columns;
+		}
+		// Next combination of permutations of the tied ranges (odometer)
+		size_t ix{};
+		for (; ix < ties.size(); ix++)
+		{
+			const auto begin(columns.begin() + ties[ix].first);
+			const auto end(columns.begin() + ties[ix].second);
+			if (std::next_permutation(begin, end))
+			{
+				break;
+			}	// Wrapped around to sorted order, continue with next range.
+		}
+		if (ix == ties.size())
+		{
+			break;
+		}
+	}
+	CExpMatrix result(m_NumCoord, m_NumField);
+	const size_t width{1 + order()};
+	vector<int> exp(order());
+	for (size_t tx{}; tx < numTerm(); tx++)
+	{
+		const int* row{&best[tx * width]};
+		exp.assign(row + 1, row + width);
+		result.addTerm(exp, row[0]);
+	}
+	return result;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Hash of the canonical form; equal for models differing only in the
+  order of terms, fields or coordinates.
+*******************************************************************************/
+SHash128 CExpMatrix::canonicalHash() const
+{
+	const CExpMatrix form(canonical());
+	SHash128 h{0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL};
+	auto add = [&h](uint64_t val)
+	{
+		h.hi = mix64(h.hi ^ val);
+		h.lo = mix64(h.lo + val * 0x9e3779b97f4a7c15ULL);
+	};
+	add(form.m_NumCoord);
+	add(form.m_NumField);
+	add(form.numTerm());
+	for (const int expD : form.m_ExpD)
+	{
+		add(uint32_t(expD));
+	}
+	for (const int exp : form.m_Exp)
+	{
+		add(uint32_t(exp));
+	}
+	return h;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Like canonicalHash(), but models differing in the coefficients of sigma are
+  not equal: exponent and coefficient of each term and column are combined
+  into one value, which is permuted with the term and the column.
+@param sigmaExps: Coefficients of sigma in the exponents (see CSigmaSweep)
+@return canonicalHash() if all coefficients are 0
+*******************************************************************************/
+SHash128 CExpMatrix::canonicalHash(const CExpMatrix& sigmaExps) const
+{
+	if (sigmaExps.numTerm() != numTerm() || sigmaExps.order() != order()
+		|| std::all_of(sigmaExps.m_Exp.begin(), sigmaExps.m_Exp.end(), [](int exp) { return exp == 0; }))
+	{
+		return canonicalHash();
+	}
+	CExpMatrix combined(*this);
+	for (size_t ix{}; ix < m_Exp.size(); ix++)
+	{
+		combined.m_Exp[ix] = m_Exp[ix] * SigmaRadix + sigmaExps.m_Exp[ix];
+	}
+	SHash128 h(combined.canonicalHash());
+	h.hi = mix64(h.hi ^ SigmaRadix);
+	return h;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Writes a text block, read by read():
+  model <name>
+  coords <numCoord> fields <numField>
+  <expD> <exponents of coordinates and fields>   (one line per term)
+  end
+*******************************************************************************/
+void CExpMatrix::write(std::ostream& os, const std::string& name) const
+{
+	os << "model " << name << "\n";
+	os << "coords " << m_NumCoord << " fields " << m_NumField << "\n";
+	for (size_t tx{}; tx < numTerm(); tx++)
+	{
+		os << getExpD(tx);
+		for (size_t cx{}; cx < order(); cx++)
+		{
+			os << ' ' << getExp(tx, cx);
+		}
+		os << "\n";
+	}
+	os << "end\n";
+}
+
+/* METHOD *********************************************************************/
+/**
+  Reads the next block written by write(), skips empty lines and comments (#).
+@param   name: [out] Model name
+@param errMsg: [out] Set if the input is malformed
+@return false at the end of the input or on errors
+*******************************************************************************/
+bool CExpMatrix::read(std::istream& is, std::string& name, std::string& errMsg)
+{
+	errMsg.clear();
+	std::string line;
+	bool header{};
+	while (std::getline(is, line))
+	{
+		line = trimWhite(line);
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+		std::istringstream ls(line);
+		if (!header)
+		{
+			std::string word, word2;
+			if (line.compare(0, 6, "model ") != 0 && line != "model")
+			{
+				errMsg = "'model' expected: " + line;
+				return false;
+			}
+			name = trimWhite(line.substr(5));
+			size_t numCoord{}, numField{};
+			if (!std::getline(is, line) || !(std::istringstream(line) >> word >> numCoord >> word2 >> numField)
+				|| word != "coords" || word2 != "fields" || numCoord == 0)
+			{
+				errMsg = "'coords <n> fields <n>' expected: " + name;
+				return false;
+			}
+			clear(numCoord, numField);
+			header = true;
+			continue;
+		}
+		if (line == "end")
+		{
+			return true;
+		}
+		int expD{};
+		vector<int> exp(order());
+		ls >> expD;
+		for (size_t cx{}; cx < exp.size() && ls; cx++)
+		{
+			ls >> exp[cx];
+		}
+		if (!ls)
+		{
+			errMsg = "Invalid term in " + name + ": " + line;
+			return false;
+		}
+		addTerm(exp, expD);
+	}
+	if (header)
+	{
+		errMsg = "'end' missing: " + name;
+	}
+	return false;
+}
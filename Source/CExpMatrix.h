@@ -0,0 +1,89 @@
+/******************************************************************************/
+/**
+@file         CExpMatrix.h
+@copyright
+*
+@description  Compact exponent matrix of a model, independent of Qt.
+*******************************************************************************/
+#ifndef CEXPMATRIX_H
+#define CEXPMATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  128 bit hash (see CExpMatrix::canonicalHash()).
+*******************************************************************************/
+struct SHash128
+{
+	uint64_t hi;
+	uint64_t lo;
+	bool operator==(const SHash128& rhs) const { return hi == rhs.hi && lo == rhs.lo; }
+	bool operator!=(const SHash128& rhs) const { return !(*this == rhs); }
+	bool operator<(const SHash128& rhs) const { return hi < rhs.hi || (hi == rhs.hi && lo < rhs.lo); }
+	std::string toString() const;
+	struct Hasher
+	{	// For unordered containers
+		size_t operator()(const SHash128& h) const { return size_t(h.lo); }
+	};
+};
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Exponents of the coordinates and fields of all terms (row major), plus the
+  coefficient of the contribution proportional to d (see CFormula::getExpD()).
+  Column 0 is the d-dimensional coordinate, followed by the other coordinates,
+  then the fields.
+  Models differing only by the order of terms, fields or coordinates (other
+  than the d-dimensional one) have the same canonical() form. The first
+  order() terms and the extra terms are permuted separately (the first ones
+  determine the canonical dimensions).
+*******************************************************************************/
+class CExpMatrix
+{
+	size_t m_NumCoord;
+	size_t m_NumField;
+	std::vector<int> m_Exp;  // numTerm() x order()
+	std::vector<int> m_ExpD; // One value per term
+public:
+	CExpMatrix(size_t numCoord = 0, size_t numField = 0)
+		: m_NumCoord(numCoord), m_NumField(numField), m_Exp(), m_ExpD() {}
+	void clear(size_t numCoord, size_t numField)
+	{
+		m_NumCoord = numCoord;
+		m_NumField = numField;
+		m_Exp.clear();
+		m_ExpD.clear();
+	}
+	void addTerm(const std::vector<int>& exp, int expD)
+	{
+		m_Exp.insert(m_Exp.end(), exp.begin(), exp.begin() + order());
+		m_ExpD.push_back(expD);
+	}
+	bool empty() const { return m_ExpD.empty(); }
+	size_t numCoord() const { return m_NumCoord; }
+	size_t numField() const { return m_NumField; }
+	size_t order() const { return m_NumCoord + m_NumField; }
+	size_t numTerm() const { return m_ExpD.size(); }
+	int getExp(size_t tx, size_t cx) const { return m_Exp[tx * order() + cx]; }
+	int getExpD(size_t tx) const { return m_ExpD[tx]; }
+	const int* row(size_t tx) const { return &m_Exp[tx * order()]; }
+	const std::vector<int>& exps() const { return m_Exp; }
+	const std::vector<int>& expsD() const { return m_ExpD; }
+	bool operator==(const CExpMatrix& rhs) const
+	{
+		return m_NumCoord == rhs.m_NumCoord && m_NumField == rhs.m_NumField
+			&& m_Exp == rhs.m_Exp && m_ExpD == rhs.m_ExpD;
+	}
+	CExpMatrix canonical() const;
+	SHash128 canonicalHash() const;
+	SHash128 canonicalHash(const CExpMatrix& sigmaExps) const;
+	void write(std::ostream&, const std::string& name) const;
+	bool read(std::istream&, std::string& name, std::string& errMsg);
+};
+
+#endif
@@ -0,0 +1,176 @@
+/******************************************************************************/
+/**
+@file         CFactorCache.cpp
+@copyright
+*
+@description  Content addressed cache of determinants, ranks and LU factors.
+*******************************************************************************/
+#include "CFactorCache.h"
+#include "CLuFactor.h"
+#include "CProfiler.h"
+#include "CSparseLu.h"
+
+using std::vector;
+
+/* METHOD *********************************************************************/
+/**
+  Ctor
+*******************************************************************************/
+CFactorCache::CFactorCache()
+	: m_Mutex()
+	, m_Nodes()
+	, m_Index()
+	, m_Capacity{DefaultCapacity}
+	, m_Bytes()
+	, m_Stats()
+{
+}
+
+/* FUNCTION *******************************************************************/
+/**
+@return Singleton instance
+*******************************************************************************/
+CFactorCache& CFactorCache::instance()
+{
+	static CFactorCache s_Cache;
+	return s_Cache;
+}
+
+/* FUNCTION *******************************************************************/
+/**
+@return FNV-1a hash of the key
+*******************************************************************************/
+uint64_t CFactorCache::hash(const vector<int>& key)
+{
+	uint64_t ret{14695981039346656037ULL};
+	for (const int val : key)
+	{
+		uint32_t bits{uint32_t(val)};
+		for (int bx{}; bx < 4; bx++, bits >>= 8)
+		{
+			ret ^= bits & 0xFF;
+			ret *= 1099511628211ULL;
+		}
+	}
+	return ret;
+}
+
+/* METHOD *********************************************************************/
+/**
+@param   key: Contents determining the entry
+@param entry: [out] Copy of the entry if found
+@return true if found; the entry becomes the most recently used one.
+*******************************************************************************/
+bool CFactorCache::find(const vector<int>& key, SEntry& entry)
+{
+	const uint64_t h{hash(key)};
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const auto it = m_Index.find(h);
+	if (it == m_Index.end() || it->second->key != key)
+	{
+		m_Stats.misses++;
+		PROFILE_COUNT("factorCacheMisses", 1);
+		return false;
+	}
+	m_Nodes.splice(m_Nodes.begin(), m_Nodes, it->second);
+	entry = it->second->entry;
+	m_Stats.hits++;
+	PROFILE_COUNT("factorCacheHits", 1);
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Adds or replaces the entry of key (also one of a colliding key).
+*******************************************************************************/
+void CFactorCache::insert(const vector<int>& key, const SEntry& entry)
+{
+	const uint64_t h{hash(key)};
+	const size_t size{bytes(key, entry)};
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const auto it = m_Index.find(h);
+	if (it != m_Index.end())
+	{
+		m_Bytes -= it->second->bytes;
+		m_Nodes.erase(it->second);
+		m_Index.erase(it);
+	}
+	m_Nodes.push_front(SNode{key, entry, size});
+	m_Index[h] = m_Nodes.begin();
+	m_Bytes += size;
+	evict();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Drops least recently used entries until the capacity is met.
+@precondition m_Mutex locked
+*******************************************************************************/
+void CFactorCache::evict()
+{
+	while (m_Bytes > m_Capacity && !m_Nodes.empty())
+	{
+		const SNode& node(m_Nodes.back());
+		m_Bytes -= node.bytes;
+		m_Index.erase(hash(node.key));
+		m_Nodes.pop_back();
+		m_Stats.evictions++;
+		PROFILE_COUNT("factorCacheEvictions", 1);
+	}
+}
+
+/* FUNCTION *******************************************************************/
+/**
+@return Approximate memory of an entry
+*******************************************************************************/
+size_t CFactorCache::bytes(const vector<int>& key, const SEntry& entry)
+{
+	size_t ret{sizeof(SNode) + key.size() * sizeof(int)};
+	if (entry.lu)
+	{
+		ret += entry.lu->size() * (entry.lu->size() * sizeof(double) + sizeof(size_t));
+	}
+	if (entry.sparseLu)
+	{
+		ret += entry.sparseLu->numNonZero() * (sizeof(double) + sizeof(size_t))
+			+ entry.sparseLu->size() * 4 * sizeof(size_t);
+	}
+	return ret;
+}
+
+/* METHOD *********************************************************************/
+/**
+@param bytes: Approximate memory limit, 0 disables the cache
+*******************************************************************************/
+void CFactorCache::setCapacity(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Capacity = bytes;
+	evict();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Removes all entries, resets the statistics.
+*******************************************************************************/
+void CFactorCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Nodes.clear();
+	m_Index.clear();
+	m_Bytes = 0;
+	m_Stats = SStats();
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Statistics since the last clear()
+*******************************************************************************/
+CFactorCache::SStats CFactorCache::stats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	SStats ret(m_Stats);
+	ret.numEntry = m_Nodes.size();
+	ret.bytes = m_Bytes;
+	return ret;
+}
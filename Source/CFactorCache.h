@@ -0,0 +1,83 @@
+/******************************************************************************/
+/**
+@file         CFactorCache.h
+@copyright
+*
+@description  Content addressed cache of determinants, ranks and LU factors.
+*******************************************************************************/
+#ifndef CFACTORCACHE_H
+#define CFACTORCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/* FORWARD DECLARATIONS *******************************************************/
+class CLuFactor;
+class CSparseLu;
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Singleton, least recently used entries are dropped when the total size
+  exceeds the capacity. Keys are the integer contents determining a result
+  (see CNumerics.cpp), addressed by their hash and compared in full.
+  Factors are shared and immutable: a found entry stays valid after it has
+  been dropped. All methods are thread safe.
+  Hits, misses and evictions are counted (PROFILE_COUNT and stats()).
+  Independent of Qt.
+*******************************************************************************/
+class CFactorCache
+{
+public:
+	struct SEntry
+	{
+		double det0;                              // Determinants, see CNumerics::determineCritDim()
+		double det1;
+		double rcond1;                            // Reciprocal condition of the matrix of det1, -1: not estimated
+		bool haveDets;
+		int rank;                                 // -1: not determined
+		std::shared_ptr<const CLuFactor> lu;      // Of E1, see CNumerics::determineCanonicalDimensions()
+		std::shared_ptr<const CSparseLu> sparseLu;
+		SEntry() : det0(), det1(), rcond1(-1.0), haveDets(), rank(-1), lu(), sparseLu() {}
+	};
+	struct SStats
+	{
+		long long hits;
+		long long misses;
+		long long evictions;
+		size_t numEntry;
+		size_t bytes;
+	};
+private:
+	struct SNode
+	{
+		std::vector<int> key;
+		SEntry entry;
+		size_t bytes;
+	};
+	typedef std::list<SNode> TNodes;
+	mutable std::mutex m_Mutex;
+	TNodes m_Nodes;                                       // Most recently used first
+	std::unordered_map<uint64_t, TNodes::iterator> m_Index; // By hash of the key
+	size_t m_Capacity;                                    // Bytes
+	size_t m_Bytes;
+	SStats m_Stats;
+	CFactorCache();
+	void evict();
+	static size_t bytes(const std::vector<int>& key, const SEntry&);
+public:
+	enum { DefaultCapacity = 64 << 20 };
+	static CFactorCache& instance();
+	static uint64_t hash(const std::vector<int>& key);
+	bool find(const std::vector<int>& key, SEntry& entry);
+	void insert(const std::vector<int>& key, const SEntry& entry);
+	void setCapacity(size_t bytes);
+	void clear();
+	SStats stats() const;
+};
+
+#endif
@@ -11,6 +11,18 @@ using std::string;
 namespace
 {
 	const double TINY{1e-6f};
+	const size_t BufSize{96}; // Enough for bilinear()
+	const char EpsilonUtf8[]{char(0xC0 | (epsilon >> 6)), char(0x80 | (epsilon & 0x3F)), 0};
+
+	// Appends text to the zero terminated buf of length len, truncates at size - 1.
+	void append(char* buf, size_t size, size_t& len, const char* text)
+	{
+		for (; *text && len + 1 < size; len++)
+		{
+			buf[len] = *text++;
+		}
+		buf[len] = 0;
+	}
 }
 
 /* METHOD *********************************************************************/
@@ -25,8 +37,7 @@ void CFormatFloat::simplify(double val)
 	{
 		val = 0.0;  // Rounding error
 	}
-	sprintf(m_Buf, m_Format.c_str(), val);
-	size_t len1{strlen(m_Buf)};
+	size_t len1{toChars(m_Buf, sizeof(m_Buf), val, m_Format)};
 	for (; len1 > 0;)
 	{
 		const int ch{m_Buf[len1 - 1]};
@@ -62,71 +73,101 @@ const char* CFormatFloat::get(double val)
 /**
   Creates string representation of factor*<epsilon>, omitting a factor of
 absolute value 1.
+@param     buf: [out] UTF-8, zero terminated
+@param    size: Of buf
 @param  factor: The factor
 @param   unary: Only display negative sign, with no spaces.
-@return expression as QString
+@return Length of the expression
 *******************************************************************************/
-QString CFormatFloat::epsilonFactor(double factor, bool unary, EFormat format)
+size_t CFormatFloat::epsilonFactor(char* buf, size_t size, double factor, bool unary, EFormat format)
 {
 	const bool asHtml(format == eFormatHtml);
-	QString ret;
+	size_t len{};
 	const double absFact(fabs(factor));
 	if (absFact < TINY)
 	{
-		return unary ? "0" : "";
+		append(buf, size, len, unary ? "0" : "");
+		return len;
 	}
-	else if (fabs(absFact -1.0) < TINY)
-	{	// Omit factor 1
-		ret = asHtml ? QString("&epsilon;") : QString(QChar(epsilon));
+	if (unary)
+	{
+		append(buf, size, len, factor < 0.0 ? "-" : "");
 	}
 	else
 	{
-		CFormatFloat flt("%2.3f");
-		flt.simplify(absFact);
-		ret = QString(flt.get(absFact));
-		if (asHtml)
-		{
-			ret += " &times; &epsilon;";
-		}
-		else
-		{
-			ret += " * " + QString(QChar(epsilon));
-		}
+		append(buf, size, len, factor < 0.0 ? " - " : " + ");
 	}
-	if (unary)
-	{
-		if (factor < 0.0)
-		{
-			ret = "-" + ret;
-		}
+	if (fabs(absFact -1.0) < TINY)
+	{	// Omit factor 1
+		append(buf, size, len, asHtml ? "&epsilon;" : EpsilonUtf8);
 	}
 	else
 	{
-		ret = (factor < 0.0 ? " - " : " + ") + ret;
+		CFormatFloat flt;
+		append(buf, size, len, flt.get(absFact));
+		append(buf, size, len, asHtml ? " &times; &epsilon;" : " * ");
+		append(buf, size, len, asHtml ? "" : EpsilonUtf8);
 	}
-	return ret;
+	return len;
 }
 
 /* METHOD *********************************************************************/
 /**
   Creates string representation of cst + factor*<epsilon>, omits cst of value
 0.0 and omits factor of absolute value 1.0.
+@param      buf: [out] UTF-8, zero terminated
+@param     size: Of buf
 @param constVal: Constant
 @param   factor: Factor for epsilon
-@return expression
+@return Length of the expression
 *******************************************************************************/
-QString CFormatFloat::bilinear(double constVal, double factor, EFormat format)
+size_t CFormatFloat::bilinear(char* buf, size_t size, double constVal, double factor, EFormat format)
 {
 	if (fabs(constVal) < TINY)
 	{
-		return epsilonFactor(factor, true, format);
+		return epsilonFactor(buf, size, factor, true, format);
 	}
-	CFormatFloat flt("%2.3f");
-	flt.simplify(constVal);
-	if (fabs(factor) < TINY)
+	CFormatFloat flt;
+	size_t len{};
+	append(buf, size, len, flt.get(constVal));
+	if (fabs(factor) >= TINY)
 	{
-		return flt.get(constVal);
+		len += epsilonFactor(buf + len, size - len, factor, false, format);
 	}
-	return flt.get(constVal) + epsilonFactor(factor, false, format);
+	return len;
 }
 
+/* METHOD *********************************************************************/
+/**
+  As epsilonFactor() above.
+@return expression as QString
+*******************************************************************************/
+QString CFormatFloat::epsilonFactor(double factor, bool unary, EFormat format)
+{
+	char buf[BufSize];
+	const size_t len{epsilonFactor(buf, sizeof(buf), factor, unary, format)};
+	return QString::fromUtf8(buf, int(len));
+}
+
+/* METHOD *********************************************************************/
+/**
+  As bilinear() above.
+@return expression
+*******************************************************************************/
+QString CFormatFloat::bilinear(double constVal, double factor, EFormat format)
+{
+	char buf[BufSize];
+	const size_t len{bilinear(buf, sizeof(buf), constVal, factor, format)};
+	return QString::fromUtf8(buf, int(len));
+}
+
+/* METHOD *********************************************************************/
+/**
+  As bilinear() above, HTML format, without detour via QString.
+*******************************************************************************/
+std::string CFormatFloat::bilinearHtml(double constVal, double factor)
+{
+	char buf[BufSize];
+	const size_t len{bilinear(buf, sizeof(buf), constVal, factor, eFormatHtml)};
+	return std::string(buf, len);
+}
@@ -2,6 +2,7 @@
 #define FORMATFLOAT_H
 
 #include <string>
+#include "strutil.h"
 
 class QString;
 
@@ -16,14 +17,17 @@ enum EFormat
 class CFormatFloat
 {
 	size_t m_Len;
-	char m_Buf[128];
-	std::string m_Format;
+	char m_Buf[64];
+	SFixedFormat m_Format;
 public:
-	CFormatFloat(const std::string& format = " % 2.3f") : m_Len(), m_Format(format) {}
+	CFormatFloat(SFixedFormat format = Fixed3) : m_Len(), m_Format(format) {}
 	void simplify(double);
 	const char* get(double);
+	static size_t epsilonFactor(char* buf, size_t size, double factor, bool unary = true, EFormat format = eFormatText);
+	static size_t bilinear(char* buf, size_t size, double cst, double factor, EFormat format = eFormatText);
 	static QString epsilonFactor(double factor, bool unary = true, EFormat format = eFormatText);
 	static QString bilinear(double cst, double factor, EFormat format = eFormatText);
+	static std::string bilinearHtml(double cst, double factor);
 };
 
 #endif
@@ -5,10 +5,12 @@
 #include "CFormula.h"
 #include "CGlyph.h"
 #include "CModelData.h"
+#include "CProfiler.h"
 #include "CXmlCreator.h"
 #include "Util.h"
 
 using std::string;
+using std::vector;
 
 /* METHOD *********************************************************************/
 /**
@@ -79,6 +81,7 @@ CFormula& CFormula::operator=(const CFormula& rhs)
 *******************************************************************************/
 string CFormula::validate(const CModelData& mod) const
 {
+	PROFILE_SCOPE("validate");
 	for (const auto& glyph : m_Formula)
 	{
 		if (!glyph->hasValidCoordIndex(mod.numCoord()) || !glyph->hasValidFieldIndex(mod.numField()))
@@ -128,6 +131,49 @@ void CFormula::fromXml(QDomElement& elem)
 	allowCursor(true); // If it has focus
 }
 
+/* METHOD *********************************************************************/
+/**
+  Reads the exponents of a serialized monomial without creating its glyphs
+  (as getExp(), getExpSigma() and getExpD() after fromXml()).
+@param     elem: Monomial element
+@param      exp: [out] Per coordinate/field
+@param expSigma: [out] Per coordinate/field, coefficients of sigma
+@param     expD: [out] Coefficient of d
+@return false if a coordinate or field index is invalid (see validate())
+*******************************************************************************/
+bool CFormula::exponentsFromXml(QDomElement& elem, size_t numCoord, size_t numField, vector<int>& exp,
+	vector<int>& expSigma, int& expD)
+{
+	exp.assign(numCoord + numField, 0);
+	expSigma.assign(numCoord + numField, 0);
+	expD = 0;
+	bool ret{true};
+	for (QDomNode node(elem.firstChild()); !node.isNull(); node = node.nextSibling())
+	{
+		if (node.isElement())
+		{
+			QDomElement fact(node.toElement());
+			if (fact.tagName() == "Factor")
+			{
+				const string type(xmlRequireAttr(fact, "type"));
+				if (type == "coord")
+				{
+					ret = CGlyphCoordinate::addExponents(fact, numCoord, exp, expSigma, expD) && ret;
+				}
+				else if (type == "field")
+				{
+					ret = CGlyphField::addExponents(fact, numCoord, numField, exp) && ret;
+				}
+				else
+				{	// Neutral glyphs have no exponents
+					throwAssert("Invalid Factor type " +  type, type == "neutral");
+				}
+			}
+		}
+	}
+	return ret;
+}
+
 /* METHOD *********************************************************************/
 /**
   Converts monomial to Xml.
@@ -185,9 +231,10 @@ void CFormula::setCsrToEnd()
 
 /* METHOD *********************************************************************/
 /**
-@param p:
+@param   p:
+@param mod: Model the glyphs refer to (symbols of coordinates and fields)
 *******************************************************************************/
-int CFormula::paint(QPainter& p)
+int CFormula::paint(QPainter& p, const CModelData& mod) const
 {
 	const QFontMetrics fmGlobal(p.font());
 	int xPos{};
@@ -198,7 +245,7 @@ int CFormula::paint(QPainter& p)
 		{
 			p.setPen(Qt::red);
 		}
-		m_Formula[ix]->paint(p, xPos);
+		m_Formula[ix]->paint(p, xPos, mod);
 		if (bCsr)
 		{
 			p.setPen(Qt::DashLine);
@@ -213,6 +260,20 @@ int CFormula::paint(QPainter& p)
 	return xPos;
 }
 
+/* METHOD *********************************************************************/
+/**
+@return Key identifying the painted formula (without cursor), see CFormulaPixmap.
+*******************************************************************************/
+string CFormula::paintKey(const CModelData& mod) const
+{
+	string key;
+	for (const auto& glyph : m_Formula)
+	{
+		glyph->appendPaintKey(key, mod);
+	}
+	return key;
+}
+
 /* METHOD *********************************************************************/
 /**
 @param ixColumn: Matrix column (Coordinates, then fields)
@@ -245,6 +306,22 @@ int CFormula::getExpD() const
 	return ret;
 }
 
+/* METHOD *********************************************************************/
+/**
+@param ixColumn: Matrix column (Coordinates, then fields)
+*
+@return Coefficient of the long range exponent sigma at (row, ixColumn)
+*******************************************************************************/
+int CFormula::getExpSigma(size_t ixColumn, const CModelData& mod) const
+{
+	int ret{};
+	for (const auto& formula : m_Formula)
+	{
+		ret += formula->exponentSigma(ixColumn, mod);
+	}
+	return ret;
+}
+
 /* METHOD *********************************************************************/
 /**
   Event handler.
@@ -276,6 +353,16 @@ bool CFormula::consumeKey(bool& dirty, int key, bool ctl)
 			dirty = true;
 			m_Formula.at(m_CsrPos - 1)->incExponent(-1);
 		}
+		else if (key == Qt::Key_PageUp)
+		{	// Coefficient of sigma (coordinates only)
+			dirty = true;
+			m_Formula.at(m_CsrPos - 1)->incExponentSigma(1);
+		}
+		else if (key == Qt::Key_PageDown)
+		{
+			dirty = true;
+			m_Formula.at(m_CsrPos - 1)->incExponentSigma(-1);
+		}
 		else if (key == Qt::Key_Left && m_CsrPos >= 2)
 		{
 			dirty = true;
@@ -31,7 +31,9 @@ public:
   std::string validate(const CModelData&) const;
   void add(CGlyphBase*);
   void clear();
-  int  paint(QPainter&);
+  int  paint(QPainter&, const CModelData&) const;
+  std::string paintKey(const CModelData&) const;
+  bool showsCursor() const { return m_CanHaveCursor && m_HasFocus; }
   void setFocus(bool state) { m_HasFocus = state; }
   void allowCursor(bool state = true) { m_CanHaveCursor = state; } // To allow edit
   void setCsrToEnd();
@@ -40,8 +42,11 @@ public:
   std::string comment() const { return m_Comment; }
   int getExp(size_t ixColumn, const CModelData& mod) const;
   int getExpD() const;
+  int getExpSigma(size_t ixColumn, const CModelData& mod) const;
 
   void fromXml(QDomElement&);
+  static bool exponentsFromXml(QDomElement&, size_t numCoord, size_t numField, std::vector<int>& exp,
+    std::vector<int>& expSigma, int& expD);
   void toXml(CXmlCreator&) const;
   bool consumeKey(bool& dirty, int key, bool ctl);
   bool containsCoord(size_t ix) const;
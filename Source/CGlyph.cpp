@@ -8,6 +8,7 @@
 #include "strutil.h"
 #include "CGlyph.h"
 #include "CModelData.h"
+#include "CProfiler.h"
 #include "CXmlCreator.h"
 #include "Util.h"
 
@@ -46,6 +47,62 @@ namespace
 		return font;
 	}
 	 
+	/* CLASS DECLARATION ******************************************************/
+	/**
+	  Metrics of a font with cached symbol extents (same names as in QFontMetrics).
+	***************************************************************************/
+	class CGlyphMetrics
+	{
+		const QFontMetrics m_Metrics;
+		std::map<ushort, QRect> m_Rects;     // boundingRect() per character
+		std::map<QString, int> m_Advances;   // horizontalAdvance() per text
+	public:
+		explicit CGlyphMetrics(const QFont& font) : m_Metrics(font), m_Rects(), m_Advances() {}
+		int descent() const { return m_Metrics.descent(); }
+		QRect boundingRect(QChar ch)
+		{
+			auto it(m_Rects.find(ch.unicode()));
+			if (it == m_Rects.end())
+			{
+				it = m_Rects.emplace(ch.unicode(), m_Metrics.boundingRect(ch)).first;
+			}
+			return it->second;
+		}
+		int horizontalAdvance(const QString& text)
+		{
+			auto it(m_Advances.find(text));
+			if (it == m_Advances.end())
+			{
+				it = m_Advances.emplace(text, m_Metrics.horizontalAdvance(text)).first;
+			}
+			return it->second;
+		}
+	};
+	 
+	/* FUNCTION ***************************************************************/
+	/**
+	@return Metrics of font, cached by QFont::key(), per thread (formulas are
+	  also painted by the workers of CReportRenderer).
+	***************************************************************************/
+	CGlyphMetrics& glyphMetrics(const QFont& font)
+	{
+		static thread_local std::map<QString, CGlyphMetrics> s_Metrics;
+		const QString key(font.key());
+		auto it(s_Metrics.find(key));
+		if (it == s_Metrics.end())
+		{
+			PROFILE_COUNT("glyphMetricsCreated", 1);
+			it = s_Metrics.emplace(key, CGlyphMetrics(font)).first;
+		}
+		return it->second;
+	}
+	 
+	string attrsKey(const SCoordFieldAttributes& attrs)
+	{
+		return toString("%x,%d,%d%d%d", unsigned(attrs.m_Symb), attrs.m_Suffix,
+			int(attrs.m_Bold), int(attrs.m_Tilde), int(attrs.m_Primed));
+	}
+	 
 	/* METHOD *********************************************************************/
 	/**
 	  Paints symbol with optional exponent
@@ -57,10 +114,10 @@ namespace
 	void paintSymbol(QPainter& p, int& xPos, ESymbol symb, const QString& exponent, const QChar& chSuff,
 		bool bold, bool tilde, bool primed)
 	{
-		const QFontMetrics fmGlobal(getFont(p));
+		CGlyphMetrics& fmGlobal(glyphMetrics(getFont(p)));
 		const int x0{xPos};
 		CGlyphNeutral n1(symb, bold);
-		n1.paint(p, xPos);
+		n1.draw(p, xPos);
 		const int prevTop{fmGlobal.boundingRect(QChar(symb)).top()};
 		if (tilde)
 		{
@@ -78,7 +135,7 @@ namespace
 			QFont font(getFont(p));
 			font.setPointSize(int(font.pointSize()*0.7));
 			p.setFont(font);
-			const QFontMetrics fmSmall(getFont(p));
+			CGlyphMetrics& fmSmall(glyphMetrics(getFont(p)));
 			p.drawText(xPos, fmGlobal.descent(), chSuff);
 			xPos += fmSmall.horizontalAdvance(chSuff);
 			p.restore();
@@ -88,7 +145,7 @@ namespace
 			p.save();
 			p.setFont(getFont(p));
 			CGlyphNeutral n1(ESymbol('\''));
-			n1.paint(p, xPos);
+			n1.draw(p, xPos);
 			p.restore();
 		}
 		if (!exponent.isEmpty())
@@ -97,7 +154,7 @@ namespace
 			QFont font(getFont(p));
 			font.setPointSize(int(font.pointSize()*0.7));
 			p.setFont(font);
-			const QFontMetrics fmSmall(getFont(p));
+			CGlyphMetrics& fmSmall(glyphMetrics(getFont(p)));
 			const QRect rect(fmSmall.boundingRect(QChar('1')));
 			p.drawText(xPos, fmGlobal.descent() - 1.2*rect.height(), exponent);
 			xPos += fmSmall.horizontalAdvance(exponent);
@@ -198,6 +255,7 @@ CGlyphCoordinate::CGlyphCoordinate(int coordIndex, ESymbol symb, int exponent)
 	, m_CoordIndex(coordIndex)
 	, m_Symb(symb)
 	, m_Exponent(exponent)
+	, m_ExponentSigma()
 {
 }
 /* METHOD *********************************************************************/
@@ -208,6 +266,7 @@ CGlyphCoordinate::CGlyphCoordinate(QDomElement& elem)
 	, m_CoordIndex()
 	, m_Symb(none)
 	, m_Exponent(1)
+	, m_ExponentSigma()
 {
 	string text(xmlRequireAttr(elem, "index"));
 	throwAssert("Invalid field index ", 1 == sscanf(text.c_str(), "%u", &m_CoordIndex));
@@ -222,6 +281,11 @@ CGlyphCoordinate::CGlyphCoordinate(QDomElement& elem)
 	{
 		sscanf(text.c_str(), "%d", &m_Exponent);
 	}
+	text = xmlGetAttr(elem, "sigma");
+	if (!text.empty())
+	{
+		sscanf(text.c_str(), "%d", &m_ExponentSigma);
+	}
 }
 
 /* METHOD *********************************************************************/
@@ -237,46 +301,115 @@ int CGlyphCoordinate::exponent(size_t ixColumn, const CModelData& mod) const
 	{
 		return 0;
 	}
-	if (m_Symb == integral)
+	return columnExponent(m_Symb, m_CoordIndex, m_Exponent);
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Exponent of a factor in the column of its coordinate, without
+  contributions proportional to d (see exponent())
+*******************************************************************************/
+int CGlyphCoordinate::columnExponent(ESymbol symb, int coordIndex, int exponent)
+{
+	if (symb == integral)
 	{
-		if (ixColumn != 0)
+		if (coordIndex != 0)
 		{	// The integral over the 1st coordinate is d-dimensional.
 			return -1;
 		}
 	}
-	else if (m_Symb == delta)
+	else if (symb == delta)
 	{
-		if (ixColumn != 0)
+		if (coordIndex != 0)
 		{	// A delta-function with 1st coordinate is d-dimensional.
 			return 1;
 		}
 	}
-	else if (m_Symb == nabla || m_Symb == partial)
+	else if (symb == nabla || symb == partial)
 	{
-		return m_Exponent;
+		return exponent;
+	}
+	else if (symb == none)
+	{	// Convert coordinate to wave vector exponent.
+		return -exponent;
+	}
+	return 0;
+}
+
+/* METHOD *********************************************************************/
+/**
+  As exponent().
+@return Coefficient of sigma of the coordinate exponent
+*******************************************************************************/
+int CGlyphCoordinate::exponentSigma(size_t ixColumn, const CModelData& mod) const
+{
+	if (ixColumn >= mod.numCoord() || m_CoordIndex != int(ixColumn))
+	{
+		return 0;
 	}
-	else if (m_Symb == none)
+	return columnExponentSigma(m_Symb, m_ExponentSigma);
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Coefficient of sigma of a factor in the column of its coordinate
+*******************************************************************************/
+int CGlyphCoordinate::columnExponentSigma(ESymbol symb, int exponentSigma)
+{
+	if (symb == nabla || symb == partial)
+	{
+		return exponentSigma;
+	}
+	else if (symb == none)
 	{	// Convert coordinate to wave vector exponent.
-		return -m_Exponent;
+		return -exponentSigma;
 	}
 	return 0;
 }
 
+/* METHOD *********************************************************************/
+/**
+@return Exponent as displayed (UTF-8), e.g. "2", "sigma" or "2+sigma"
+*******************************************************************************/
+string CGlyphCoordinate::getExponentString() const
+{
+	if (m_ExponentSigma == 0)
+	{
+		return m_Exponent == 1 ? "" : toString(m_Exponent);
+	}
+	const string strSigma((m_ExponentSigma == 1 ? string() : m_ExponentSigma == -1 ? string("-")
+		: toString(m_ExponentSigma)) + "\xCF\x83");
+	if (m_Exponent == 0)
+	{
+		return strSigma;
+	}
+	return toString(m_Exponent) + (m_ExponentSigma > 0 ? "+" : "") + strSigma;
+}
+
 /* METHOD *********************************************************************/
 /**
 @return Coordinate exponent: Contribution proportional to d.
 *******************************************************************************/
 int CGlyphCoordinate::exponentD() const
 {
-	if (m_CoordIndex != 0)
+	return columnExponentD(m_Symb, m_CoordIndex);
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Contribution proportional to d of a factor (see exponentD())
+*******************************************************************************/
+int CGlyphCoordinate::columnExponentD(ESymbol symb, int coordIndex)
+{
+	if (coordIndex != 0)
 	{	// Not 1st (d-dimensional) coordinate
 		return 0;
 	}
-	if (m_Symb == integral)
+	if (symb == integral)
 	{
 		return -1;
 	}
-	else if (m_Symb == delta)
+	else if (symb == delta)
 	{	// Delta function
 		return 1;
 	}
@@ -285,16 +418,60 @@ int CGlyphCoordinate::exponentD() const
 
 /* METHOD *********************************************************************/
 /**
+  Adds the exponents of a coordinate factor without creating the glyph (scan
+  of the library, see CFormula::exponentsFromXml()). Attributes as the ctor.
+@param      elem: Factor element
+@param       exp: [in, out] Per coordinate/field
+@param  expSigma: [in, out] Per coordinate/field, coefficients of sigma
+@param      expD: [in, out] Coefficient of d
+@return false if the coordinate index is invalid
 *******************************************************************************/
-void CGlyphCoordinate::paint(QPainter& p, int& xPos) const
+bool CGlyphCoordinate::addExponents(QDomElement& elem, size_t numCoord, std::vector<int>& exp,
+	std::vector<int>& expSigma, int& expD)
 {
-	const QFontMetrics fmGlobal(getFont(p));
-	const SCoordFieldAttributes attrs(model().glyphCoord(m_CoordIndex).attrs());
+	int coordIndex{};
+	string text(xmlRequireAttr(elem, "index"));
+	throwAssert("Invalid field index ", 1 == sscanf(text.c_str(), "%u", &coordIndex));
+	ESymbol symb{none};
+	text = xmlGetAttr(elem, "symbol");
+	if (!text.empty())
+	{
+		symb = string2symbol(text);
+		throwAssert("Unknown symbol '" + text + "'", symb != none);
+	}
+	int exponent{1}, exponentSigma{};
+	text = xmlGetAttr(elem, "exponent");
+	if (!text.empty())
+	{
+		sscanf(text.c_str(), "%d", &exponent);
+	}
+	text = xmlGetAttr(elem, "sigma");
+	if (!text.empty())
+	{
+		sscanf(text.c_str(), "%d", &exponentSigma);
+	}
+	if (coordIndex < 0 || size_t(coordIndex) >= numCoord)
+	{
+		return false;
+	}
+	exp[size_t(coordIndex)] += columnExponent(symb, coordIndex, exponent);
+	expSigma[size_t(coordIndex)] += columnExponentSigma(symb, exponentSigma);
+	expD += columnExponentD(symb, coordIndex);
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+*******************************************************************************/
+void CGlyphCoordinate::paint(QPainter& p, int& xPos, const CModelData& mod) const
+{
+	CGlyphMetrics& fmGlobal(glyphMetrics(getFont(p)));
+	const SCoordFieldAttributes attrs(mod.glyphCoord(m_CoordIndex).attrs());
 	switch (m_Symb)
 	{
 	case none:
 		{	// Koordinaten zulassen (z.B. Kondo-Modell).
-			const QString exponent(m_Exponent == 1 ? "" : QString::number(m_Exponent));
+			const QString exponent(QString::fromUtf8(getExponentString().c_str()));
 			const QChar chSuff(attrs.m_Suffix < 0 ? 0 : attrs.m_Suffix + '0');
 			paintSymbol(p, xPos, attrs.m_Symb, exponent, chSuff, false, attrs.m_Tilde, attrs.m_Primed);
 		}
@@ -307,7 +484,7 @@ void CGlyphCoordinate::paint(QPainter& p, int& xPos) const
 			font.setPointSize(int(font.pointSize()*1.2));
 			p.setFont(font);
 			CGlyphNeutral n1(integral, false);
-			n1.paint(p, xPos);
+			n1.draw(p, xPos);
 			p.restore();
 			xPos -= 3;
 			const QString exponent(m_CoordIndex == 0 ? "d" : "");
@@ -322,17 +499,17 @@ void CGlyphCoordinate::paint(QPainter& p, int& xPos) const
 			const QString exponent(m_CoordIndex == 0 ? "d" : "");
 			paintSymbol(p, xPos, delta, exponent, QChar(), false, false, false);
 			CGlyphNeutral n1(bra, false);
-			n1.paint(p, xPos);
+			n1.draw(p, xPos);
 			const QChar chSuff(attrs.m_Suffix < 0 ? 0 : attrs.m_Suffix + '0');
 			paintSymbol(p, xPos, attrs.m_Symb, "", chSuff, false, attrs.m_Tilde, attrs.m_Primed);
 			CGlyphNeutral n2(ket, false);
-			n2.paint(p, xPos);
+			n2.draw(p, xPos);
 		}
 		break;
 	case nabla:
 	case partial:
 		{
-			const QString exponent(m_Exponent == 1 ? "" : QString::number(m_Exponent));
+			const QString exponent(QString::fromUtf8(getExponentString().c_str()));
 			QChar chSuff(m_CoordIndex == 0 ? 0 : attrs.m_Symb);
 			paintSymbol(p, xPos, m_Symb, exponent, chSuff, false, false, attrs.m_Primed);
 		}
@@ -341,6 +518,16 @@ void CGlyphCoordinate::paint(QPainter& p, int& xPos) const
 	}
 }
 
+/* METHOD *********************************************************************/
+/**
+  Appends the data paint() depends on (including the coordinate attributes).
+*******************************************************************************/
+void CGlyphCoordinate::appendPaintKey(string& key, const CModelData& mod) const
+{
+	key += toString("C%x,%d,%d,%d,", unsigned(m_Symb), m_CoordIndex, m_Exponent, m_ExponentSigma)
+		+ attrsKey(mod.glyphCoord(m_CoordIndex).attrs()) + ";";
+}
+
 /* METHOD *********************************************************************/
 /**
 @return Coordinate attributes (as a monomial factor).
@@ -350,7 +537,9 @@ void CGlyphCoordinate::toXml(CXmlCreator& xml) const
 	xml.addAttrib("type", "coord");
 	xml.addAttrib("index", toString(m_CoordIndex));
 	xml.addAttrib("symbol", symbol2string(m_Symb));
-	xml.addAttribSkipEmpty("exponent", (m_Exponent == 0 || m_Exponent == 1) ? "" : toString(m_Exponent));
+	const bool defaultExponent{m_Exponent == 1 || (m_Exponent == 0 && m_ExponentSigma == 0)};
+	xml.addAttribSkipEmpty("exponent", defaultExponent ? "" : toString(m_Exponent));
+	xml.addAttribSkipEmpty("sigma", m_ExponentSigma == 0 ? "" : toString(m_ExponentSigma));
 	xml.createClose("Factor");
 }
 
@@ -403,15 +592,51 @@ int CGlyphField::exponent(size_t ixColumn, const CModelData& mod) const
 
 /* METHOD *********************************************************************/
 /**
+  Adds the exponent of a field factor without creating the glyph (see
+  CGlyphCoordinate::addExponents()).
+@param elem: Factor element
+@param  exp: [in, out] Per coordinate/field
+@return false if the field index is invalid
 *******************************************************************************/
-void CGlyphField::paint(QPainter& p, int& xPos) const
+bool CGlyphField::addExponents(QDomElement& elem, size_t numCoord, size_t numField, std::vector<int>& exp)
 {
-	const SCoordFieldAttributes attrs(model().glyphField(m_FieldIndex).attrs());
+	int fieldIndex{};
+	string text(xmlRequireAttr(elem, "index"));
+	throwAssert("Invalid field index ", 1 == sscanf(text.c_str(), "%u", &fieldIndex));
+	int exponent{1};
+	text = xmlGetAttr(elem, "exponent");
+	if (!text.empty())
+	{
+		sscanf(text.c_str(), "%d", &exponent);
+	}
+	if (fieldIndex < 0 || size_t(fieldIndex) >= numField)
+	{
+		return false;
+	}
+	exp[numCoord + size_t(fieldIndex)] += exponent;
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+*******************************************************************************/
+void CGlyphField::paint(QPainter& p, int& xPos, const CModelData& mod) const
+{
+	const SCoordFieldAttributes attrs(mod.glyphField(m_FieldIndex).attrs());
 	const QString exponent(m_Exponent == 1 ? "" : QString::number(m_Exponent));
 	const QChar chSuff(attrs.m_Suffix < 0 ? 0 : attrs.m_Suffix + '0');
 	paintSymbol(p, xPos, attrs.m_Symb, exponent, chSuff, attrs.m_Bold, attrs.m_Tilde, attrs.m_Primed);
 }
 
+/* METHOD *********************************************************************/
+/**
+  Appends the data paint() depends on (including the field attributes).
+*******************************************************************************/
+void CGlyphField::appendPaintKey(string& key, const CModelData& mod) const
+{
+	key += toString("F%d,%d,", m_FieldIndex, m_Exponent) + attrsKey(mod.glyphField(m_FieldIndex).attrs()) + ";";
+}
+
 /* METHOD *********************************************************************/
 /**
 @return Field attributes (as a monomial factor).
@@ -458,12 +683,20 @@ CGlyphCoordField::CGlyphCoordField(QDomElement& elem)
 /* METHOD *********************************************************************/
 /**
 *******************************************************************************/
-void CGlyphCoordField::paint(QPainter& p, int& xPos) const
+void CGlyphCoordField::paint(QPainter& p, int& xPos, const CModelData&) const
 {
 	const QChar chSuff(m_Attributes.m_Suffix < 0 ? 0 : m_Attributes.m_Suffix + '0');
 	paintSymbol(p, xPos, m_Attributes.m_Symb, "", chSuff, m_Attributes.m_Bold, m_Attributes.m_Tilde, m_Attributes.m_Primed);
 }
 
+/* METHOD *********************************************************************/
+/**
+*******************************************************************************/
+void CGlyphCoordField::appendPaintKey(string& key, const CModelData&) const
+{
+	key += "X" + attrsKey(m_Attributes) + ";";
+}
+
 /* METHOD *********************************************************************/
 /**
   Serializes coordinate/field definition
@@ -514,13 +747,14 @@ CGlyphNeutral::CGlyphNeutral(QDomElement& elem)
 
 /* METHOD *********************************************************************/
 /**
+  Paints the symbol; independent of the model (see paint()).
 *******************************************************************************/
-void CGlyphNeutral::paint(QPainter& p, int& xPos) const
+void CGlyphNeutral::draw(QPainter& p, int& xPos) const
 {
 	p.save();
 	QFont font(getFont(p));
 	p.setFont(font);
-	const QFontMetrics fmGlobal(font);
+	CGlyphMetrics& fmGlobal(glyphMetrics(font));
 	if (m_Bold)
 	{
 		font.setWeight(QFont::DemiBold);
@@ -530,7 +764,7 @@ void CGlyphNeutral::paint(QPainter& p, int& xPos) const
 	{	// Workaround for windows 10, QTBUG-48945.
 		xPos++;
 		const int top{fmGlobal.boundingRect(QChar('x')).top()};
-		const int w1{int(fmGlobal.horizontalAdvance('x')*0.9)};
+		const int w1{int(fmGlobal.horizontalAdvance(QChar('x'))*0.9)};
 		const int x1{xPos + w1/2};
 		QPen pen(p.pen());
 		pen.setWidth(2);
@@ -553,6 +787,14 @@ void CGlyphNeutral::paint(QPainter& p, int& xPos) const
 	p.restore();
 }
 
+/* METHOD *********************************************************************/
+/**
+*******************************************************************************/
+void CGlyphNeutral::appendPaintKey(string& key, const CModelData&) const
+{
+	key += toString("N%x,%d;", unsigned(m_Symb), int(m_Bold));
+}
+
 /* METHOD *********************************************************************/
 /**
 @return TeX for the glyph
@@ -2,6 +2,7 @@
 #define CGLYPH_H
 
 #include <string>
+#include <vector>
 
 class CModelData;
 class CXmlCreator;
@@ -120,13 +121,16 @@ public:
 	virtual ~CGlyphBase() {}
 	static void initializeSymbolTable();
 	virtual CGlyphBase* clone() = 0;
-	virtual void paint(QPainter&, int& xPos) const = 0;
+	virtual void paint(QPainter&, int& xPos, const CModelData&) const = 0;
+	virtual void appendPaintKey(std::string& key, const CModelData&) const = 0; // Everything paint() depends on
 	virtual void toXml(CXmlCreator&) const = 0;
 	virtual bool isNeutral() { return false; }
 	virtual ESymbol symbol() const { return none; }
 	virtual void incExponent(int) {}
+	virtual void incExponentSigma(int) {}
 	virtual int exponent(size_t /*ixColumn*/, const CModelData&) const { return 0; }
 	virtual int exponentD() const { return 0; }
+	virtual int exponentSigma(size_t /*ixColumn*/, const CModelData&) const { return 0; }
 	virtual bool hasValidCoordIndex(size_t) const { return true; }
 	virtual bool hasValidFieldIndex(size_t) const { return true; }
 };
@@ -144,7 +148,9 @@ public:
 	CGlyphNeutral(ESymbol symb, bool bold = false);
 	CGlyphNeutral(QDomElement&);
 	CGlyphBase* clone() override { return new CGlyphNeutral(*this); }
-	void paint(QPainter&, int& xPos) const override;
+	void paint(QPainter& p, int& xPos, const CModelData&) const override { draw(p, xPos); }
+	void draw(QPainter&, int& xPos) const;
+	void appendPaintKey(std::string& key, const CModelData&) const override;
 	void toXml(CXmlCreator&) const override;
 	bool isNeutral() override { return true; }
 	ESymbol symbol() const override { return m_Symb; }
@@ -165,11 +171,13 @@ public:
 	CGlyphField(QDomElement&);
 	CGlyphBase* clone() override { return new CGlyphField(*this); }
 	int  exponent(size_t ixColumn, const CModelData&) const override;
-	void paint(QPainter&, int& xPos) const override;
+	void paint(QPainter&, int& xPos, const CModelData&) const override;
+	void appendPaintKey(std::string& key, const CModelData&) const override;
 	void toXml(CXmlCreator&) const override;
 	void incExponent(int delta) override { CGlyphBase::incExponent(m_Exponent, delta, -1); }
 	int  fieldIndex() const { return m_FieldIndex; }
 	bool hasValidFieldIndex(size_t vectSize) const override { return m_FieldIndex < int(vectSize); }
+	static bool addExponents(QDomElement&, size_t numCoord, size_t numField, std::vector<int>& exp);
 	void decIndex() { m_FieldIndex--; }
 	void setIndex(int fx) { m_FieldIndex = fx; }
 };
@@ -183,20 +191,29 @@ class CGlyphCoordinate : public CGlyphBase
 	int  m_CoordIndex; // Coordinate index from CModelData (attribute to m_Symb)
 	ESymbol m_Symb;    // EXTRA symbol to display (integrate, nabla, delta, ...)
 	int  m_Exponent;   // Exponent
+	int  m_ExponentSigma; // Coefficient of the long range exponent sigma, e.g. |k|^sigma (see CSigmaSweep)
 	char m_ExponentCh; // Overwrites m_Exponent if != 0
 	int  m_Suffix;     // >= 0, suffix (or character, e.g. 't') displayed with coord/field
 	std::string getExponentString() const;
+	static int columnExponent(ESymbol symb, int coordIndex, int exponent);
+	static int columnExponentD(ESymbol symb, int coordIndex);
+	static int columnExponentSigma(ESymbol symb, int exponentSigma);
 public:
 	CGlyphCoordinate(int coordIndex, ESymbol symb, int exponent = 1);
 	CGlyphCoordinate(QDomElement&);
 	CGlyphBase* clone() override { return new CGlyphCoordinate(*this); }
 	int  coordIndex() const { return m_CoordIndex; }
 	bool hasValidCoordIndex(size_t vectSize) const override { return m_CoordIndex < int(vectSize); }
-	void paint(QPainter&, int& xPos) const override;
+	void paint(QPainter&, int& xPos, const CModelData&) const override;
+	void appendPaintKey(std::string& key, const CModelData&) const override;
 	void toXml(CXmlCreator&) const override;
 	void incExponent(int delta) override { CGlyphBase::incExponent(m_Exponent, delta, -4); }
+	void incExponentSigma(int delta) override { CGlyphBase::incExponent(m_ExponentSigma, delta, -4); }
 	int  exponent(size_t ixColumn, const CModelData&) const override;
 	int  exponentD() const override;
+	int  exponentSigma(size_t ixColumn, const CModelData&) const override;
+	static bool addExponents(QDomElement&, size_t numCoord, std::vector<int>& exp, std::vector<int>& expSigma,
+		int& expD);
 	void decIndex() { m_CoordIndex--; }
 	void setIndexToDefault() { m_CoordIndex = 0; }
 };
@@ -215,7 +232,8 @@ public:
 	CGlyphCoordField(ESymbol symb = qmark, const std::string& comment = "");
 	CGlyphCoordField(QDomElement&);
 	CGlyphBase* clone() override { return new CGlyphCoordField(*this); }
-	void paint(QPainter&, int& xPos) const override;
+	void paint(QPainter&, int& xPos, const CModelData&) const override;
+	void appendPaintKey(std::string& key, const CModelData&) const override;
 	void toXml(CXmlCreator&) const override { return; }
 	void toXml(CXmlCreator&, const std::string& tag) const;
 	std::string toStr() const;
@@ -1,8 +1,11 @@
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <QtGui/QKeyEvent>
-#include <QtCore/QTimer>
+#include <QtGui/QDrag>
+#include <QtGui/QPainter>
+#include <QtCore/QMimeData>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QHeaderView>
 #include <QtWidgets/QLabel>
@@ -10,7 +13,7 @@
 #include <QtWidgets/QLineEdit>
 #include <QtWidgets/QMenu>
 #include <QtWidgets/QMessageBox>
-#include <QtWidgets/QScrollBar>
+#include <QtWidgets/QStyledItemDelegate>
 #include <QtWidgets/QTableView>
 #include "CDlgInput.h"
 #include "CGlyph.h"
@@ -18,6 +21,7 @@
 #include "CModelData.h"
 #include "CMmlWdgtRow.h"
 #include "CNumerics.h"
+#include "CProfiler.h"
 #include "CWndMain.h"
 #include "CXmlCreator.h"
 #include "strutil.h"
@@ -28,20 +32,7 @@ using std::string;
 namespace
 {
 	enum { colIndex, colDimension, colFormula, colComment, colCount };
-	const int MaxNumTerm{40};
 	static CGuiMatrix* s_GuiMatrix;
-	class CWaitCursor
-	{
-	public:
-		CWaitCursor()
-		{
-			QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-		}
-		~CWaitCursor()
-		{
-			QApplication::restoreOverrideCursor();
-		}
-	};
 	QString toolTipExtraTerm()
 	{
 		return QString(
@@ -62,16 +53,12 @@ const unsigned CGuiMatrix::s_BgColorNormal{0xFFFFED}; // Bg color of normal term
 *******************************************************************************/
 class CItemModel : public QAbstractTableModel
 {
-	const std::vector<CMmlWdgtRow*>& m_Rows;
 public:
-	CItemModel(const std::vector<CMmlWdgtRow*>& rows)
-		: QAbstractTableModel()
-		, m_Rows(rows)
-	{}
+	CItemModel() : QAbstractTableModel() {}
 	int columnCount(const QModelIndex&) const override { return colCount; }
 	int rowCount(const QModelIndex& = QModelIndex()) const override
-	{
-		return MaxNumTerm;
+	{	// Terms and "..."
+		return int(guiMatrix().numTerm()) + 1;
 	}
 	QVariant headerData (int col, Qt::Orientation orientation, int role) const override
 	{
@@ -153,7 +140,17 @@ public:
 			{
 				return QString("Click to edit the row comment.");
 			}
-			else if (col == colFormula && !isNormalRow && !guiMatrix().isDotRow(row))
+			else if (col == colFormula && guiMatrix().isDotRow(row))
+			{
+				QString text("Drag operators or fields onto\n"
+					"the '...' to create another term.");
+				if (model().numTerm() < model().modelOrder())
+				{
+					text += "\nAt least " + QString::number(model().modelOrder()) + " terms are required.";
+				}
+				return text;
+			}
+			else if (col == colFormula && !isNormalRow)
 			{
 				return toolTipExtraTerm();
 			}
@@ -176,34 +173,144 @@ public:
 		return Qt::ItemIsEnabled;
 	}
 	void updateCells()
-	{	// Triggers an update of all cells.
-		dataChanged(index(0, 0), index(model().numTerm() - 1, colCount - 1));
+	{	// Triggers an update of all cells (the view repaints the visible ones).
+		dataChanged(index(0, 0), index(rowCount() - 1, colCount - 1));
+	}
+	void beginInsert(int row) { beginInsertRows(QModelIndex(), row, row); }
+	void endInsert() { endInsertRows(); }
+	void beginRemove(int row) { beginRemoveRows(QModelIndex(), row, row); }
+	void endRemove() { endRemoveRows(); }
+	void beginReset() { beginResetModel(); }
+	void endReset() { endResetModel(); }
+};
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Paints the formulas from cached pixmaps (the editor covers the current row)
+  and creates the editor.
+*******************************************************************************/
+class CTermDelegate : public QStyledItemDelegate
+{
+	mutable std::vector<CFormulaPixmap> m_Pixmaps; // Per row
+public:
+	CTermDelegate(QObject* parent) : QStyledItemDelegate(parent), m_Pixmaps() {}
+	const QPixmap& pixmap(int row, const QFont& font, const QSize& size, qreal pixelRatio) const
+	{
+		if (size_t(row) >= m_Pixmaps.size())
+		{
+			m_Pixmaps.resize(row + 1);
+		}
+		QFont fnt(font);
+		fnt.setPointSize(CMmlWdgtBase::DefaultPointSize);
+		return m_Pixmaps[row].get(guiMatrix().formula(row), model(), fnt, size, pixelRatio);
+	}
+	int formulaWidth(int row) const
+	{
+		return size_t(row) < m_Pixmaps.size() ? m_Pixmaps[row].width() : 0;
+	}
+	void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override
+	{
+		QStyledItemDelegate::paint(painter, option, index);
+		if (index.column() == colFormula && index.row() != guiMatrix().editorRow())
+		{
+			painter->drawPixmap(option.rect.topLeft(), pixmap(index.row(), option.font, option.rect.size(),
+				painter->device()->devicePixelRatioF()));
+		}
+	}
+	QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override
+	{
+		if (index.column() == colFormula)
+		{
+			if (formulaWidth(index.row()) <= 0)
+			{	// Not painted yet
+				pixmap(index.row(), option.font, QSize(1, 1), 1.0);
+			}
+			return QSize(formulaWidth(index.row()) + 2 * CMmlWdgtBase::DefaultPointSize, option.rect.height());
+		}
+		return QStyledItemDelegate::sizeHint(option, index);
+	}
+	QWidget* createEditor(QWidget* parent, const QStyleOptionViewItem&, const QModelIndex& index) const override
+	{
+		return new CMmlWdgtRow(parent, index.row());
+	}
+	void setEditorData(QWidget*, const QModelIndex&) const override {}
+	void setModelData(QWidget*, QAbstractItemModel*, const QModelIndex&) const override {}
+	bool eventFilter(QObject*, QEvent*) override
+	{	// All keys go to the editor (no commit/close on Return, Tab, Escape).
+		return false;
 	}
 };
 
 /* CLASS DECLARATION **********************************************************/
 /**
-  To get currentChanged() events.
+  To get currentChanged() events. Starts row drags and accepts drops for all rows.
 *******************************************************************************/
 class CMatrixTableView : public QTableView
 {
-	QTimer* m_Timer;
+	int m_DragRow;     // Drag candidate or -1
+	QPoint m_DragPos;
 public:
-	CMatrixTableView(QWidget* parent, QTimer* timer) : QTableView(parent), m_Timer(timer)
+	CMatrixTableView(QWidget* parent) : QTableView(parent), m_DragRow(-1), m_DragPos()
 	{
+		setAcceptDrops(true);
+		setDropIndicatorShown(false);
 	}
 protected:
-	void currentChanged(const QModelIndex& current, const QModelIndex& prev)
+	void currentChanged(const QModelIndex& current, const QModelIndex& prev) override
 	{
 		QTableView::currentChanged(current, prev);
-		guiMatrix().setRxInteraction(current.row());
-		guiMatrix().determineCriticalDimension();
-		guiMatrix().updateMml();
+		guiMatrix().openEditor(current.row());
+		if (!guiMatrix().isRestoring())
+		{	// Undo/redo restore the interaction and the results
+			guiMatrix().setRxInteraction(current.row());
+			guiMatrix().determineCriticalDimension();
+		}
 	}
-	void wheelEvent(QWheelEvent* ev) override
+	void mousePressEvent(QMouseEvent* ev) override
 	{
-		QTableView::wheelEvent(ev);
-		m_Timer->start(std::chrono::milliseconds(1000));
+		QTableView::mousePressEvent(ev);
+		const QModelIndex index(indexAt(ev->pos()));
+		const bool isTerm{index.isValid() && index.row() < int(guiMatrix().numTerm())};
+		m_DragRow = ev->button() == Qt::LeftButton && isTerm && index.column() == colFormula ? index.row() : -1;
+		m_DragPos = ev->pos();
+	}
+	void mouseMoveEvent(QMouseEvent* ev) override
+	{
+		if (m_DragRow >= 0 && (ev->buttons() & Qt::LeftButton)
+			&& (ev->pos() - m_DragPos).manhattanLength() >= QApplication::startDragDistance())
+		{
+			const int row{m_DragRow};
+			m_DragRow = -1;
+			guiMatrix().startDrag(row, this);
+			return;
+		}
+		QTableView::mouseMoveEvent(ev);
+	}
+	void dragEnterEvent(QDragEnterEvent* ev) override
+	{
+		QTableView::dragEnterEvent(ev); // Auto scroll
+		ev->setAccepted(canDrop(ev->mimeData(), -1));
+	}
+	void dragMoveEvent(QDragMoveEvent* ev) override
+	{
+		QTableView::dragMoveEvent(ev);
+		ev->setAccepted(canDrop(ev->mimeData(), indexAt(ev->pos()).row()));
+	}
+	void dropEvent(QDropEvent* ev) override
+	{
+		const int row{indexAt(ev->pos()).row()};
+		if (canDrop(ev->mimeData(), row) && guiMatrix().drop(row, ev->mimeData()))
+		{
+			ev->acceptProposedAction();
+		}
+		stopAutoScroll();
+	}
+private:
+	static bool canDrop(const QMimeData* md, int row)
+	{	// Rows cannot be moved behind "..."
+		return md->hasFormat(MimeFormat::Field) || md->hasFormat(MimeFormat::Operator)
+			|| md->hasFormat(MimeFormat::Coord)
+			|| (md->hasFormat(MimeFormat::Row) && !guiMatrix().isDotRow(row));
 	}
 };
 
@@ -223,28 +330,39 @@ CGuiMatrix& guiMatrix()
 @param loOuter:
 *******************************************************************************/
 CGuiMatrix::CGuiMatrix(QBoxLayout* loOuter, CWndMain* wndMain)
-	: m_ItemModel(new CItemModel(m_Rows))
+	: m_ItemModel()
+	, m_Delegate()
 	, m_WndMain(wndMain)
 	, m_RxInteractionSingular()
+	, m_Restoring()
 	, m_RxInteraction()
-	, m_Timer(new QTimer(this))
-	, m_TableView(new CMatrixTableView(wndMain, m_Timer))
-	, m_Rows()
+	, m_TableView()
+	, m_Editor()
+	, m_DotRow()
+	, m_Terms()
+	, m_History()
 {
 	throwAssert("CGuiMatrix singleton", s_GuiMatrix == 0);
 	s_GuiMatrix = this;
+	for (size_t ix{}; ix < 3; ix++)
+	{
+		m_DotRow.add(new CGlyphNeutral(dot, true));
+	}
+	m_ItemModel = new CItemModel;
+	m_TableView = new CMatrixTableView(wndMain);
+	m_Delegate = new CTermDelegate(m_TableView);
 	QGridLayout* loGrid{new QGridLayout};
 	loOuter->addLayout(loGrid);
 	loGrid->addWidget(m_TableView);
 	m_TableView->setModel(m_ItemModel);
+	m_TableView->setItemDelegateForColumn(colFormula, m_Delegate);
 	m_TableView->setColumnWidth(colIndex, 30);
-	m_Timer->setSingleShot(true);
+	m_TableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+	m_TableView->verticalHeader()->setDefaultSectionSize(int(2.7*CMmlWdgtBase::DefaultPointSize));
+	m_TableView->horizontalHeader()->setStretchLastSection(true);
 	clear();
-	addEmptyRow();
 	updateMml();
 	connect(m_TableView, SIGNAL(pressed(const QModelIndex&)), this, SLOT(onTableClick(const QModelIndex&)));
-	connect(m_TableView->verticalScrollBar(), SIGNAL(sliderReleased()), this, SLOT(onScroll()));
-	connect(m_Timer, SIGNAL(timeout()), this, SLOT(onScroll()));
 }
 
 /* METHOD *********************************************************************/
@@ -253,16 +371,11 @@ CGuiMatrix::CGuiMatrix(QBoxLayout* loOuter, CWndMain* wndMain)
 *******************************************************************************/
 void CGuiMatrix::clear()
 {
-	for (size_t ix{}; ix < m_Rows.size(); ix++)
-	{	// Do not delete: widgets remain in the QTableView.
-		m_Rows[ix]->clear();
-	}
-	m_Rows.clear();
-	for (int rx{}; rx < m_ItemModel->rowCount(); rx++)
-	{
-		m_TableView->setIndexWidget(m_TableView->model()->index(rx, colFormula), NULL);
-		m_TableView->setRowHidden(rx, true);
-	}
+	openEditor(-1);
+	m_ItemModel->beginReset();
+	m_Terms.clear();
+	m_ItemModel->endReset();
+	m_History.clear();
 }
 
 /* METHOD *********************************************************************/
@@ -281,6 +394,8 @@ void CGuiMatrix::determineCriticalDimension()
 		try
 		{
 			model().determineCanonicalDimensions(m_RxInteraction);
+			// Nearly singular: flagged like a singular interaction
+			m_RxInteractionSingular = CNumerics::isIllConditioned(model().reciprocalCondition(m_RxInteraction));
 		}
 		catch (const std::exception&)
 		{
@@ -289,8 +404,9 @@ void CGuiMatrix::determineCriticalDimension()
 	}
 	else
 	{
-		rank = CNumerics::determineRank(model());
+		rank = CNumerics::determineRank(model().expMatrix());
 	}
+	recordEdit(isCritical, critDim, rank);
 	if (m_WndMain)
 	{
 		m_WndMain->displayCritDim(isCritical, critDim, rank);
@@ -300,111 +416,253 @@ void CGuiMatrix::determineCriticalDimension()
 
 /* METHOD *********************************************************************/
 /**
+  Adds the current state to the undo history (see CEditHistory::record()).
+@param isCritical, critDim, rank: As displayed
 *******************************************************************************/
-void CGuiMatrix::updateMml()
+void CGuiMatrix::recordEdit(bool isCritical, double critDim, int rank)
+{
+	CEditHistory::SState state{};
+	for (const auto& term : m_Terms)
+	{
+		state.terms.push_back(m_History.share(term));
+	}
+	state.coords = model().coords();
+	state.fields = model().fields();
+	state.coordsFieldsKey = CEditHistory::coordsFieldsKey(state.coords, state.fields);
+	state.rxInteraction = m_RxInteraction;
+	state.rxInteractionSingular = m_RxInteractionSingular;
+	state.isCritical = isCritical;
+	state.critDim = critDim;
+	state.rank = rank;
+	state.evaluation = model().evaluation();
+	m_History.record(state);
+	if (m_WndMain)
+	{
+		m_WndMain->updateUndoActions();
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Shows an earlier state: terms, coordinates, fields and the results stored
+  with the state (no evaluation).
+*******************************************************************************/
+void CGuiMatrix::restore(const CEditHistory::SState& state)
 {
-	if (CModelData::isLoadingFile())
-	{	// Optimization. updateMml() to be called when done.
-		return;
+	PROFILE_SCOPE("undoRestore");
+	const int row{currentRow()};
+	m_Restoring = true;
+	openEditor(-1);
+	m_ItemModel->beginReset();
+	m_Terms.clear();
+	for (const auto& term : state.terms)
+	{
+		m_Terms.push_back(term->formula);
+		m_Terms.back().allowCursor(true);
+	}
+	m_ItemModel->endReset();
+	model().restore(state.coords, state.fields, state.evaluation);
+	m_RxInteraction = state.rxInteraction;
+	m_RxInteractionSingular = state.rxInteractionSingular;
+	setCurrentRow(std::min(std::max(row, 0), int(m_Terms.size()) - 1));
+	m_Restoring = false;
+	if (m_WndMain)
+	{
+		m_WndMain->updateMml();
+		m_WndMain->displayCritDim(state.isCritical, state.critDim, state.rank);
+		m_WndMain->updateUndoActions();
 	}
-	bool haveMore{};
-	for (size_t rx{}; rx < m_Rows.size(); rx++)
+	updateMml();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Reverts the last edit.
+*******************************************************************************/
+void CGuiMatrix::undo()
+{
+	if (const CEditHistory::SState* state{m_History.undo()})
 	{
-		if (!haveMore)
-		{
-			m_Rows.at(rx)->updateMml();
-			m_Rows.at(rx)->setVisible(true);
-			haveMore = m_Rows.at(rx)->isDotRow();
-		}
-		else
-		{
-			m_Rows.at(rx)->setVisible(false);
-		}
-		m_Rows.at(rx)->updateToolTip();
+		restore(*state);
 	}
-	m_ItemModel->updateCells();
-	m_TableView->resizeColumnToContents(colFormula);
 }
 
 /* METHOD *********************************************************************/
 /**
-  Adds a CMmlWdgtRow to the layout (takes ownership).
-@param mmlWdgt:
+  Repeats the last undone edit.
 *******************************************************************************/
-void CGuiMatrix::addRow(CMmlWdgtRow* mmlWdgtRow)
+void CGuiMatrix::redo()
 {
-	if (m_Rows.size() >= size_t(MaxNumTerm))
+	if (const CEditHistory::SState* state{m_History.redo()})
 	{
-		delete mmlWdgtRow;
+		restore(*state);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Repaints the editor and the visible cells (other rows are painted from the
+  pixmap cache of the delegate when scrolled into view).
+*******************************************************************************/
+void CGuiMatrix::updateMml()
+{
+	if (CModelData::isLoadingFile())
+	{	// Optimization. updateMml() to be called when done.
 		return;
 	}
-	m_Rows.push_back(mmlWdgtRow);
-	const int row{int(m_Rows.size() - 1)};
-	m_TableView->setRowHeight(row, 2.7*mmlWdgtRow->baseFontPointSize()); // ToDo: Font
-	m_TableView->setIndexWidget(m_TableView->model()->index(row, colFormula), mmlWdgtRow);
-	m_TableView->horizontalHeader()->setStretchLastSection(true);
-	m_TableView->setRowHidden(row, false);
+	if (m_Editor)
+	{
+		m_Editor->updateMml();
+	}
+	m_ItemModel->updateCells();
+	m_TableView->resizeColumnToContents(colFormula);
 }
 
 /* METHOD *********************************************************************/
 /**
-  Adds a (deserialized) CMmlWdgtRow/monomial to the model.
+  Appends a (deserialized) monomial to the model.
 @param formula:
-@param     row:
 *******************************************************************************/
-void CGuiMatrix::addRow(const CFormula& formula, size_t row)
+void CGuiMatrix::addRow(const CFormula& formula)
 {
-	throwAssert(toString("Invalid matrix row %u", row), row < m_Rows.size());
-	CWaitCursor hourGlass;
-	m_Rows[row]->setFormula(formula);
+	const int row{int(m_Terms.size())};
+	m_ItemModel->beginInsert(row);
+	m_Terms.push_back(formula);
+	m_Terms.back().allowCursor(true);
+	m_ItemModel->endInsert();
 }
 
 /* METHOD *********************************************************************/
 /**
-  The last row displays "..." (==allows adding a new row)
+  Appends a glyph (drag/drop of a field, coordinate or operator) to a term.
+  A glyph dropped on "..." creates a new term.
+@param   row: Destination
+@param glyph: Takes ownership
 *******************************************************************************/
-void CGuiMatrix::addEmptyRow()
+void CGuiMatrix::addGlyph(int row, CGlyphBase* glyph)
 {
-	if (m_Rows.size() < size_t(MaxNumTerm))
+	if (isDotRow(row))
 	{
-		for (size_t rx{}; rx < m_Rows.size(); rx++)
+		addRow(CFormula());
+	}
+	if (size_t(row) >= m_Terms.size())
+	{
+		delete glyph;
+		return;
+	}
+	m_Terms[row].add(glyph);
+	m_Terms[row].setCsrToEnd();
+	model().setDirty();
+	setCurrentRow(row);
+	if (m_Editor)
+	{
+		m_Editor->reload();
+		m_Editor->QWidget::setFocus();
+	}
+	determineCriticalDimension();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Drop onto a row of the table.
+@param row: Destination
+@param  md: Row, field, coordinate or operator
+@return true when accepted
+*******************************************************************************/
+bool CGuiMatrix::drop(int row, const QMimeData* md)
+{
+	bool ok{};
+	if (md->hasFormat(MimeFormat::Row))
+	{	// Shift rows up/down.
+		const int src{md->data(MimeFormat::Row).toInt(&ok)};
+		if (ok && size_t(src) < m_Terms.size() && size_t(row) < m_Terms.size())
+		{	// The dropped term becomes the interaction (as by setCurrentRow()) before evaluation
+			setRxInteraction(row);
+			dragDropRow(src, row);
+			setCurrentRow(row);
+			return true;
+		}
+	}
+	else if (md->hasFormat(MimeFormat::Field))
+	{	// Append/insert field.
+		const int fieldIndex{md->data(MimeFormat::Field).toInt(&ok)};
+		if (ok)
 		{
-			if (m_Rows[rx]->isDotRow())
-			{
-				return;
-			}
+			addGlyph(row, new CGlyphField(fieldIndex));
+			return true;
+		}
+	}
+	else if (md->hasFormat(MimeFormat::Coord))
+	{	// Append/insert coordinate (only in special cases. Normally only operators!).
+		const int coordIndex{md->data(MimeFormat::Coord).toInt(&ok)};
+		if (ok)
+		{
+			addGlyph(row, new CGlyphCoordinate(coordIndex, ESymbol::none));
+			return true;
 		}
-		CMmlWdgtRow* row{new CMmlWdgtRow(m_TableView)};
-		for (size_t ix{}; ix < 3; ix++)
+	}
+	else if (md->hasFormat(MimeFormat::Operator))
+	{	// Append/insert operator.
+		const int iVal{md->data(MimeFormat::Operator).toInt(&ok)};
+		if (ok)
 		{
-			row->addToFormula(new CGlyphNeutral(dot, true));
+			const int index{iVal % 100};
+			const ESymbol symbol{static_cast<ESymbol>(iVal / 100)};
+			if (hasCoordinate(symbol))
+			{
+				addGlyph(row, new CGlyphCoordinate(index, symbol));
+			}
+			else
+			{
+				addGlyph(row, new CGlyphNeutral(symbol));
+			}
+			return true;
 		}
-		row->setIsDotRow();
-		addRow(row);
 	}
+	return false;
 }
 
 /* METHOD *********************************************************************/
 /**
-@param mmlWdgtRow: To delete
+  Starts dragging a term (to reorder the rows).
+@param    row: Term
+@param source: Widget receiving the mouse events
+*******************************************************************************/
+void CGuiMatrix::startDrag(int row, QWidget* source)
+{
+	if (size_t(row) >= m_Terms.size())
+	{
+		return;
+	}
+	QMimeData* mimeData{new QMimeData};
+	mimeData->setData(MimeFormat::Row, QByteArray::number(row));
+	QDrag* drag{new QDrag(source)};
+	drag->setMimeData(mimeData);
+	CFormula formula(m_Terms[row]);
+	formula.setFocus(false);
+	QFont fnt(m_TableView->font());
+	fnt.setPointSize(CMmlWdgtBase::DefaultPointSize);
+	CFormulaPixmap pixmap;
+	const QRect rect(m_TableView->visualRect(m_ItemModel->index(row, colFormula)));
+	drag->setPixmap(pixmap.get(formula, model(), fnt, rect.size(), source->devicePixelRatioF()));
+	drag->exec();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Deletes the current term.
 *******************************************************************************/
 void CGuiMatrix::deleteCurrentRow()
 {
-	const size_t row{static_cast<size_t>(currentRow())};
-	if (row < numTerm())
+	const int row{currentRow()};
+	if (size_t(row) < m_Terms.size())
 	{
-		for (size_t jx{row}; jx + 1 < m_Rows.size(); jx++)
-		{
-			m_Rows[jx]->assign(m_Rows[jx + 1]);
-		}
-		// Delete invalid last row.
-		const size_t ixLast{m_Rows.size() - 1};
-		m_TableView->setIndexWidget(m_TableView->model()->index(ixLast, colFormula), NULL);
-		m_TableView->setRowHidden(ixLast, true);
-		m_Rows.erase(m_Rows.begin() + ixLast);
-		addEmptyRow();
+		openEditor(-1);
+		m_ItemModel->beginRemove(row);
+		m_Terms.erase(m_Terms.begin() + row);
+		m_ItemModel->endRemove();
+		openEditor(currentRow());
 		model().setDirty();
-		updateMml();
 		determineCriticalDimension();
 	}
 }
@@ -415,7 +673,7 @@ void CGuiMatrix::deleteCurrentRow()
 *******************************************************************************/
 void CGuiMatrix::setRxInteraction(int rx)
 {
-	if (rx < int(model().modelOrder()))
+	if (rx >= 0 && rx < int(model().modelOrder()))
 	{
 		m_RxInteraction = rx;
 	}
@@ -423,90 +681,105 @@ void CGuiMatrix::setRxInteraction(int rx)
 
 /* METHOD *********************************************************************/
 /**
-@return true for empty row
+@param row: Becomes the current row (with editor)
 *******************************************************************************/
-bool CGuiMatrix::isDotRow(int rx) const
+void CGuiMatrix::setCurrentRow(int row)
 {
-	return rx >= 0 && rx < int(m_Rows.size()) && m_Rows[rx]->isDotRow();
+	if (m_TableView && row >= 0 && row < m_ItemModel->rowCount())
+	{
+		m_TableView->setCurrentIndex(m_ItemModel->index(row, colFormula));
+	}
 }
 
 /* METHOD *********************************************************************/
 /**
-  Passes focus from QtMmlWidget to item in QAbstractItemView
-  (what somehow isn't done by Qt).
+  Called after loading a model.
 *******************************************************************************/
-void CGuiMatrix::setFocusToItem(const CMmlWdgtRow* wdgt)
+void CGuiMatrix::setFocusToInteractionRow()
 {
-	const int rx{getIndexOfRow(wdgt)};
-	if (rx >= 0 && m_TableView)
+	const size_t rxInteraction{model().modelOrder() - 1};
+	if (rxInteraction < model().numTerm())
 	{
-		m_TableView->setCurrentIndex(m_ItemModel->index(rx, colFormula));
+		setCurrentRow(int(rxInteraction));
 	}
 }
 
 /* METHOD *********************************************************************/
 /**
-  Called after loading a model.
+  Only the current term has an editor (a persistent editor of the table view).
+  Closes the editor of the previous row.
+@param row: Term or -1 (close)
 *******************************************************************************/
-void CGuiMatrix::setFocusToInteractionRow()
+void CGuiMatrix::openEditor(int row)
 {
-	if (m_TableView)
+	const int rowOld{editorRow()};
+	if (rowOld == row)
+	{
+		return;
+	}
+	if (rowOld >= 0)
+	{
+		m_Editor = nullptr;
+		m_TableView->closePersistentEditor(m_ItemModel->index(rowOld, colFormula));
+	}
+	if (size_t(row) < m_Terms.size())
 	{
-		const size_t rxInteraction{model().modelOrder() - 1};
-		if (rxInteraction < model().numTerm())
+		const QModelIndex index(m_ItemModel->index(row, colFormula));
+		m_TableView->openPersistentEditor(index);
+		m_Editor = dynamic_cast<CMmlWdgtRow*>(m_TableView->indexWidget(index));
+		if (m_Editor)
 		{
-			m_TableView->setCurrentIndex(m_ItemModel->index(int(rxInteraction), colFormula));
+			m_Editor->QWidget::setFocus();
 		}
 	}
 }
 
+/* METHOD *********************************************************************/
+/**
+@return Row of the editor or -1
+*******************************************************************************/
+int CGuiMatrix::editorRow() const
+{
+	return m_Editor ? m_Editor->row() : -1;
+}
+
 /* METHOD *********************************************************************/
 /**
   Permutes rows according to drag/drop action.
 @param src, dst: Rows
 *******************************************************************************/
-void CGuiMatrix::dragDropRow(void* src, void* dst)
+void CGuiMatrix::dragDropRow(int src, int dst)
 {
-	if (src == dst)
+	if (src == dst || size_t(src) >= m_Terms.size() || size_t(dst) >= m_Terms.size())
 	{
 		return;
 	}
-	size_t ixDst{m_Rows.size()};
-	size_t ixSrc{m_Rows.size()};
-	for (size_t rx{}; rx < m_Rows.size(); rx++)
+	model().setDirty();
+	if (src < dst)
 	{
-		if (m_Rows[rx] == src)
-		{
-			ixSrc = rx;
-		}
-		if (m_Rows[rx] == dst)
-		{
-			ixDst = rx;
-		}
+		std::rotate(m_Terms.begin() + src, m_Terms.begin() + src + 1, m_Terms.begin() + dst + 1);
 	}
-	const bool ok{ixSrc < m_Rows.size() && ixDst < m_Rows.size()};
-	if (ok && ixDst != ixSrc)
-	{	// The CMmlWdgtRow(s) are already in the layout -> exchange formula.//
-		model().setDirty();
-		const int step{ixDst < ixSrc ? -1 : 1};
-		CMmlWdgtRow keep(nullptr);
-		keep.assign(m_Rows[ixSrc]);
-		for (size_t ix{ixSrc}; ix != ixDst; ix += step)
-		{
-			m_Rows[ix]->assign(m_Rows[ix + step]);
-		}
-		m_Rows[ixDst]->assign(&keep);
-		for (size_t jx{}; jx < m_Rows.size(); jx++)
-		{
-			//m_Rows[jx]->setFocus(jx == ixDst);
-			m_Rows[jx]->updateMml();
-			m_Rows[jx]->updateToolTip();
-		}
+	else
+	{
+		std::rotate(m_Terms.begin() + dst, m_Terms.begin() + src, m_Terms.begin() + src + 1);
 	}
-	m_ItemModel->updateCells();
+	termsChanged();
 	determineCriticalDimension();
 }
 
+/* METHOD *********************************************************************/
+/**
+  The editor holds a copy of its term: reload after changes of m_Terms.
+*******************************************************************************/
+void CGuiMatrix::termsChanged()
+{
+	if (m_Editor)
+	{
+		m_Editor->reload();
+	}
+	m_ItemModel->updateCells();
+}
+
 /* METHOD *********************************************************************/
 /**
 @return Index of current row
@@ -518,23 +791,32 @@ int CGuiMatrix::currentRow() const
 
 /* METHOD *********************************************************************/
 /**
-@return Index of row in table.
+@return Term or "..."
 *******************************************************************************/
-int CGuiMatrix::getIndexOfRow(const CMmlWdgtRow* row) const
+const CFormula& CGuiMatrix::formula(int row) const
 {
-	for (size_t jx{}; jx < m_Rows.size(); jx++)
+	return size_t(row) < m_Terms.size() ? m_Terms[row] : m_DotRow;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Called by the editor after a change.
+@param     row: Term
+@param formula: New value
+*******************************************************************************/
+void CGuiMatrix::setTerm(int row, const CFormula& formula)
+{
+	if (size_t(row) < m_Terms.size())
 	{
-		if (m_Rows[jx] == row)
-		{
-			return int(jx);
-		}
+		m_Terms[row] = formula;
+		m_Terms[row].setFocus(false);
+		m_ItemModel->updateCells();
 	}
-	return -1;
 }
 
 std::string CGuiMatrix::comment(int row) const
 {
-	return size_t(row) < m_Rows.size() ? m_Rows[row]->comment() : "";
+	return size_t(row) < m_Terms.size() ? m_Terms[row].comment() : "";
 }
 
 /* METHOD *********************************************************************/
@@ -543,10 +825,12 @@ std::string CGuiMatrix::comment(int row) const
 *******************************************************************************/
 void CGuiMatrix::permuteFields(const vector<size_t>& permutation)
 {
-	for (size_t rx{}; rx < m_Rows.size() && !m_Rows[rx]->isDotRow(); rx++)
+	for (auto& term : m_Terms)
 	{
-		m_Rows[rx]->permuteFields(permutation);
+		term.permuteFields(permutation);
 	}
+	termsChanged();
+	determineCriticalDimension();
 }
 
 /* METHOD *********************************************************************/
@@ -556,9 +840,9 @@ void CGuiMatrix::permuteFields(const vector<size_t>& permutation)
 *******************************************************************************/
 void CGuiMatrix::toXml(CXmlCreator& xml)
 {
-	for (size_t rx{}; rx < m_Rows.size() && !m_Rows[rx]->isDotRow(); rx++)
+	for (const auto& term : m_Terms)
 	{
-		m_Rows[rx]->toXml(xml);
+		term.toXml(xml);
 	}
 }
 
@@ -568,9 +852,9 @@ void CGuiMatrix::toXml(CXmlCreator& xml)
 *******************************************************************************/
 void CGuiMatrix::deleteCoord(size_t index)
 {
-	for (const auto& wdgtRow : m_Rows)
+	for (const auto& term : m_Terms)
 	{
-		if (wdgtRow->formula().containsCoord(index))
+		if (term.containsCoord(index))
 		{
 			if (yesNo(m_TableView, "The coordinate still is used in the Lagrangian.\n"
 				"Delete it and remove all references?", "Delete coordinate"))
@@ -580,10 +864,11 @@ void CGuiMatrix::deleteCoord(size_t index)
 			return;
 		}
 	}
-	for (auto& wdgtRow : m_Rows)
+	for (auto& term : m_Terms)
 	{	// Remove references.
-		wdgtRow->removeCoord(index);
+		term.removeCoord(index);
 	}
+	termsChanged();
 	m_WndMain->removeCoordFromOperator(index);
 	model().removeCoord(index);
 	m_WndMain->updateMml();
@@ -596,9 +881,9 @@ void CGuiMatrix::deleteCoord(size_t index)
 *******************************************************************************/
 void CGuiMatrix::deleteField(size_t index)
 {
-	for (const auto& wdgRow : m_Rows)
+	for (const auto& term : m_Terms)
 	{
-		if (wdgRow->formula().containsField(index))
+		if (term.containsField(index))
 		{
 			if (yesNo(m_TableView, "Field still used in the Lagrangian.\n"
 				"Delete and remove all references?", "Delete field"))
@@ -608,38 +893,32 @@ void CGuiMatrix::deleteField(size_t index)
 			return;
 		}
 	}
-	for (auto& wdgtRow : m_Rows)
+	for (auto& term : m_Terms)
 	{	// Remove references.
-		wdgtRow->removeField(index);
+		term.removeField(index);
 	}
+	termsChanged();
 	model().removeField(index);
 	m_WndMain->updateMml();
 	determineCriticalDimension();
 }
 
-size_t CGuiMatrix::numTerm() const
-{
-	if (m_Rows.empty())
-	{
-		return 0;
-	}
-	if (m_Rows[m_Rows.size() - 1]->isDotRow())
-	{
-		return m_Rows.size() - 1;
-	}
-	return m_Rows.size();
-}
-
 int CGuiMatrix::getExp(size_t tx, size_t ixColumn) const
 {
 	throwAssert("getExp(tx, ix)", tx < numTerm() && ixColumn < model().modelOrder());
-	return m_Rows[tx]->getExp(ixColumn);
+	return m_Terms[tx].getExp(ixColumn, model());
 }
 
 int CGuiMatrix::getExpD(size_t tx) const
 {
 	throwAssert("getExpD(tx", tx < numTerm());
-	return m_Rows[tx]->getExpD();
+	return m_Terms[tx].getExpD();
+}
+
+int CGuiMatrix::getExpSigma(size_t tx, size_t ixColumn) const
+{
+	throwAssert("getExpSigma(tx, ix)", tx < numTerm() && ixColumn < model().modelOrder());
+	return m_Terms[tx].getExpSigma(ixColumn, model());
 }
 
 /* METHOD *********************************************************************/
@@ -684,8 +963,12 @@ void CGuiMatrix::editComment()
 			{
 				model().setDirty();
 				dlg.dump();
-				m_Rows[row]->setComment(text);
-				m_TableView->update();
+				m_Terms[row].setComment(text);
+				termsChanged();
+				if (const CEditHistory::SState* state{m_History.current()})
+				{	// Results unchanged
+					recordEdit(state->isCritical, state->critDim, state->rank);
+				}
 			}
 		}
 	}
@@ -706,12 +989,6 @@ void CGuiMatrix::onTableClick(const QModelIndex& index)
 	}
 }
 
-void CGuiMatrix::onScroll()
-{
-	// After scroll some rows still need a repaint!
-	updateMml();
-}
-
 /* METHOD *********************************************************************/
 /**
 *******************************************************************************/
@@ -727,4 +1004,3 @@ void CGuiMatrix::keyPressEvent(QKeyEvent* ev)
 		ev->ignore();
 	}
 }
-
@@ -3,37 +3,49 @@
 
 #include <vector>
 #include <QObject>
+#include "CEditHistory.h"
+#include "CFormula.h"
 
-class CFormula;
+class CGlyphBase;
 class CItemModel;
 class CMmlWdgtRow;
+class CTermDelegate;
 class CWndMain;
 class CXmlCreator;
 class QBoxLayout;
-class QDomElement;
-class QGridLayout;
 class QKeyEvent;
+class QMimeData;
 class QModelIndex;
+class QPixmap;
 class QTableView;
-class QTimer;
 class QWidget;
 
 /* CLASS DECLARATION **********************************************************/
 /**
   Used as a singleton.
-  Contains and displays rows of terms and associated data in a QGridLayout.
+  Contains and displays rows of terms and associated data in a QTableView.
   The main part of the model data (field and coordinate exponents) live here.
+  The rows are painted by CTermDelegate from cached pixmaps, an editor
+  (CMmlWdgtRow) only exists for the current row. The row after the last term
+  displays "..." (drop target for new terms).
 *******************************************************************************/
 class CGuiMatrix : public QObject
 {
 	Q_OBJECT
 	CItemModel* m_ItemModel;
+	CTermDelegate* m_Delegate;
 	CWndMain*   m_WndMain;
 	bool        m_RxInteractionSingular;
+	bool        m_Restoring;       // Undo/redo in progress
 	int         m_RxInteraction;
-	QTimer*     m_Timer;
 	QTableView* m_TableView;
-	std::vector<CMmlWdgtRow*> m_Rows;
+	CMmlWdgtRow* m_Editor;         // Editor of the current term or nullptr
+	CFormula    m_DotRow;          // "..."
+	std::vector<CFormula> m_Terms; // Terms of the Lagrangian
+	CEditHistory m_History;        // Undo/redo
+	void termsChanged();
+	void recordEdit(bool isCritical, double critDim, int rank);
+	void restore(const CEditHistory::SState&);
 protected:
 	void keyPressEvent(QKeyEvent*);
 public:
@@ -43,20 +55,28 @@ public:
 	void clear();
 	void determineCriticalDimension();
 	void updateMml();
-	void addEmptyRow();
-	void addRow(CMmlWdgtRow*);
-	void addRow(const CFormula&, size_t row);
-	void addRow(QDomElement&, size_t row, size_t numCoord);
+	void addRow(const CFormula&);
+	void addGlyph(int row, CGlyphBase*);
+	bool drop(int row, const QMimeData*);
+	void startDrag(int row, QWidget* source);
 	void deleteCurrentRow();
-	void dragDropRow(void* src, void* dst);
+	void dragDropRow(int src, int dst);
 	void setRxInteraction(int);
-	bool isDotRow(int rx) const;
-	void setFocusToItem(const CMmlWdgtRow*);
+	bool isDotRow(int rx) const { return rx == int(m_Terms.size()); }
+	void setCurrentRow(int row);
 	void setFocusToInteractionRow();
+	void openEditor(int row);
+	int  editorRow() const;
 	int  getRxInteraction() const { return m_RxInteraction; }
 	bool isRxInteractionSingular() const { return m_RxInteractionSingular; }
+	bool isRestoring() const { return m_Restoring; }
+	bool canUndo() const { return m_History.canUndo(); }
+	bool canRedo() const { return m_History.canRedo(); }
+	void undo();
+	void redo();
 	int  currentRow() const;
-	int  getIndexOfRow(const CMmlWdgtRow*) const;
+	const CFormula& formula(int row) const;
+	void setTerm(int row, const CFormula&);
 	std::string comment(int row) const;
 	void permuteFields(const std::vector<size_t>& permutation);
 	void toXml(CXmlCreator&);
@@ -65,12 +85,12 @@ public:
 	void deleteField(size_t index);
 	void editComment();
 	void showContextMenu();
-	size_t numTerm() const;
+	size_t numTerm() const { return m_Terms.size(); }
 	int  getExp(size_t tx, size_t ixColumn) const;
 	int  getExpD(size_t tx) const;
+	int  getExpSigma(size_t tx, size_t ixColumn) const;
 private slots:
 	void onTableClick(const QModelIndex&);
-	void onScroll();
 };
 
 // Global singleton
@@ -0,0 +1,282 @@
+/******************************************************************************/
+/**
+@file         CLuFactor.cpp
+@copyright
+*
+@description  LU factorization of a real square matrix.
+*******************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "CLuFactor.h"
+
+using std::vector;
+
+/* METHOD *********************************************************************/
+/**
+@param a: Matrix, n x n, row major
+@param n: Size
+@return false if the matrix is singular
+*******************************************************************************/
+bool CLuFactor::factorize(const vector<double>& a, size_t n)
+{
+	m_N = n;
+	m_LU = a;
+	m_Norm1 = 0.0;
+	for (size_t cx{}; cx < n; cx++)
+	{
+		double sum{};
+		for (size_t rx{}; rx < n; rx++)
+		{
+			sum += fabs(a[rx * n + cx]);
+		}
+		m_Norm1 = std::max(m_Norm1, sum);
+	}
+	m_Perm.resize(n);
+	for (size_t rx{}; rx < n; rx++)
+	{
+		m_Perm[rx] = rx;
+	}
+	m_Sign = 1;
+	m_Singular = false;
+	for (size_t k{}; k < n; k++)
+	{
+		size_t pivRow{k};
+		double amax{fabs(m_LU[k * n + k])};
+		for (size_t rx{k + 1}; rx < n; rx++)
+		{	// Scan below
+			const double val{fabs(m_LU[rx * n + k])};
+			if (val > amax)
+			{
+				amax = val;
+				pivRow = rx;
+			}
+		}
+		if (amax == 0.0)
+		{
+			m_Singular = true;
+			return false;
+		}
+		if (pivRow != k)
+		{
+			for (size_t cx{}; cx < n; cx++)
+			{
+				std::swap(m_LU[k * n + cx], m_LU[pivRow * n + cx]);
+			}
+			std::swap(m_Perm[k], m_Perm[pivRow]);
+			m_Sign = -m_Sign;
+		}
+		const double* rowK{&m_LU[k * n]};
+		for (size_t rx{k + 1}; rx < n; rx++)
+		{	// Clear column below
+			double* row{&m_LU[rx * n]};
+			const double f{row[k] / rowK[k]};
+			row[k] = f;
+			for (size_t cx{k + 1}; cx < n; cx++)
+			{
+				row[cx] -= f * rowK[cx];
+			}
+		}
+	}
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Solves A x = b for all columns of b.
+@precondition factorize() succeeded.
+@param      b: [in/out] n x numRhs, row major; replaced by the solutions.
+@param numRhs: Number of columns
+*******************************************************************************/
+void CLuFactor::solve(vector<double>& b, size_t numRhs) const
+{
+	const size_t n{m_N};
+	vector<double> x(n * numRhs);
+	for (size_t rx{}; rx < n; rx++)
+	{	// Forward substitution (L has unit diagonal), applies P
+		double* xr{&x[rx * numRhs]};
+		const double* br{&b[m_Perm[rx] * numRhs]};
+		for (size_t k{}; k < numRhs; k++)
+		{
+			xr[k] = br[k];
+		}
+		for (size_t cx{}; cx < rx; cx++)
+		{
+			const double l{m_LU[rx * n + cx]};
+			const double* xc{&x[cx * numRhs]};
+			for (size_t k{}; k < numRhs; k++)
+			{
+				xr[k] -= l * xc[k];
+			}
+		}
+	}
+	for (size_t rx{n}; rx-- > 0;)
+	{	// Back substitution
+		double* xr{&x[rx * numRhs]};
+		for (size_t cx{rx + 1}; cx < n; cx++)
+		{
+			const double u{m_LU[rx * n + cx]};
+			const double* xc{&x[cx * numRhs]};
+			for (size_t k{}; k < numRhs; k++)
+			{
+				xr[k] -= u * xc[k];
+			}
+		}
+		const double diag{m_LU[rx * n + rx]};
+		for (size_t k{}; k < numRhs; k++)
+		{
+			xr[k] /= diag;
+		}
+	}
+	b.swap(x);
+}
+
+/* METHOD *********************************************************************/
+/**
+  Solves A^T x = b (U^T, then L^T, then P^T).
+@precondition factorize() succeeded.
+@param b: [in/out] n elements; replaced by the solution.
+*******************************************************************************/
+void CLuFactor::solveTransposed(vector<double>& b) const
+{
+	const size_t n{m_N};
+	vector<double> w(b);
+	for (size_t rx{}; rx < n; rx++)
+	{	// U^T is lower triangular
+		for (size_t k{}; k < rx; k++)
+		{
+			w[rx] -= m_LU[k * n + rx] * w[k];
+		}
+		w[rx] /= m_LU[rx * n + rx];
+	}
+	for (size_t rx{n}; rx-- > 0;)
+	{	// L^T is upper triangular with unit diagonal
+		for (size_t k{rx + 1}; k < n; k++)
+		{
+			w[rx] -= m_LU[k * n + rx] * w[k];
+		}
+	}
+	for (size_t rx{}; rx < n; rx++)
+	{
+		b[m_Perm[rx]] = w[rx];
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Estimate of 1 / (|A| |A^-1|) in the 1-norm, 0 if singular. Close to
+  machine precision: results are unreliable.
+*******************************************************************************/
+double CLuFactor::rcond() const
+{
+	if (m_Singular || m_N == 0)
+	{
+		return 0.0;
+	}
+	const double normInv{estimateInverseNorm1(m_N, [this](vector<double>& b) { solve(b, 1); },
+		[this](vector<double>& b) { solveTransposed(b); })};
+	return normInv > 0.0 && m_Norm1 > 0.0 ? 1.0 / (m_Norm1 * normInv) : 0.0;
+}
+
+/* METHOD *********************************************************************/
+/**
+@precondition factorize() succeeded.
+@param inv: [out] Inverse matrix, row major
+*******************************************************************************/
+void CLuFactor::inverse(vector<double>& inv) const
+{
+	inv.assign(m_N * m_N, 0.0);
+	for (size_t rx{}; rx < m_N; rx++)
+	{
+		inv[rx * m_N + rx] = 1.0;
+	}
+	solve(inv, m_N);
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Determinant, 0 if singular
+*******************************************************************************/
+double CLuFactor::det() const
+{
+	if (m_Singular)
+	{
+		return 0.0;
+	}
+	double ret{double(m_Sign)};
+	for (size_t rx{}; rx < m_N; rx++)
+	{
+		ret *= m_LU[rx * m_N + rx];
+	}
+	return ret;
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Estimates |A^-1| in the 1-norm without forming the inverse (Hager's method
+  with Higham's refinements, as LAPACK xLACON): a few solves with A and A^T,
+  O(n^2) given the factors. The estimate is a lower bound, typically within
+  a factor of 3.
+@param            n: Size of A
+@param        solve: Replaces b by A^-1 b
+@param solveTransposed: Replaces b by A^-T b
+*******************************************************************************/
+double estimateInverseNorm1(size_t n, const std::function<void(vector<double>&)>& solve,
+	const std::function<void(vector<double>&)>& solveTransposed)
+{
+	const int MaxIterations{5};
+	auto norm1 = [](const vector<double>& v)
+	{
+		double ret{};
+		for (const double val : v)
+		{
+			ret += fabs(val);
+		}
+		return ret;
+	};
+	if (n == 0)
+	{
+		return 0.0;
+	}
+	vector<double> x(n, 1.0 / double(n));
+	vector<double> y(x);
+	solve(y);
+	double ret{norm1(y)};
+	for (int iter{}; n > 1 && iter < MaxIterations; iter++)
+	{	// Gradient of |A^-1 x| at x: A^-T sign(A^-1 x)
+		vector<double> z(n);
+		for (size_t ix{}; ix < n; ix++)
+		{
+			z[ix] = y[ix] >= 0.0 ? 1.0 : -1.0;
+		}
+		solveTransposed(z);
+		size_t jx{};
+		double zx{};
+		for (size_t ix{}; ix < n; ix++)
+		{
+			jx = fabs(z[ix]) > fabs(z[jx]) ? ix : jx;
+			zx += z[ix] * x[ix];
+		}
+		if (fabs(z[jx]) <= zx)
+		{	// Local maximum
+			break;
+		}
+		x.assign(n, 0.0);
+		x[jx] = 1.0;
+		y = x;
+		solve(y);
+		const double est{norm1(y)};
+		if (est <= ret)
+		{
+			break;
+		}
+		ret = est;
+	}
+	for (size_t ix{}; ix < n; ix++)
+	{	// Alternating vector, catches cancellation missed above
+		const double val{1.0 + double(ix) / double(std::max<size_t>(n - 1, 1))};
+		x[ix] = ix % 2 ? -val : val;
+	}
+	solve(x);
+	return std::max(ret, 2.0 * norm1(x) / (3.0 * double(n)));
+}
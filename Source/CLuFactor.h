@@ -0,0 +1,49 @@
+/******************************************************************************/
+/**
+@file         CLuFactor.h
+@copyright
+*
+@description  LU factorization of a real square matrix.
+*******************************************************************************/
+#ifndef CLUFACTOR_H
+#define CLUFACTOR_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/* FUNCTION DECLARATIONS ******************************************************/
+double estimateInverseNorm1(size_t n, const std::function<void(std::vector<double>&)>& solve,
+	const std::function<void(std::vector<double>&)>& solveTransposed);
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  P A = L U with partial pivoting (row exchanges as in matrix<T>::pivot(), a
+  column without nonzero pivot candidate makes the matrix singular).
+  One factorization serves any number of right hand side columns.
+  rcond() estimates the reciprocal condition in O(n^2) from the factors.
+  Independent of Qt.
+*******************************************************************************/
+class CLuFactor
+{
+	size_t m_N;
+	double m_Norm1;             // Of A, max. column sum
+	std::vector<double> m_LU;   // L (unit diagonal, not stored) and U, row major
+	std::vector<size_t> m_Perm; // Row rx of P A is row m_Perm[rx] of A
+	int m_Sign;                 // Of the permutation
+	bool m_Singular;
+public:
+	CLuFactor() : m_N(), m_Norm1(), m_LU(), m_Perm(), m_Sign(1), m_Singular(true) {}
+	bool factorize(const std::vector<double>& a, size_t n);
+	void solve(std::vector<double>& b, size_t numRhs) const;
+	void solveTransposed(std::vector<double>& b) const;
+	double rcond() const;
+	void inverse(std::vector<double>& inv) const;
+	double det() const;
+	size_t size() const { return m_N; }
+	bool singular() const { return m_Singular; }
+	double lu(size_t rx, size_t cx) const { return m_LU[rx * m_N + cx]; }
+	size_t perm(size_t rx) const { return m_Perm[rx]; }
+};
+
+#endif
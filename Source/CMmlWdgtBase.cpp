@@ -6,6 +6,7 @@
 @description  The widget displays a CFormula.
 *******************************************************************************/
 #include <cstdio>
+#include <functional>
 #include <QtGui/QBitmap>
 #include <QtGui/QPainter>
 #include <QtGui/QPaintEvent>
@@ -13,15 +14,36 @@
 #include <QtWidgets/QLayout>
 #include "CFormula.h"
 #include "CMmlWdgtBase.h"
+#include "CModelData.h"
+#include "CProfiler.h"
+#include "strutil.h"
 #include "Util.h"
 
+namespace
+{
+	/* FUNCTION *******************************************************************/
+	/**
+	  Paints the formula, vertically centered.
+	@param height: Height of the destination
+	@return Width of the formula
+	*******************************************************************************/
+	int paintFormula(QPainter& p, const CFormula& formula, const CModelData& mod, const QFont& font, int height)
+	{
+		p.setFont(font);
+		const QFontMetrics fm(p.fontMetrics());
+		p.translate(0, height/2 + fm.ascent()/3);
+		return formula.paint(p, mod);
+	}
+}
+
 /* METHOD *********************************************************************/
 /**
 *******************************************************************************/
 CMmlWdgtBase::CMmlWdgtBase(QWidget* parent)
 	: QWidget(parent)
 	, m_Formula()
-	, m_BaseFontPointSize(16)
+	, m_Pixmap()
+	, m_BaseFontPointSize(DefaultPointSize)
 	, m_TimerId()
 	, m_WidthFromPaint()
 	, m_WidthMin(m_BaseFontPointSize * 3.5)
@@ -54,17 +76,44 @@ void CMmlWdgtBase::clearFormula()
 	m_Formula.clear();
 }
 
-void CMmlWdgtBase::paintEvent(QPaintEvent* ev)
+/* METHOD *********************************************************************/
+/**
+@return Pixmap of the formula, rendered if content, size or pixelRatio changed.
+*******************************************************************************/
+const QPixmap& CFormulaPixmap::get(const CFormula& formula, const CModelData& mod, const QFont& font, const QSize& size,
+	qreal pixelRatio)
+{
+	const size_t key{std::hash<std::string>()(formula.paintKey(mod) + toString("|%d,%d,%g|", size.width(),
+		size.height(), double(pixelRatio)) + font.key().toStdString())};
+	if (key != m_Key || m_Pixmap.isNull())
+	{
+		PROFILE_COUNT("formulaRendered", 1);
+		m_Key = key;
+		m_Pixmap = QPixmap(size * pixelRatio);
+		m_Pixmap.setDevicePixelRatio(pixelRatio);
+		m_Pixmap.fill(Qt::transparent);
+		QPainter p(&m_Pixmap);
+		m_Width = paintFormula(p, formula, mod, font, size.height());
+	}
+	return m_Pixmap;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Event handler. The cached pixmap is used unless the cursor is displayed.
+*******************************************************************************/
+void CMmlWdgtBase::paintEvent(QPaintEvent*)
 {
 	QPainter p(this);
-    const QRect rct(ev->rect());
-    const int h0{rct.height()};
-	QFont font(p.font());
-	font.setPointSize(m_BaseFontPointSize);
-	p.setFont(font);
-    const QFontMetrics fm(p.fontMetrics());
-    p.translate(0, h0/2 + fm.ascent()/3);
-	m_WidthFromPaint = m_Formula.paint(p);
+	QFont fnt(font());
+	fnt.setPointSize(m_BaseFontPointSize);
+	if (m_Formula.showsCursor())
+	{	// Edited, blinking cursor
+		m_WidthFromPaint = paintFormula(p, m_Formula, model(), fnt, height());
+		return;
+	}
+	p.drawPixmap(0, 0, m_Pixmap.get(m_Formula, model(), fnt, size(), devicePixelRatioF()));
+	m_WidthFromPaint = m_Pixmap.width();
 }
 
 /* METHOD *********************************************************************/
@@ -8,6 +8,24 @@
 
 
 class CFormula;
+class CModelData;
+
+/* CLASS DECLARATION **********************************************************/
+/**
+ Rendered formula, repainted only when the formula content (see
+ CFormula::paintKey()), the size or the device pixel ratio changed.
+*******************************************************************************/
+class CFormulaPixmap
+{
+	QPixmap m_Pixmap;
+	size_t m_Key;     // Hash of paint key, size and pixel ratio
+	int m_Width;      // Width of the painted formula
+public:
+	CFormulaPixmap() : m_Pixmap(), m_Key(), m_Width() {}
+	const QPixmap& get(const CFormula&, const CModelData&, const QFont&, const QSize&, qreal pixelRatio);
+	int width() const { return m_Width; }
+	void clear() { m_Pixmap = QPixmap(); m_Key = 0; }
+};
 
 /* CLASS DECLARATION **********************************************************/
 /**
@@ -17,6 +35,7 @@ class CMmlWdgtBase : public QWidget
 {
 protected:
 	CFormula m_Formula;
+	CFormulaPixmap m_Pixmap; // Used unless a cursor is displayed
 	int m_BaseFontPointSize;
 	int m_TimerId;
 	int m_WidthFromPaint;
@@ -26,6 +45,7 @@ protected:
 	void focusOutEvent(QFocusEvent*) override;
 	void paintEvent(QPaintEvent*) override;
 public:
+	enum { DefaultPointSize = 16 };
 	CMmlWdgtBase(QWidget* parent);
 	virtual ~CMmlWdgtBase();
 	const CFormula& formula() const { return m_Formula; }
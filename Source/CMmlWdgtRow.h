@@ -5,46 +5,22 @@
 #include "CMmlWdgtBase.h"
 
 class CGuiMatrix;
-class CXmlCreator;
-class QDomElement;
-class QtMmlWidget;
 
 /* CLASS DECLARATION **********************************************************/
 /**
- GUI-counterpart of a model term.
- Displayed in CGuiMatrix column.
+ Editor of a model term (persistent editor of the current CGuiMatrix row).
+ Edits a copy of the term, changes are written back with CGuiMatrix::setTerm().
 *******************************************************************************/
 class CMmlWdgtRow : public CMmlWdgtBase
 {
-	bool   m_IsDotRow;
-	static CMmlWdgtRow* s_DragCandidate;
-	static CMmlWdgtRow* s_DraggedRow;
+	const int m_Row;
+	bool m_DragCandidate;
 public:
-	CMmlWdgtRow(QWidget* parent);
-	void assign(const CMmlWdgtRow*);
-	void clear();
-	void setComment(const std::string&);
-	std::string comment() const;
-	void updateToolTip();
-	void setIsDotRow();
-	bool isDotRow() const { return m_IsDotRow; }
-	int  getExp(size_t ixColumn) const;
-	int  getExpD() const;
-	 
-	void addToFormula(CGlyphBase*);
-	void setFormula(const CFormula&);
-	void permuteFields(const std::vector<size_t>& permutation);
+	CMmlWdgtRow(QWidget* parent, int row);
+	int  row() const { return m_Row; }
+	void reload();
 	void updateMml(bool toggleCsrState = false) override;
-	void addTestGlyphs(int ix);
-	const CFormula& formula() const { return m_Formula; }
-	void removeCoord(size_t index);
-	void removeField(size_t index);
-	 
-	void toXml(CXmlCreator&) const;
 protected:
-	void dragEnterEvent(QDragEnterEvent*) override;
-	void dropEvent(QDropEvent*) override;
-	void focusInEvent(QFocusEvent*) override;
 	void keyPressEvent(QKeyEvent*) override;
 	void mouseMoveEvent(QMouseEvent*) override;
 	void mousePressEvent(QMouseEvent*) override;
@@ -52,4 +28,3 @@ protected:
 };
 
 #endif
-
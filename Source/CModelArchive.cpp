@@ -0,0 +1,381 @@
+/******************************************************************************/
+/**
+@file         CModelArchive.cpp
+@copyright
+*
+@description  Model library packed into one compressed file.
+*******************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include "CModelArchive.h"
+#include "CProfiler.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+	const char Magic[4]{'K', 'X', 'A', '1'};   // Leads the file and ends the trailer
+	const qint64 TrailerSize{sizeof(qint64) + sizeof(Magic)}; // Offset of the index, magic
+	const int CompressionLevel{9};              // Packed once, read often
+
+	std::mutex g_Mutex;                          // Guards g_Open
+	std::map<string, std::shared_ptr<const CModelArchive>> g_Open; // Absolute path -> archive
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Calls work(ix) for ix < count on up to numThreads threads (0: one per core).
+	*******************************************************************************/
+	template <typename F> void parallelFor(size_t count, unsigned numThreads, const F& work)
+	{
+		if (numThreads == 0)
+		{
+			numThreads = std::max(1U, std::thread::hardware_concurrency());
+		}
+		std::atomic<size_t> next{0};
+		auto worker = [&]()
+		{
+			for (size_t ix{next++}; ix < count; ix = next++)
+			{
+				work(ix);
+			}
+		};
+		vector<std::thread> workers;
+		for (unsigned tx{1}; tx < std::min(size_t(numThreads), count); tx++)
+		{
+			workers.emplace_back(worker);
+		}
+		worker();
+		for (auto& thread : workers)
+		{
+			thread.join();
+		}
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Ctor
+*******************************************************************************/
+CModelArchive::CModelArchive()
+	: m_Path()
+	, m_FileTime()
+	, m_FileSize()
+	, m_Entries()
+	, m_File()
+	, m_Data()
+{
+}
+
+/* METHOD *********************************************************************/
+/**
+  Dtor
+*******************************************************************************/
+CModelArchive::~CModelArchive()
+{
+	if (m_Data)
+	{
+		m_File.unmap(const_cast<uchar*>(m_Data));
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+@return true if path names an archive file (not a directory)
+*******************************************************************************/
+bool CModelArchive::isArchive(const string& path)
+{
+	const QFileInfo info(path.c_str());
+	return info.suffix().compare("kxa", Qt::CaseInsensitive) == 0 && !info.isDir();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Splits the pathname of a member, e.g. "Data.kxa/Ising.kxm".
+@param   path: [out] Archive
+@param member: [out] Name of the member
+@return false if pathname is no member of an archive
+*******************************************************************************/
+bool CModelArchive::splitPathname(const string& pathname, string& path, string& member)
+{
+	const size_t pos{pathname.rfind(".kxa/")};
+	if (pos == string::npos || pos + 5 >= pathname.size() || pathname.find('/', pos + 5) != string::npos)
+	{
+		return false;
+	}
+	path = pathname.substr(0, pos + 4);
+	member = pathname.substr(pos + 5);
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Opens an archive, or returns the archive opened before if the file did not
+  change since. Thread-safe.
+@param errMsg: [out] Reason of a failure
+@return nullptr on failure
+*******************************************************************************/
+std::shared_ptr<const CModelArchive> CModelArchive::open(const string& path, string& errMsg)
+{
+	errMsg.clear();
+	const QFileInfo info(path.c_str());
+	const string absPath(info.absoluteFilePath().toStdString());
+	const long long time{info.lastModified().toMSecsSinceEpoch()};
+	std::lock_guard<std::mutex> lock(g_Mutex);
+	const auto it = g_Open.find(absPath);
+	if (it != g_Open.end() && it->second->m_FileTime == time && it->second->m_FileSize == info.size())
+	{
+		return it->second;
+	}
+	PROFILE_SCOPE("openArchive");
+	std::shared_ptr<CModelArchive> ret(std::make_shared<CModelArchive>());
+	ret->m_Path = absPath;
+	ret->m_FileTime = time;
+	ret->m_File.setFileName(absPath.c_str());
+	if (!ret->readIndex(errMsg))
+	{
+		g_Open.erase(absPath);
+		return nullptr;
+	}
+	g_Open[absPath] = ret;
+	return ret;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Maps the file, reads the index.
+@return false if the file is no valid archive
+*******************************************************************************/
+bool CModelArchive::readIndex(string& errMsg)
+{
+	if (!m_File.open(QIODevice::ReadOnly))
+	{
+		errMsg = "Cannot open " + m_Path;
+		return false;
+	}
+	m_FileSize = m_File.size();
+	m_Data = m_FileSize >= qint64(sizeof(Magic)) + TrailerSize ? m_File.map(0, m_FileSize) : nullptr;
+	if (!m_Data
+		|| memcmp(m_Data, Magic, sizeof(Magic)) != 0
+		|| memcmp(m_Data + m_FileSize - sizeof(Magic), Magic, sizeof(Magic)) != 0)
+	{
+		errMsg = "This is no Kanon archive: " + m_Path;
+		return false;
+	}
+	const qint64 trailerOffset{m_FileSize - TrailerSize};
+	qint64 indexOffset{};
+	QDataStream trailer(QByteArray::fromRawData(reinterpret_cast<const char*>(m_Data + trailerOffset), sizeof(qint64)));
+	trailer >> indexOffset;
+	if (indexOffset < qint64(sizeof(Magic)) || indexOffset > trailerOffset)
+	{
+		errMsg = "Damaged index in " + m_Path;
+		return false;
+	}
+	QDataStream index(QByteArray::fromRawData(reinterpret_cast<const char*>(m_Data + indexOffset),
+		int(trailerOffset - indexOffset)));
+	index.setVersion(QDataStream::Qt_5_0);
+	quint32 numEntry{};
+	index >> numEntry;
+	for (quint32 ex{}; ex < numEntry && index.status() == QDataStream::Ok; ex++)
+	{
+		QByteArray name;
+		qint64 time{};
+		SEntry entry{};
+		index >> name >> time >> entry.size >> entry.offset >> entry.packedSize;
+		entry.name = name.toStdString();
+		entry.time = time;
+		if (entry.offset < qint64(sizeof(Magic)) || entry.packedSize < 0 || entry.offset + entry.packedSize > indexOffset)
+		{
+			break;
+		}
+		m_Entries.push_back(entry);
+	}
+	if (index.status() != QDataStream::Ok || m_Entries.size() != numEntry)
+	{
+		errMsg = "Damaged index in " + m_Path;
+		return false;
+	}
+	std::sort(m_Entries.begin(), m_Entries.end(),
+		[](const SEntry& x, const SEntry& y) { return x.name < y.name; });
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Index of a member, entries().size() if none
+*******************************************************************************/
+size_t CModelArchive::find(const string& member) const
+{
+	const auto it = std::lower_bound(m_Entries.begin(), m_Entries.end(), member,
+		[](const SEntry& x, const string& name) { return x.name < name; });
+	return it != m_Entries.end() && it->name == member ? size_t(it - m_Entries.begin()) : m_Entries.size();
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Compressed member, valid as long as this
+*******************************************************************************/
+QByteArray CModelArchive::frame(size_t ix) const
+{
+	return QByteArray::fromRawData(reinterpret_cast<const char*>(m_Data + m_Entries[ix].offset),
+		int(m_Entries[ix].packedSize));
+}
+
+/* METHOD *********************************************************************/
+/**
+  Decompresses a member. Thread-safe.
+@param   data: [out] Content of the packed file
+@param errMsg: [out] Reason of a failure
+*******************************************************************************/
+bool CModelArchive::read(size_t ix, QByteArray& data, string& errMsg) const
+{
+	PROFILE_COUNT("membersDecompressed", 1);
+	data = qUncompress(m_Data + m_Entries[ix].offset, int(m_Entries[ix].packedSize));
+	if (data.size() != m_Entries[ix].size)
+	{
+		data.clear();
+		errMsg = "Damaged member " + pathname(ix);
+		return false;
+	}
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Decompresses members in parallel.
+@param numThreads: 0: One per core
+@return Contents in the order of ixs; null for damaged members (read(ix, ..)
+        tells the reason)
+*******************************************************************************/
+vector<QByteArray> CModelArchive::read(const vector<size_t>& ixs, unsigned numThreads) const
+{
+	PROFILE_SCOPE("readMembers");
+	vector<QByteArray> ret(ixs.size());
+	parallelFor(ixs.size(), numThreads, [&](size_t ix)
+	{
+		string errMsg;
+		read(ixs[ix], ret[ix], errMsg);
+	});
+	return ret;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Writes the *.kxm files of a directory into an archive. Members of an
+  existing archive whose file has the same modification time and size are
+  copied without compressing them again. The file is replaced when complete.
+@param           dir: Source directory
+@param          path: Archive, created or updated
+@param numCompressed: [out] Number of files read and compressed
+@param       errMsgs: [out] Appended, files which could not be read are skipped
+@return false if the archive could not be written
+*******************************************************************************/
+bool CModelArchive::pack(const string& dir, const string& path, size_t& numCompressed, vector<string>& errMsgs)
+{
+	PROFILE_SCOPE("packArchive");
+	numCompressed = 0;
+	struct SMember
+	{
+		SEntry entry;
+		QString file;
+		QByteArray frame;
+		string errMsg;
+	};
+	vector<SMember> members;
+	vector<size_t> changed;
+	{
+		std::shared_ptr<const CModelArchive> old;
+		if (QFileInfo(path.c_str()).isFile())
+		{	// Not an archive: replaced completely
+			string errMsg;
+			old = open(path, errMsg);
+		}
+		QDir source(dir.c_str(), "*.kxm");
+		source.setFilter(QDir::Files);
+		source.setSorting(QDir::Name);
+		const QFileInfoList files(source.entryInfoList());
+		for (const QFileInfo& info : files)
+		{
+			SMember member{};
+			member.entry.name = info.fileName().toStdString();
+			member.entry.time = info.lastModified().toMSecsSinceEpoch();
+			member.entry.size = info.size();
+			member.file = info.absoluteFilePath();
+			const size_t ix{old ? old->find(member.entry.name) : 0};
+			if (old && ix < old->m_Entries.size()
+				&& old->m_Entries[ix].time == member.entry.time && old->m_Entries[ix].size == member.entry.size)
+			{	// Deep copy, the old file gets replaced
+				member.frame = QByteArray(old->frame(ix).constData(), int(old->m_Entries[ix].packedSize));
+			}
+			else
+			{
+				changed.push_back(members.size());
+			}
+			members.push_back(member);
+		}
+	}
+	parallelFor(changed.size(), 0, [&](size_t cx)
+	{
+		SMember& member(members[changed[cx]]);
+		QFile file(member.file);
+		if (!file.open(QIODevice::ReadOnly))
+		{
+			member.errMsg = "Cannot open " + member.file.toStdString();
+			return;
+		}
+		const QByteArray data(file.readAll());
+		member.entry.size = data.size();
+		member.frame = qCompress(data, CompressionLevel);
+	});
+	numCompressed = changed.size();
+	{	// Unmap the old file before replacing it
+		std::lock_guard<std::mutex> lock(g_Mutex);
+		g_Open.erase(QFileInfo(path.c_str()).absoluteFilePath().toStdString());
+	}
+	QSaveFile out(path.c_str());
+	if (!out.open(QIODevice::WriteOnly))
+	{
+		errMsgs.push_back("Cannot write " + path);
+		return false;
+	}
+	out.write(Magic, sizeof(Magic));
+	vector<const SEntry*> entries;
+	for (auto& member : members)
+	{
+		if (!member.errMsg.empty())
+		{
+			errMsgs.push_back(member.errMsg);
+			continue;
+		}
+		member.entry.offset = out.pos();
+		member.entry.packedSize = member.frame.size();
+		out.write(member.frame);
+		entries.push_back(&member.entry);
+	}
+	const qint64 indexOffset{out.pos()};
+	QDataStream index(&out);
+	index.setVersion(QDataStream::Qt_5_0);
+	index << quint32(entries.size());
+	for (const SEntry* entry : entries)
+	{
+		index << QByteArray(entry->name.c_str()) << qint64(entry->time) << entry->size << entry->offset
+			<< entry->packedSize;
+	}
+	index << indexOffset;
+	out.write(Magic, sizeof(Magic));
+	if (!out.commit())
+	{
+		errMsgs.push_back("Cannot write " + path);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,66 @@
+/******************************************************************************/
+/**
+@file         CModelArchive.h
+@copyright
+*
+@description  Model library packed into one compressed file.
+*******************************************************************************/
+#ifndef CMODELARCHIVE_H
+#define CMODELARCHIVE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Archive of *.kxm files (extension ".kxa"): one zlib frame per member (see
+  qCompress()), followed by an index of the members and a trailer locating
+  the index. open() reads the index only; the file is mapped, members are
+  decompressed on demand, read() several of them in parallel.
+  Members are addressed like files of a directory: "<archive>/<member>" (see
+  splitPathname()), so CModelData::loadLibrary() accepts an archive or a
+  directory. pack() reuses the frames of members whose file did not change.
+  Archives are read-only for the GUI.
+*******************************************************************************/
+class CModelArchive
+{
+public:
+	struct SEntry
+	{
+		std::string name;        // Member, e.g. "Ising.kxm"
+		long long time;          // Modification time of the packed file (ms since epoch)
+		qint64 size;             // Of the file
+		qint64 offset;           // Of the frame
+		qint64 packedSize;       // Of the frame
+	};
+private:
+	std::string m_Path;          // Absolute
+	long long m_FileTime;        // Of the archive when opened
+	qint64 m_FileSize;
+	std::vector<SEntry> m_Entries; // Sorted by name
+	QFile m_File;
+	const uchar* m_Data;         // Mapped m_File
+	CModelArchive(const CModelArchive&) = delete;
+	CModelArchive& operator=(const CModelArchive&) = delete;
+	bool readIndex(std::string& errMsg);
+	QByteArray frame(size_t ix) const;
+public:
+	CModelArchive();
+	~CModelArchive();
+	static bool isArchive(const std::string& path);
+	static bool splitPathname(const std::string& pathname, std::string& path, std::string& member);
+	static std::shared_ptr<const CModelArchive> open(const std::string& path, std::string& errMsg);
+	static bool pack(const std::string& dir, const std::string& path, size_t& numCompressed,
+		std::vector<std::string>& errMsgs);
+	const std::string& path() const { return m_Path; }
+	const std::vector<SEntry>& entries() const { return m_Entries; }
+	std::string pathname(size_t ix) const { return m_Path + '/' + m_Entries[ix].name; }
+	size_t find(const std::string& member) const;
+	bool read(size_t ix, QByteArray& data, std::string& errMsg) const;
+	std::vector<QByteArray> read(const std::vector<size_t>& ixs, unsigned numThreads = 0) const;
+};
+
+#endif
@@ -1,15 +1,27 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdio>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QStringList>
 #include <QtWidgets/QMessageBox>
 #include <QtXml/QDomNode>
 #include "CFormatFloat.h"
 #include "CFormula.h"
 #include "CGlyph.h"
 #include "CGuiMatrix.h"
+#include "CModelArchive.h"
 #include "CModelData.h"
 #include "CModelData.h"
 #include "CNumerics.h"
+#include "CProfiler.h"
+#include "CReadAhead.h"
 #include "CXmlCreator.h"
 #include "strutil.h"
 #include "Util.h"
@@ -27,43 +39,172 @@ namespace
 	};
 	 
 	const string g_FileVersionKanon("4");
-	bool g_Ascending{};
+	std::map<string, long long> g_RejectedFiles; // Library files which failed to load -> modification time
 	 
+	long long fileTime(const QFileInfo& info)
+	{
+		return info.lastModified().toMSecsSinceEpoch();
+	}
+	 
+	struct SLibraryFile
+	{
+		string pathname;
+		long long time;                   // Modification time (ms since epoch)
+		size_t member;                    // Index in the archive, if any
+	};
+	// *.kxm files of a directory or members of an archive, sorted by pathname
+	std::vector<SLibraryFile> libraryFiles(const string& path, std::shared_ptr<const CModelArchive>& archive,
+		std::vector<string>& errMsgs)
+	{
+		std::vector<SLibraryFile> ret;
+		archive.reset();
+		if (CModelArchive::isArchive(path))
+		{
+			string errMsg;
+			archive = CModelArchive::open(path, errMsg);
+			if (!archive)
+			{
+				errMsgs.push_back(errMsg);
+				return ret;
+			}
+			for (size_t ix{}; ix < archive->entries().size(); ix++)
+			{
+				ret.push_back({archive->pathname(ix), archive->entries()[ix].time, ix});
+			}
+			return ret;
+		}
+		QDir dir(path.c_str(), "*.kxm");
+		dir.setFilter(QDir::Files);
+		dir.setSorting(QDir::Name);
+		const QFileInfoList fileInfo(dir.entryInfoList());
+		for (int fx{}; fx < fileInfo.size(); ++fx)
+		{
+			ret.push_back({fileInfo.at(fx).absoluteFilePath().toStdString(), fileTime(fileInfo.at(fx)), 0});
+		}
+		return ret;
+	}
+	// Members of files decompressed in parallel, none for a directory
+	std::vector<QByteArray> readMembers(const CModelArchive* archive, const std::vector<SLibraryFile>& files)
+	{
+		std::vector<size_t> members;
+		for (const auto& file : files)
+		{
+			members.push_back(file.member);
+		}
+		return archive ? archive->read(members) : std::vector<QByteArray>();
+	}
+	// Files of a directory, read ahead in the order of files; none of an archive
+	std::vector<string> readAheadFiles(const CModelArchive* archive, const std::vector<SLibraryFile>& files)
+	{
+		std::vector<string> ret;
+		for (size_t fx{}; !archive && fx < files.size(); fx++)
+		{
+			ret.push_back(files[fx].pathname);
+		}
+		return ret;
+	}
+	// Content of files[fx], see loadEntry(); nullptr: read by loadData()
+	const QByteArray* libraryFileData(const std::vector<QByteArray>& members, CReadAhead& reader, size_t fx,
+		QByteArray& data)
+	{
+		if (!members.empty())
+		{
+			return &members[fx];
+		}
+		return reader.next(data) ? &data : nullptr;
+	}
+	// Parses a model file or an archive member, data: Content read before or nullptr.
+	// Returns the modification time, 0 if data given (known to the caller).
+	long long openModel(QDomDocument& doc, const string& pathname, const QByteArray* data)
+	{
+		if (data && !data->isNull())
+		{
+			xmlParse(doc, *data, pathname.c_str());
+			return 0;
+		}
+		string path, member;
+		if (!CModelArchive::splitPathname(pathname, path, member))
+		{
+			xmlOpen(doc, pathname.c_str());
+			return fileTime(QFileInfo(pathname.c_str()));
+		}
+		string errMsg;
+		const std::shared_ptr<const CModelArchive> archive(CModelArchive::open(path, errMsg));
+		if (!archive)
+		{
+			throwError(errMsg);
+		}
+		const size_t ix{archive->find(member)};
+		if (ix >= archive->entries().size())
+		{
+			throwError("Cannot open " + pathname);
+		}
+		QByteArray content;
+		if (!archive->read(ix, content, errMsg))
+		{
+			throwError(errMsg);
+		}
+		xmlParse(doc, content, pathname.c_str());
+		return archive->entries()[ix].time;
+	}
+	bool ltPathname(const CModelData& x, const CModelData& y) {
+		return x.pathname() < y.pathname();
+	}
+	 
+	// Ascending, for CModelData::lessThan()
 	bool ltName(const CModelData& x, const CModelData& y) {
-		return (g_Ascending && 0 > cmpstri(x.name(), y.name()))
-			|| (!g_Ascending && 0 < cmpstri(x.name(), y.name()));
+		return 0 > cmpstri(x.name(), y.name());
 	}
 	bool ltNumCoord(const CModelData& x, const CModelData& y) {
-		return (g_Ascending && x.numCoord() < y.numCoord())
-			|| (!g_Ascending && x.numCoord() > y.numCoord());
+		return x.numCoord() < y.numCoord();
 	}
 	bool ltDimension(const CModelData& x, const CModelData& y) {
-		return (g_Ascending && x.critDim() < y.critDim())
-			 || (!g_Ascending && x.critDim() > y.critDim());
+		return x.critDim() < y.critDim();
 	}
 	bool ltNumField(const CModelData& x, const CModelData& y) {
-		return (g_Ascending && x.numField() < y.numField())
-			 || (!g_Ascending && x.numField() > y.numField());
+		return x.numField() < y.numField();
 	}
 	bool ltOrder(const CModelData& x, const CModelData& y) {
-		return (g_Ascending && x.modelOrder() < y.modelOrder())
-			 || (!g_Ascending && x.modelOrder() > y.modelOrder());
+		return x.modelOrder() < y.modelOrder();
 	}
 	bool ltNormalVect(const CModelData& x, const CModelData& y) {
-		return (g_Ascending && 0 > cmpstri(x.printSortedNormalVector(), y.printSortedNormalVector()))
-			 || (!g_Ascending && 0 < cmpstri(x.printSortedNormalVector(), y.printSortedNormalVector()));
+		return 0 > x.displayText(CModelData::colNormalVect).compare(y.displayText(CModelData::colNormalVect),
+			Qt::CaseInsensitive);
 	}
 	bool ltTag(const CModelData& x, const CModelData& y) {
-		return (g_Ascending && 0 > cmpstri(x.category(), y.category()))
-		 || (!g_Ascending && 0 < cmpstri(x.category(), y.category()));
+		return 0 > cmpstri(x.category(), y.category());
 	}
 	bool ltFlags(const CModelData& x, const CModelData& y) {
-		return (g_Ascending && 0 > cmpstri(x.flags(), y.flags()))
-			|| (!g_Ascending && 0 < cmpstri(x.flags(), y.flags()));
+		return 0 > x.displayText(CModelData::colFlags).compare(y.displayText(CModelData::colFlags),
+			Qt::CaseInsensitive);
+	}
+	 
+	// Shared cell texts: list entries with equal values share one string buffer.
+	const QString& internNumber(size_t val)
+	{
+		static std::vector<QString> s_Numbers;
+		while (s_Numbers.size() <= val)
+		{
+			s_Numbers.push_back(QString::number(s_Numbers.size()));
+		}
+		return s_Numbers[val];
+	}
+	const QString& internString(const string& text)
+	{
+		static std::unordered_map<string, QString> s_Strings;
+		const auto it = s_Strings.find(text);
+		if (it != s_Strings.end())
+		{
+			return it->second;
+		}
+		return s_Strings[text] = QString::fromUtf8(text.c_str());
 	}
 }
 
 bool CModelData::s_LoadingFile(false);
+string CModelData::s_LibraryPath;
+CSignatureIndex CModelData::s_Index;
+bool CModelData::s_IndexValid(false);
 // Define column names and number of columns to display
 DECLARE_TABLE(CModelData, "Models", " #Coord | #Field | Order | Crit. dim. | Normal vect. | Name | Tag | Category")
 
@@ -83,6 +224,7 @@ CModelData& model()
 *******************************************************************************/
 CModelData::CModelData(bool isSingleton)
 	: m_IsSingleton(isSingleton)
+	, m_HeaderOnly()
 	, m_Dirty()
 	, m_Dynamics()
 	, m_ReactionDiffusion()
@@ -90,6 +232,8 @@ CModelData::CModelData(bool isSingleton)
 	, m_QuantumFieldTheory()
 	, m_CritDim(CNumerics::INVALID_CRITDIM)
 	, m_Rank(-1)
+	, m_RxInteraction(-1)
+	, m_FileTime()
 	, m_Comment()
 	, m_Name()
 	, m_Pathname()
@@ -98,8 +242,13 @@ CModelData::CModelData(bool isSingleton)
 	, m_Monomials()
 	, m_Coords()
 	, m_Fields()
+	, m_ExpMatrix()
+	, m_SigmaMatrix()
+	, m_CanonicalHash()
 	, m_NormalVect()
 	, m_CanDim()
+	, m_Solver()
+	, m_Display()
 {
 	insertDefaultCoordField();
 }
@@ -130,53 +279,100 @@ QVariant CModelData::data(const QModelIndex& index, int role)
 {
 	if (index.isValid() && role == Qt::DisplayRole)
 	{
-		const CModelData& mod(at(index.row()));
-		switch (index.column())
+		if (index.column() < 0 || index.column() >= numColumn)
 		{
-		case colNumCoord:   return QString::number(mod.m_Coords.size());
-		case colNumField:   return QString::number(mod.m_Fields.size());
-		case colOrder:      return QString::number(mod.modelOrder());
-		case colDimension:  return QString::number(mod.m_CritDim);
-		case colNormalVect: return mod.printSortedNormalVector().c_str();
-		case colName:       return mod.m_Name.c_str();
-		case colTag:        return mod.m_UserTag.c_str();
-		case colFlags:      return mod.flags().c_str();
-		default:            return "??";
+			return "??";
 		}
+		return at(index.row()).displayText(index.column());
 	}
 	return QVariant();
 }
 
 /* METHOD *********************************************************************/
 /**
-  Called from Qt.
-*
-@param :
+  Normal vector and flags are built through temporary strings: they are
+  kept until the entry changes (see invalidateDisplay()). Interned texts
+  (counts, tags) are shared by all entries; name and dimension are
+  converted on each call.
+@param col: colNumCoord...colFlags
+@return Cell text
 *******************************************************************************/
-void CModelData::sort(int column, Qt::SortOrder order)
+QString CModelData::displayText(int col) const
 {
-	g_Ascending = order == Qt::AscendingOrder;
-	if (column == -1)
+	if (!m_Display.valid && (col == colNormalVect || col == colFlags))
 	{
-		column = s_SortColumn;
+		PROFILE_COUNT("displayTextsBuilt", 1);
+		m_Display.normalVect = internString(printSortedNormalVector());
+		m_Display.flags = internString(flags());
+		m_Display.valid = true;
 	}
-	else
+	switch (col)
+	{
+	case colNumCoord:
+		return internNumber(m_Coords.size());
+	case colNumField:
+		return internNumber(m_Fields.size());
+	case colOrder:
+		return internNumber(modelOrder());
+	case colDimension:
+		return QString::number(m_CritDim);
+	case colNormalVect:
+		return m_Display.normalVect;
+	case colName:
+		return QString::fromUtf8(m_Name.c_str());
+	case colTag:
+		return internString(m_UserTag);
+	case colFlags:
+		return m_Display.flags;
+	}
+	return QString();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Called from Qt (see CQTableModel::sort()). The list stays sorted by pathname,
+  views sort via a proxy model (see lessThan()); only the column is kept.
+*******************************************************************************/
+void CModelData::sort(int column, Qt::SortOrder)
+{
+	if (column >= 0)
 	{
 		s_SortColumn = column;
 	}
-	std::vector <CModelData>::iterator it0(array().begin()), itn(array().end());
+}
+
+/* METHOD *********************************************************************/
+/**
+  Ascending comparison for a column, used by the proxy model of the model list
+  (which handles descending order itself).
+@return true if x is sorted before y
+*******************************************************************************/
+bool CModelData::lessThan(int column, const CModelData& x, const CModelData& y)
+{
 	switch (column)
 	{
-	case colDimension:  std::stable_sort(it0, itn, ltDimension); break;
-	case colFlags:      std::stable_sort(it0, itn, ltFlags); break;
-	case colName:       std::stable_sort(it0, itn, ltName); break;
-	case colNormalVect: std::stable_sort(it0, itn, ltNormalVect); break;
-	case colNumCoord:   std::stable_sort(it0, itn, ltNumCoord); break;
-	case colNumField:   std::stable_sort(it0, itn, ltNumField); break;
-	case colOrder:      std::stable_sort(it0, itn, ltOrder); break;
-	case colTag:        std::stable_sort(it0, itn, ltTag); break;
-	default: break;
-  }
+	case colDimension:  return ltDimension(x, y);
+	case colFlags:      return ltFlags(x, y);
+	case colName:       return ltName(x, y);
+	case colNormalVect: return ltNormalVect(x, y);
+	case colNumCoord:   return ltNumCoord(x, y);
+	case colNumField:   return ltNumField(x, y);
+	case colOrder:      return ltOrder(x, y);
+	case colTag:        return ltTag(x, y);
+	default:            return false;
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Index of the list entry of a file (the list is sorted by pathname,
+        see loadLibrary()), or size().
+*******************************************************************************/
+size_t CModelData::find(const string& pathname)
+{
+	const auto it(std::lower_bound(array().begin(), array().end(), pathname,
+		[](const CModelData& x, const string& y) { return x.pathname() < y; }));
+	return it != array().end() && it->pathname() == pathname ? size_t(it - array().begin()) : size();
 }
 
 /* METHOD *********************************************************************/
@@ -185,6 +381,7 @@ void CModelData::sort(int column, Qt::SortOrder order)
 void CModelData::setDirty()
 {
 	m_Dirty = true;
+	invalidateDisplay();
 }
 
 size_t CModelData::modelOrder() const
@@ -198,7 +395,7 @@ size_t CModelData::numTerm() const
 	{
 		return guiMatrix().numTerm();
 	}
-	return m_Monomials.size();
+	return m_ExpMatrix.numTerm();
 }
 
 void CModelData::removeCoord(size_t cx)
@@ -206,12 +403,14 @@ void CModelData::removeCoord(size_t cx)
 	throwAssert("removeCoord()", cx < m_Coords.size());
 	m_Coords.erase(m_Coords.begin() + cx);
 	m_Dirty = true;
+	invalidateDisplay();
 }
 void CModelData::removeField(size_t fx)
 {
 	throwAssert("removeField()", fx < m_Fields.size());
 	m_Fields.erase(m_Fields.begin() + fx);
 	m_Dirty = true;
+	invalidateDisplay();
 }
 
 /* METHOD *********************************************************************/
@@ -238,7 +437,7 @@ int CModelData::getExp(size_t tx, size_t cx) const
 		return guiMatrix().getExp(tx, cx);
 	}
 	throwAssert("getExp()", tx < numTerm() && cx < modelOrder());
-	return m_Monomials[tx].getExp(cx, *this);
+	return m_ExpMatrix.getExp(tx, cx);
 }
 
 int CModelData::getExpD(size_t tx) const
@@ -248,7 +447,116 @@ int CModelData::getExpD(size_t tx) const
 		return guiMatrix().getExpD(tx);
 	}
 	throwAssert("getExpD()", tx < numTerm());
-	return m_Monomials[tx].getExpD();
+	return m_ExpMatrix.getExpD(tx);
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Exponents of all terms (the singleton copies them from CGuiMatrix)
+*******************************************************************************/
+CExpMatrix CModelData::expMatrix() const
+{
+	if (!m_IsSingleton)
+	{
+		return m_ExpMatrix;
+	}
+	CExpMatrix matrix(numCoord(), numField());
+	std::vector<int> exp(modelOrder());
+	for (size_t tx{}; tx < numTerm(); tx++)
+	{
+		for (size_t cx{}; cx < exp.size(); cx++)
+		{
+			exp[cx] = getExp(tx, cx);
+		}
+		matrix.addTerm(exp, getExpD(tx));
+	}
+	return matrix;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Coefficients of sigma in the exponents (see CSigmaSweep), as expMatrix()
+*******************************************************************************/
+CExpMatrix CModelData::sigmaMatrix() const
+{
+	if (!m_IsSingleton)
+	{
+		return m_SigmaMatrix;
+	}
+	CExpMatrix matrix(numCoord(), numField());
+	std::vector<int> exp(modelOrder());
+	for (size_t tx{}; tx < numTerm(); tx++)
+	{
+		for (size_t cx{}; cx < exp.size(); cx++)
+		{
+			exp[cx] = guiMatrix().getExpSigma(tx, cx);
+		}
+		matrix.addTerm(exp, 0);
+	}
+	return matrix;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Critical and canonical dimensions are determined at sigma = 0 (sigma only
+  enters CSigmaSweep).
+@return true if sigma enters an exponent
+*******************************************************************************/
+bool CModelData::hasSigma() const
+{
+	const std::vector<int>& exps(sigmaMatrix().exps());
+	return std::any_of(exps.begin(), exps.end(), [](int exp) { return exp != 0; });
+}
+
+/* METHOD *********************************************************************/
+/**
+  The index is rebuilt on first use after the list changed (O(n log n)),
+  queries then take O(1) (normal vector) or O(log n + k) (critical dimension).
+@return Index over the model list
+*******************************************************************************/
+const CSignatureIndex& CModelData::signatureIndex()
+{
+	if (!s_IndexValid)
+	{
+		PROFILE_SCOPE("signatureIndex");
+		s_Index.clear();
+		for (size_t ix{}; ix < size(); ix++)
+		{
+			const CModelData& mod(at(ix));
+			const bool valid{mod.m_CritDim > CNumerics::INVALID_CRITDIM};
+			s_Index.add(ix, mod.m_NormalVect, mod.numCoord(),
+				valid ? mod.m_CritDim : std::numeric_limits<double>::quiet_NaN());
+		}
+		s_Index.finish();
+		s_IndexValid = true;
+	}
+	return s_Index;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Groups the list entries by canonicalHash() (one pass, no pairwise comparison).
+@return Groups of indices (into the list) of equivalent models, each with
+  at least two entries
+*******************************************************************************/
+std::vector<std::vector<size_t>> CModelData::duplicates()
+{
+	PROFILE_SCOPE("duplicates");
+	std::unordered_map<SHash128, std::vector<size_t>, SHash128::Hasher> groups;
+	for (size_t ix{}; ix < size(); ix++)
+	{
+		groups[at(ix).canonicalHash()].push_back(ix);
+	}
+	std::vector<std::vector<size_t>> result;
+	for (auto& group : groups)
+	{
+		if (group.second.size() > 1)
+		{
+			result.push_back(std::move(group.second));
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
 }
 
 string CModelData::getCoordsFieldsList() const
@@ -372,7 +680,7 @@ string CModelData::printHtmlDimensionOfCouplingConst(size_t tx) const
 	const double constCanDim(getDimensionOfCouplingConst(&dCanDim, tx));
 	// Use: dim = constCanDim + (m_CritDim-eps)*dCanDim.
 	const double dim(constCanDim + m_CritDim*dCanDim);
-	return CFormatFloat::bilinear(dim, -dCanDim, eFormatHtml).toStdString();
+	return CFormatFloat::bilinearHtml(dim, -dCanDim);
 }
 
 /* METHOD *********************************************************************/
@@ -388,6 +696,43 @@ double CModelData::getDimensionAtCritDim(size_t cx) const
 	return m_CanDim[cx].constVal + m_CanDim[cx].dVal * m_CritDim;
 }
 
+/* METHOD *********************************************************************/
+/**
+  Enumerates the candidate terms up to the given limits and classifies them at
+  the critical dimension. Response fields are required in each term of a
+  dynamic functional, a non-response field for reaction diffusion models
+  (absorbing state). Quantum field theories get derivatives in pairs.
+@precondition Canonical dimensions determined
+@param     maxDegree: Maximal sum of field exponents
+@param maxDerivative: Maximal number of derivatives
+*******************************************************************************/
+COperatorEnum CModelData::enumerateOperators(unsigned maxDegree, unsigned maxDerivative) const
+{
+	PROFILE_SCOPE("enumerateOperators");
+	if (m_CanDim.size() != 1 + numTerm())
+	{
+		throwError("Canonical dimensions not available");
+	}
+	const COperatorEnum::SSettings settings{maxDegree, maxDerivative, true, m_QuantumFieldTheory,
+		m_Dynamics || m_ReactionDiffusion, m_ReactionDiffusion};
+	vector<bool> responseField;
+	for (size_t cx{numCoord()}; cx < modelOrder(); cx++)
+	{
+		responseField.push_back(isResponseField(cx));
+	}
+	COperatorEnum ops(settings, numCoord(), responseField);
+	ops.enumerate();
+	vector<double> dimAtCritDim, dVal;
+	for (size_t cx{}; cx < modelOrder(); cx++)
+	{
+		dimAtCritDim.push_back(getDimensionAtCritDim(cx));
+		dVal.push_back(m_CanDim[cx].dVal);
+	}
+	ops.classify(dimAtCritDim, dVal, m_CritDim);
+	PROFILE_COUNT("operators", ops.size());
+	return ops;
+}
+
 /* METHOD *********************************************************************/
 /**
 *******************************************************************************/
@@ -409,6 +754,7 @@ void CModelData::setTag(const std::string& text)
 	{
 		m_Dirty = true;
 		m_UserTag = text;
+		invalidateDisplay();
 	}
 }
 
@@ -485,6 +831,7 @@ const CGlyphCoordField& CModelData::glyphCoordField(size_t index, ECoordField ty
 *******************************************************************************/
 void CModelData::setGlyphCoordField(size_t cx, ECoordField type, const CGlyphCoordField& glyph)
 {
+	invalidateDisplay();
 	if (type == eCoord)
 	{
 		if (cx < m_Coords.size())
@@ -516,7 +863,8 @@ void CModelData::setGlyphCoordField(size_t cx, ECoordField type, const CGlyphCoo
 *******************************************************************************/
 bool CModelData::determineCritDim(double& critDim)
 {
-	if (CNumerics::determineCritDim(m_CritDim, *this))
+	invalidateDisplay();
+	if (CNumerics::determineCritDim(m_CritDim, expMatrix()))
 	{
 		critDim = m_CritDim;
 		return true;
@@ -533,12 +881,21 @@ bool CModelData::determineCritDim(double& critDim)
 *******************************************************************************/
 bool CModelData::determineCanonicalDimensions(size_t rxOfCoupling)
 {
+	invalidateDisplay();
 	m_CanDim.clear();
+	const CExpMatrix exps(expMatrix());
 	// Determine rank first: evaluate() may throw.
-	m_Rank = CNumerics::determineRank(*this);
-	if (CNumerics::determineCritDim(m_CritDim, *this))
+	m_Rank = CNumerics::determineRank(exps);
+	if (CNumerics::determineCritDim(m_CritDim, exps))
 	{
-		CNumerics::determineCanonicalDimensions(m_CritDim, m_CanDim, *this, rxOfCoupling);
+		if (m_IsSingleton)
+		{	// Edited: terms are reordered by drag/drop
+			m_Solver.determineCanonicalDimensions(m_CritDim, m_CanDim, exps, int(rxOfCoupling));
+		}
+		else
+		{
+			CNumerics::determineCanonicalDimensions(m_CritDim, m_CanDim, exps, rxOfCoupling);
+		}
 		return true;
 	}
 	return false;
@@ -546,66 +903,305 @@ bool CModelData::determineCanonicalDimensions(size_t rxOfCoupling)
 
 /* METHOD *********************************************************************/
 /**
-  Determines the normal vector (=Signature). The normal vector is a modelOrder()-
-  dimensional vector, the components of which are the dimensions of the coordinates
-  and fields (Multiplied with a common factor to get integer values).
-  The 1st component denotes D-dimensional space.
-@precondition determineCanonicalDimensions()
-@side_effects m_NormalVect
+@precondition determineCanonicalDimensions(rxOfCoupling)
+@return Reciprocal condition of E1, see CNumerics::reciprocalCondition()
 *******************************************************************************/
-void CModelData::determineNormalVector()
+double CModelData::reciprocalCondition(size_t rxOfCoupling) const
 {
-	m_NormalVect.clear();
-	throwAssert("determineNormalVector() failed.\n"
-		"You might select another term of the first " + toString(int(modelOrder())) + "\n"
-		"terms of the Lagrangian as interaction and try again.",
-		m_CanDim.size() == 1 + numTerm());
-	double common{};
-	double val{};
-	for (size_t fx{}; fx < modelOrder(); fx++)
+	if (m_IsSingleton)
+	{
+		return m_Solver.reciprocalCondition(expMatrix(), int(rxOfCoupling));
+	}
+	return CNumerics::reciprocalCondition(m_ExpMatrix, int(rxOfCoupling));
+}
+
+/* METHOD *********************************************************************/
+/**
+  Determines critical dimension, canonical dimensions and normal vector.
+  The terms of the model are attempted as interaction until one works.
+@return true on success
+*******************************************************************************/
+bool CModelData::evaluate()
+{
+	SEvaluation result{m_CritDim, m_Rank, std::vector<SCanDim>(), std::vector<int>(), -1};
+	result.canDim.swap(m_CanDim);
+	result.normalVect.swap(m_NormalVect);
+	const bool ok{CNumerics::evaluate(expMatrix(), result)};
+	setResult(result);
+	return ok;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Takes over the results of CNumerics::evaluate().
+*******************************************************************************/
+void CModelData::setResult(SEvaluation& result)
+{
+	m_CritDim = result.critDim;
+	m_Rank = result.rank;
+	m_RxInteraction = result.rxInteraction;
+	m_CanDim.swap(result.canDim);
+	m_NormalVect.swap(result.normalVect);
+	invalidateDisplay();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Restores coordinates, fields and results of an earlier state (undo/redo,
+  see CEditHistory), without evaluating.
+*******************************************************************************/
+void CModelData::restore(const std::vector<CGlyphCoordField>& coords, const std::vector<CGlyphCoordField>& fields,
+	const SEvaluation& result)
+{
+	m_Coords = coords;
+	m_Fields = fields;
+	SEvaluation copy(result);
+	setResult(copy);
+	m_Dirty = true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Fills the model list with the (evaluated) *.kxm files of a directory (read
+  ahead of the parser on a thread, see CReadAhead), or the members of an
+  archive (decompressed in parallel, see CModelArchive).
+  The list is sorted by pathname, views sort and filter via a proxy model.
+@param    path: Directory or archive
+@param errMsgs: [out] Error messages (the GUI must not open message boxes here).
+*******************************************************************************/
+void CModelData::loadLibrary(const string& path, std::vector<string>& errMsgs)
+{
+	PROFILE_SCOPE("loadLibrary");
+	clear();
+	g_RejectedFiles.clear();
+	s_LibraryPath = path;
+	std::shared_ptr<const CModelArchive> archive;
+	const std::vector<SLibraryFile> files(libraryFiles(path, archive, errMsgs));
+	const std::vector<QByteArray> contents(readMembers(archive.get(), files));
+	CReadAhead reader(readAheadFiles(archive.get(), files));
+	for (size_t fx{}; fx < files.size(); ++fx)
 	{
-		const double EPS{0.01};
-		if (val > EPS)
+		QByteArray content;
+		CModelData data;
+		if (data.loadEntry(files[fx].pathname, files[fx].time, errMsgs, false,
+			libraryFileData(contents, reader, fx, content)))
 		{
-			common = val;
+			data.Pk = createPk(array());
+			push_back(data);
+		}
+	}
+	evaluateAll();
+	std::stable_sort(array().begin(), array().end(), ltPathname);
+	s_IndexValid = false;
+	updateView();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Applies changes of the directory to the model list: Only new and modified
+  files are loaded, entries of deleted files are removed. The view is notified
+  row by row, so filter, sort order and selection are kept. Of an archive,
+  only the index is read; modified members are decompressed in parallel.
+  Calls loadLibrary() if path was not loaded before.
+@param    path: Directory or archive
+@param errMsgs: [out] Error messages
+@return true when the list changed
+*******************************************************************************/
+bool CModelData::refreshLibrary(const string& path, std::vector<string>& errMsgs)
+{
+	if (path != s_LibraryPath || !std::is_sorted(array().begin(), array().end(), ltPathname))
+	{
+		loadLibrary(path, errMsgs);
+		return true;
+	}
+	PROFILE_SCOPE("refreshLibrary");
+	std::shared_ptr<const CModelArchive> archive;
+	std::set<string> pathnames;
+	std::vector<SLibraryFile> modified;
+	for (const auto& file : libraryFiles(path, archive, errMsgs))
+	{
+		const auto it(g_RejectedFiles.find(file.pathname));
+		if (it != g_RejectedFiles.end() && it->second == file.time)
+		{	// Do not report the same error again.
+			continue;
+		}
+		pathnames.insert(file.pathname);
+		const size_t ix{find(file.pathname)};
+		if (ix >= size() || at(ix).m_FileTime != file.time)
+		{	// New or modified
+			modified.push_back(file);
+		}
+	}
+	bool changed{!modified.empty()};
+	for (size_t ix{size()}; ix-- > 0;)
+	{
+		if (!pathnames.count(at(ix).m_Pathname))
+		{	// Deleted
+			removeRow(ix);
+			changed = true;
+		}
+	}
+	const std::vector<QByteArray> contents(readMembers(archive.get(), modified));
+	CReadAhead reader(readAheadFiles(archive.get(), modified));
+	for (size_t mx{}; mx < modified.size(); mx++)
+	{
+		const SLibraryFile& file(modified[mx]);
+		size_t ix{find(file.pathname)};
+		g_RejectedFiles.erase(file.pathname);
+		QByteArray content;
+		CModelData data;
+		if (!data.loadEntry(file.pathname, file.time, errMsgs, true, libraryFileData(contents, reader, mx, content)))
+		{
+			removeRow(ix);
+		}
+		else if (ix < size())
+		{	// Modified
+			replaceRow(ix, data);
+		}
+		else
+		{	// New
+			ix = size_t(std::lower_bound(array().begin(), array().end(), data, ltPathname) - array().begin());
+			data.Pk = createPk(array());
+			insertRow(ix, data);
 		}
-		val = getDimensionAtCritDim(fx);
-		if (fx == 0)
+	}
+	PROFILE_COUNT("refreshedFiles", modified.size());
+	s_IndexValid = s_IndexValid && !changed;
+	return changed;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Files to watch besides the directory: a file rewritten in place does not
+  change the directory (see updateWatcher()).
+@param path: Directory or archive
+@return The archive, or the files of the list
+*******************************************************************************/
+QStringList CModelData::watchList(const string& path)
+{
+	QStringList ret;
+	if (CModelArchive::isArchive(path))
+	{
+		ret << path.c_str();
+		return ret;
+	}
+	for (size_t ix{}; ix < size(); ix++)
+	{
+		ret << at(ix).m_Pathname.c_str();
+	}
+	return ret;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Brings the watched files in line with watchList() after loadLibrary() or
+  refreshLibrary(): removes the files no longer listed, adds new files and
+  those Qt dropped (a file replaced on save is no longer watched). Files
+  watched before stay armed, so no modification is missed meanwhile.
+  Directories watched are kept.
+@param path: Directory or archive
+*******************************************************************************/
+void CModelData::updateWatcher(QFileSystemWatcher& watcher, const string& path)
+{
+	const QStringList watched(watcher.files());
+	const QStringList listed(watchList(path));
+	const std::set<QString> watchedSet(watched.begin(), watched.end());
+	const std::set<QString> listedSet(listed.begin(), listed.end());
+	QStringList removed, added;
+	for (const QString& file : watched)
+	{
+		if (listedSet.count(file) == 0)
 		{
-			common = val;
+			removed << file;
 		}
-		else 
+	}
+	for (const QString& file : listed)
+	{
+		if (watchedSet.count(file) == 0)
 		{
-			if (val > common + EPS)
-			{
-				for (; val > common + EPS && common > EPS;)
-				{
-					val -= common;
-				}
-				common = val;
-			}
-			else if (common > val + EPS && val > EPS)
-			{
-				for (; common > val + EPS && val > EPS;)
-				{
-					common -= val;
-				}
-			}
+			added << file;
 		}
 	}
-	for (size_t fx{}; fx < modelOrder(); fx++)
+	if (!removed.isEmpty())
+	{
+		watcher.removePaths(removed);
+	}
+	if (!added.isEmpty())
 	{
-		const double val{floor(0.49 + getDimensionAtCritDim(fx) / common)};
-		m_NormalVect.push_back(int(val));
-//		ret += toString("%d", int(val));
-//		if (fx + 1 == numCoord())
-//		{
-//			ret += "; ";
-//		}
-//		else ret += fx + 1 < modelOrder() ? ", " : ")\r\n";
+		watcher.addPaths(added);
 	}
 }
 
+/* METHOD *********************************************************************/
+/**
+  Loads a library file into this (not yet listed) instance and evaluates it.
+@param  fileTime: Modification time as listed
+@param evaluated: false to leave evaluation to evaluateAll()
+@param      data: Content read before (archive member) or nullptr
+@return false if the file could not be loaded
+*******************************************************************************/
+bool CModelData::loadEntry(const string& pathname, long long fileTime, std::vector<string>& errMsgs,
+	bool evaluated, const QByteArray* data)
+{
+	string errMsg;
+	const bool ok{loadData(pathname, errMsg, eLoadHeader, data)};
+	if (!errMsg.empty())
+	{
+		errMsgs.push_back(errMsg);
+	}
+	if (!ok)
+	{
+		g_RejectedFiles[pathname] = fileTime;
+		return false;
+	}
+	m_FileTime = fileTime;
+	m_CanonicalHash = m_ExpMatrix.canonicalHash(m_SigmaMatrix);
+	if (evaluated)
+	{
+		PROFILE_SCOPE("evaluate");
+		evaluate();
+	}
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Evaluates all list entries like evaluate(), in batches (see
+  CNumerics::evaluate()).
+*******************************************************************************/
+void CModelData::evaluateAll()
+{
+	PROFILE_SCOPE("evaluateAll");
+	std::vector<const CExpMatrix*> models;
+	for (size_t ix{}; ix < size(); ix++)
+	{
+		models.push_back(&at(ix).m_ExpMatrix);
+	}
+	std::vector<SEvaluation> results;
+	CNumerics::evaluate(models, results);
+	for (size_t ix{}; ix < size(); ix++)
+	{
+		at(ix).setResult(results[ix]);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Determines the normal vector (=Signature), see CNumerics::normalVector().
+@precondition determineCanonicalDimensions()
+@side_effects m_NormalVect
+*******************************************************************************/
+void CModelData::determineNormalVector()
+{
+	invalidateDisplay();
+	m_NormalVect.clear();
+	throwAssert("determineNormalVector() failed.\n"
+		"You might select another term of the first " + toString(int(modelOrder())) + "\n"
+		"terms of the Lagrangian as interaction and try again.",
+		m_CanDim.size() == 1 + numTerm());
+	m_NormalVect = CNumerics::normalVector(m_CanDim, m_CritDim, modelOrder());
+}
+
 /* METHOD *********************************************************************/
 /**
 @precondition determineNormalVector().
@@ -654,7 +1250,7 @@ string CModelData::printCanonicalDimension(int fx) const
 	}
 	const double dim{constCanDim + m_CritDim * DCanDim};
 	string ret;
-	ret = CFormatFloat::bilinear(dim, -DCanDim, eFormatHtml).toStdString();
+	ret = CFormatFloat::bilinearHtml(dim, -DCanDim);
 	return ret;
 }
 
@@ -668,7 +1264,7 @@ string CModelData::printCriticalDimension() const
 	{
 		return "undefined";
 	}
-	CFormatFloat val("%2.3f");
+	CFormatFloat val;
 	return val.get(m_CritDim);
 }
 
@@ -692,8 +1288,13 @@ string CModelData::printColumnCaption(size_t cx) const
 *******************************************************************************/
 string CModelData::printRowCaption(size_t tx) const
 {
-	throwAssert("printRowCaption()", tx < numTerm() && m_IsSingleton);
-	return guiMatrix().comment(tx);
+	throwAssert("printRowCaption()", tx < numTerm());
+	if (m_IsSingleton)
+	{
+		return guiMatrix().comment(tx);
+	}
+	throwAssert("printRowCaption(): not loaded", tx < m_Monomials.size());
+	return m_Monomials[tx].comment();
 }
 
 /* METHOD *********************************************************************/
@@ -711,7 +1312,7 @@ string CModelData::printRelevanceExtra(size_t tx, bool formula) const
 	string ret;
 	if (formula)
 	{
-		return CFormatFloat::bilinear(dim, -DCanDim, eFormatHtml).toStdString();
+		return CFormatFloat::bilinearHtml(dim, -DCanDim);
 	}
 	else
 	{
@@ -737,14 +1338,19 @@ string CModelData::printRelevanceExtra(size_t tx, bool formula) const
 bool CModelData::makeClean()
 {
 	m_Dirty = false;
+	invalidateDisplay();
 	if (m_IsSingleton)
 	{
 		guiMatrix().clear();
 	}
 	m_Pathname.clear();
+	m_HeaderOnly = false;
 	m_Monomials.clear();
+	m_ExpMatrix.clear(0, 0);
+	m_SigmaMatrix.clear(0, 0);
 	m_CritDim = CNumerics::INVALID_CRITDIM;
 	m_Rank = -1;
+	m_RxInteraction = -1;
 	m_ReactionDiffusion = m_Statics = m_Dynamics = false;
 	m_Comment.clear();
 	m_Name.clear();
@@ -765,26 +1371,57 @@ bool CModelData::makeClean()
 /* METHOD *********************************************************************/
 /**
   Loads data from file.
-@param   pathname: Source
+@param   pathname: Source, a file or an archive member (see CModelArchive)
 @param     errMsg: Error message or empty (Qt crashes when a messageBox is opened in an exception handler) !
+@param       load: eLoadHeader skips comment and references, and keeps the
+                   exponents of the monomials only (list entries).
+@param       data: Content of pathname read before, or nullptr. m_FileTime
+                   is then left to the caller.
+@return false if the file could not be read. A list entry is then unchanged.
 *******************************************************************************/
-void CModelData::loadData(const string& pathname, string& errMsg)
+bool CModelData::loadData(const string& pathname, string& errMsg, ELoad load, const QByteArray* data)
+{
+	if (m_IsSingleton)
+	{	// Monomials go to CGuiMatrix, cleared before loading
+		return readData(pathname, errMsg, load, data);
+	}
+	CModelData loaded(*this);
+	if (!loaded.readData(pathname, errMsg, load, data))
+	{
+		return false;
+	}
+	*this = std::move(loaded);
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Parses the file into this, see loadData().
+*******************************************************************************/
+bool CModelData::readData(const string& pathname, string& errMsg, ELoad load, const QByteArray* data)
 {
 	try
 	{
 		errMsg.clear();
-		CGuiOptimizationInfo loadGuard(s_LoadingFile);
+		invalidateDisplay();
+		bool loadingEntry{}; // List entries: no GUI involved, may be loaded on any thread
+		CGuiOptimizationInfo loadGuard(m_IsSingleton ? s_LoadingFile : loadingEntry);
 		QDomDocument doc;
-		xmlOpen(doc, pathname.c_str());
+		const long long time{openModel(doc, pathname, data)};
+		PROFILE_COUNT("filesParsed", 1);
 		QDomElement docElem(doc.documentElement());
 		if (docElem.tagName() != "Kanon")
 		{
 			throwError("This is another XML file type, cannot be loaded.\n" + pathname);
 		}
 		m_Pathname = pathname;
+		m_FileTime = time;
+		m_HeaderOnly = !m_IsSingleton && load == eLoadHeader;
 		m_Coords.clear();
 		m_Fields.clear();
 		m_Monomials.clear();
+		m_ExpMatrix.clear(0, 0);
+		m_SigmaMatrix.clear(0, 0);
 		m_UserTag = xmlGetAttr(docElem, "userTag");
 		m_Dynamics = xmlGetBool(docElem, "dynamics");
 		m_ReactionDiffusion = xmlGetBool(docElem, "reactionDiffusion");
@@ -805,7 +1442,6 @@ void CModelData::loadData(const string& pathname, string& errMsg)
 				errMsg = errText;
 			}
 		}
-		size_t numMonomial{};
 		for (QDomNode node(docElem.firstChild()); !node.isNull(); node = node.nextSibling())
 		{
 			if (node.isElement())
@@ -816,7 +1452,7 @@ void CModelData::loadData(const string& pathname, string& errMsg)
 				{
 					m_Name = xmlGetTextData(elem);
 				}
-				else if (tagName == "Comment")
+				else if (tagName == "Comment" && !m_HeaderOnly)
 				{
 					m_Comment = xmlGetPcData(elem);
 					//fprintf(stderr, "Comment %s\n", m_Comment.c_str());
@@ -831,6 +1467,10 @@ void CModelData::loadData(const string& pathname, string& errMsg)
 					CGlyphCoordField field(elem);
 					m_Fields.push_back(field);
 				}
+				else if (tagName == "Monomial" && m_HeaderOnly)
+				{	// Exponents only, the glyphs are created by ensureLoaded()
+					errMsg = addExpRow(elem) ? "" : "Invalid coordinate or field index in " + pathname;
+				}
 				else if (tagName == "Monomial")
 				{
 					CFormula formula;
@@ -838,25 +1478,25 @@ void CModelData::loadData(const string& pathname, string& errMsg)
 					errMsg = formula.validate(*this);
 					if (errMsg.empty())
 					{
-						m_Monomials.push_back(formula);
 						if (m_IsSingleton)
 						{	// Monomials kept in CGuiMatrix for edit
-							guiMatrix().addRow(formula, numMonomial++);
+							m_Monomials.push_back(formula);
+							guiMatrix().addRow(formula);
+						}
+						else
+						{
+							addExpRow(formula);
+							m_Monomials.push_back(formula);
 						}
 					}
 				}
-				else if (tagName == "References")
+				else if (tagName == "References" && !m_HeaderOnly)
 				{
 					m_References = xmlGetPcData(elem);
 					//fprintf(stderr, "References %s\n", m_References.c_str());
 				}
 			}
 		}
-		if (!m_IsSingleton)
-		{	// Fill model list.
-			Pk = createPk(array());
-			push_back(*this);
-		}
 		insertDefaultCoordField();
 	}
 	catch (const std::exception& e)
@@ -864,7 +1504,89 @@ void CModelData::loadData(const string& pathname, string& errMsg)
 		insertDefaultCoordField();
 		errMsg = string(e.what()) + ", " + pathname;
 		fprintf(stderr, "ERR %s\n\n", e.what());/**/
+		return false;
+	}
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Appends the exponents of a monomial to m_ExpMatrix, the coefficients of
+  sigma to m_SigmaMatrix.
+@precondition Coordinates and fields loaded.
+*******************************************************************************/
+void CModelData::addExpRow(const CFormula& formula)
+{
+	if (m_ExpMatrix.empty())
+	{
+		m_ExpMatrix.clear(numCoord(), numField());
+		m_SigmaMatrix.clear(numCoord(), numField());
+	}
+	std::vector<int> exp(modelOrder());
+	std::vector<int> expSigma(modelOrder());
+	for (size_t cx{}; cx < exp.size(); cx++)
+	{
+		exp[cx] = formula.getExp(cx, *this);
+		expSigma[cx] = formula.getExpSigma(cx, *this);
+	}
+	m_ExpMatrix.addTerm(exp, formula.getExpD());
+	m_SigmaMatrix.addTerm(expSigma, 0);
+}
+
+/* METHOD *********************************************************************/
+/**
+  As addExpRow(const CFormula&), reading the exponents of the serialized
+  monomial directly (list entries loaded with eLoadHeader).
+@return false if a coordinate or field index is invalid; no row added then.
+*******************************************************************************/
+bool CModelData::addExpRow(QDomElement& monomial)
+{
+	if (m_ExpMatrix.empty())
+	{
+		m_ExpMatrix.clear(numCoord(), numField());
+		m_SigmaMatrix.clear(numCoord(), numField());
+	}
+	std::vector<int> exp, expSigma;
+	int expD{};
+	if (!CFormula::exponentsFromXml(monomial, numCoord(), numField(), exp, expSigma, expD))
+	{
+		return false;
+	}
+	m_ExpMatrix.addTerm(exp, expD);
+	m_SigmaMatrix.addTerm(expSigma, 0);
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Reads comment, references and monomials of a list entry loaded by
+  loadData(.., eLoadHeader). Results of evaluate() are kept.
+@param errMsg: [out] Error message or empty
+@return true when fully loaded
+*******************************************************************************/
+bool CModelData::ensureLoaded(string& errMsg)
+{
+	errMsg.clear();
+	if (!m_HeaderOnly)
+	{
+		return true;
+	}
+	PROFILE_COUNT("loadOnDemand", 1);
+	const long long fileTimeBefore{m_FileTime};
+	loadData(m_Pathname, errMsg, eLoadFull);
+	if (m_FileTime != fileTimeBefore)
+	{	// File changed since the scan.
+		m_CanonicalHash = m_ExpMatrix.canonicalHash(m_SigmaMatrix);
+		evaluate();
+		invalidateDisplay();
+		s_IndexValid = false;
+		const size_t ix{find(m_Pathname)};
+		if (ix < size() && &at(ix) == this)
+		{	// Not a copy (see CReportRenderer): update the views
+			notifyRowChanged(ix);
+		}
 	}
+	return errMsg.empty() && !m_HeaderOnly;
 }
 
 /* METHOD *********************************************************************/
@@ -923,7 +1645,7 @@ bool CModelData::saveData(QWidget* parent, const string& pathname)
 	}
 	else
 	{
-		throwAssert("!m_IsSingleton", false);
+		throwAssert("saveData(): Model not loaded", !m_HeaderOnly);
 		for (auto& monomial :  m_Monomials)
 		{
 			monomial.toXml(xml);
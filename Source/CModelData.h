@@ -2,11 +2,18 @@
 #define CMODELDATA_H
 
 #include <vector>
+#include "CExpMatrix.h"
 #include "CFormula.h"
 #include "CGlyph.h"
 #include "CNumerics.h"
+#include "COperatorEnum.h"
+#include "CSignatureIndex.h"
 #include "CTable.h"
 
+class QByteArray;
+class QDomElement;
+class QFileSystemWatcher;
+class QStringList;
 class QWidget;
 struct SCoordFieldAttributes;
 
@@ -16,11 +23,15 @@ struct SCoordFieldAttributes;
   A singleton instance is used for editing a model. In this case the monomial
 	data are kept/edited CGuiMatrix.
   A list of models may be kept (temporarily) in the static array inhereted from
-	CTable<CModelData>
+	CTable<CModelData>. List entries keep the exponents in m_ExpMatrix; comment,
+	references and monomials are only read on demand (see ensureLoaded()).
+	The list is always sorted by pathname: find() and refreshLibrary() rely on
+	it. Views sort and filter via a proxy model (see lessThan()), never the list.
 *******************************************************************************/
 class CModelData : public CTable<CModelData>
 {
 	bool m_IsSingleton;                     // Instance used for edit (monomials kept in CGuiMatrix)
+	bool m_HeaderOnly;                      // List entry: comment, references, m_Monomials not loaded
 	bool m_Dirty;
 	bool m_Dynamics;
 	bool m_ReactionDiffusion;
@@ -28,7 +39,12 @@ class CModelData : public CTable<CModelData>
 	bool m_QuantumFieldTheory;
 	double m_CritDim;
 	int  m_Rank;
+	int  m_RxInteraction;                   // Of the evaluation, -1: none (see SEvaluation)
+	long long m_FileTime;                   // Modification time of m_Pathname when loaded (ms since epoch)
 	static bool s_LoadingFile;              // Optimization: No Gui updates as long as true
+	static std::string s_LibraryPath;       // Directory or archive loaded by loadLibrary()
+	static CSignatureIndex s_Index;         // Over the list, see signatureIndex()
+	static bool s_IndexValid;               // Reset when the list changed
 	std::string m_Comment;
 	std::string m_Name;
 	std::string m_Pathname;
@@ -37,27 +53,53 @@ class CModelData : public CTable<CModelData>
 	std::vector<CFormula> m_Monomials;      // The monomials (As read from file. Edited data are in CGuiMatrix)
 	std::vector<CGlyphCoordField> m_Coords; // Coordinates
 	std::vector<CGlyphCoordField> m_Fields; // Fields
+	CExpMatrix m_ExpMatrix;                 // Exponents of list entries (not used by the singleton)
+	CExpMatrix m_SigmaMatrix;               // Coefficients of sigma of list entries, as m_ExpMatrix
+	SHash128 m_CanonicalHash;               // List entries: m_ExpMatrix.canonicalHash(m_SigmaMatrix)
 	std::vector<int> m_NormalVect;          // Canonical dimensions at crritical dimension, normalized
 	std::vector<SCanDim> m_CanDim;          // Canonical dimensions of coords/fields and coupling consts
+	CCouplingSolver m_Solver;               // Singleton: reused after reordering of the terms
 public:
 	enum
 	{
-		colNumCoord, colNumField, colOrder, colDimension, colNormalVect, colName, colTag, colFlags
+		colNumCoord, colNumField, colOrder, colDimension, colNormalVect, colName, colTag, colFlags, numColumn
+	};
+private:
+	struct SDisplay                         // Costly cell texts of list entries, see displayText()
+	{
+		QString normalVect;                 // Interned, see printSortedNormalVector()
+		QString flags;                      // Interned, see flags()
+		bool valid;
+		SDisplay() : normalVect(), flags(), valid() {}
+	};
+	mutable SDisplay m_Display;
+	void invalidateDisplay() { m_Display.valid = false; }
+public:
+	enum ELoad
+	{
+		eLoadFull,  // Everything
+		eLoadHeader // List entry: name, attributes, coords/fields and exponents only
 	};
 	CModelData(bool isSingleton = false);
 	void insertDefaultCoordField();
 	bool determineCritDim(double& critDim);
 	bool determineCanonicalDimensions(size_t rxOfCoupling);
+	double reciprocalCondition(size_t rxOfCoupling) const;
+	bool evaluate();
+	static void loadLibrary(const std::string& path, std::vector<std::string>& errMsgs);
+	static bool refreshLibrary(const std::string& path, std::vector<std::string>& errMsgs);
+	static QStringList watchList(const std::string& path);
+	static void updateWatcher(QFileSystemWatcher& watcher, const std::string& path);
 	bool dirty() const { return m_Dirty; }
 	bool isDynamics() const { return m_Dynamics; }
 	bool isQuantumFieldTheory() const { return m_QuantumFieldTheory; }
 	bool isReactionDiffusion() const { return m_ReactionDiffusion; }
 	bool isStatics() const { return m_Statics; }
 	bool isResponseField(size_t fx) const;
-	void setDynamics(bool val) { m_Dynamics = val; }
-	void setQuantumFieldTheory(bool val) { m_QuantumFieldTheory = val; }
-	void setReactionDiffusion(bool val) { m_ReactionDiffusion = val; }
-	void setStatics(bool val) { m_Statics = val; }
+	void setDynamics(bool val) { m_Dynamics = val; invalidateDisplay(); }
+	void setQuantumFieldTheory(bool val) { m_QuantumFieldTheory = val; invalidateDisplay(); }
+	void setReactionDiffusion(bool val) { m_ReactionDiffusion = val; invalidateDisplay(); }
+	void setStatics(bool val) { m_Statics = val; invalidateDisplay(); }
 	 
 	void determineNormalVector();
 	string printSortedNormalVector() const;
@@ -72,9 +114,12 @@ public:
 	bool makeClean();
 	double critDim() const { return m_CritDim; }
 	void setDirty();
-	void loadData(const std::string& pathname, std::string& errMsg);
+	bool loadData(const std::string& pathname, std::string& errMsg, ELoad load = eLoadFull,
+		const QByteArray* data = nullptr);
+	bool ensureLoaded(std::string& errMsg);
+	bool isHeaderOnly() const { return m_HeaderOnly; }
 	bool saveData(QWidget* = nullptr, const std::string& pathname = "");
-	std::string name() const { return m_Name; }
+	const std::string& name() const { return m_Name; }
 	size_t numTerm() const;
 	size_t modelOrder() const;
 	size_t numCoord() const { return m_Coords.size(); }
@@ -83,13 +128,29 @@ public:
 	void removeField(size_t);
 	int getExp(size_t tx, size_t fx) const;
 	int getExpD(size_t tx) const;
+	CExpMatrix expMatrix() const;
+	CExpMatrix sigmaMatrix() const;
+	bool hasSigma() const;
+	const SHash128& canonicalHash() const { return m_CanonicalHash; }
+	static std::vector<std::vector<size_t>> duplicates();
+	static const CSignatureIndex& signatureIndex();
+	const std::vector<int>& normalVect() const { return m_NormalVect; }
+	const std::vector<CFormula>& monomials() const { return m_Monomials; } // See m_Monomials
+	const std::vector<CGlyphCoordField>& coords() const { return m_Coords; }
+	const std::vector<CGlyphCoordField>& fields() const { return m_Fields; }
+	SEvaluation evaluation() const { return SEvaluation{m_CritDim, m_Rank, m_CanDim, m_NormalVect, m_RxInteraction}; }
+	int rxInteraction() const { return m_RxInteraction; }
+	void restore(const std::vector<CGlyphCoordField>& coords, const std::vector<CGlyphCoordField>& fields,
+		const SEvaluation& result);
+	const std::vector<SCanDim>& canDim() const { return m_CanDim; }
 	 
 	double getDimensionAtCritDim(size_t cx) const;
-	void setName(const string& name) { m_Name = name; }
+	COperatorEnum enumerateOperators(unsigned maxDegree, unsigned maxDerivative) const;
+	void setName(const string& name) { m_Name = name; invalidateDisplay(); }
 	 
 	void dump() const; // Debug
 	 
-	std::string category() const { return m_UserTag; }
+	const std::string& category() const { return m_UserTag; }
 	std::string comment() const { return m_Comment; }
 	std::string flags() const;
 	std::string pathname() const { return m_Pathname; }
@@ -117,10 +178,20 @@ public:
 		return columnCaption(col);
 	}
 	static QVariant data(const QModelIndex &index, int role);
+	QString displayText(int col) const;
 	static void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+	static bool lessThan(int column, const CModelData& x, const CModelData& y);
+	static size_t find(const std::string& pathname);
 	static bool isLoadingFile() { return s_LoadingFile; }
 private:
 	double getDimensionOfCouplingConst(double* dCanDim, size_t tx) const;
+	void addExpRow(const CFormula&);
+	bool addExpRow(QDomElement& monomial);
+	bool readData(const std::string& pathname, std::string& errMsg, ELoad load, const QByteArray* data);
+	bool loadEntry(const std::string& pathname, long long fileTime, std::vector<std::string>& errMsgs,
+		bool evaluated = true, const QByteArray* data = nullptr);
+	static void evaluateAll();
+	void setResult(SEvaluation&);
 };
 
 // Singleton for editor
@@ -1,17 +1,30 @@
 /*******************************************************************************
 Matrix inversion
 *******************************************************************************/
+#include <algorithm>
+#include <climits>
+#include <cmath>
 #include <complex>
+#include <map>
+#include <memory>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
-#include "CModelData.h"
+#include "CBatchSolver.h"
+#include "CExpMatrix.h"
+#include "CFactorCache.h"
+#include "CLuFactor.h"
 #include "CNumerics.h"
+#include "CProfiler.h"
+#include "CSparseLu.h"
 #include "matrix.h"
 
 using namespace math;
 
 typedef std::complex<double> TComplex;
 const double CNumerics::INVALID_CRITDIM{-99999.9f};
+const double CNumerics::ILL_CONDITIONED_RCOND{1E-8};
+const double CNumerics::SINGULAR_RCOND{1E-12}; // Smaller reciprocal conditions: matrix numerically singular
 
 /*******************************************************************************
 Debug
@@ -71,104 +84,366 @@ namespace
 //		fprintf(stderr, "\n");
 //#endif
 //	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Fills the matrix E1 of CNumerics::determineCanonicalDimensions(): exponents
+	  WITHOUT those of the 1st coordinate (which enter the rhs vector), and 1 in
+	  all columns with index >= modelOrder (first 1 for rxOfCoupling).
+	@param set: Called as set(rx, cx, value), elements not set are 0
+	*******************************************************************************/
+	template <typename TSet>
+	void fillCouplingMatrix(const CExpMatrix& mod, int rxOfCoupling, TSet set)
+	{
+		const unsigned numTerm{unsigned(mod.numTerm())};
+		const unsigned numExpCol{std::min(unsigned(mod.order()), numTerm + 1)};
+		unsigned couplingCol{unsigned(mod.order())};
+		unsigned rx1{unsigned(rxOfCoupling + 1)};
+		for (unsigned rx{1}; rx <= numTerm; rx++)
+		{	// All terms (with extra terms)
+			for (unsigned cx{1}; cx < numExpCol; cx++)
+			{	// First column gets removed. Includes contribution from 1-dimensional integrals (and delta-function)
+				set(rx - 1, cx - 1, double(mod.getExp(rx - 1, cx)));
+			}
+			if (couplingCol <= numTerm && (rx == rx1 || (rx > mod.order() && rx == couplingCol)))
+			{	// One 1.0 for each coupling constant: explicitely selected coupling (rx1) or extra term
+				set(rx - 1, couplingCol - 1, 1.0);
+				rx1 = UINT_MAX;
+				couplingCol++;
+			}
+		}
+	}
+
+	const size_t SparseMinSize{48};      // Smaller systems are solved dense
+	const double SparseMaxDensity{0.15}; // Fraction of nonzero elements
+	const double MaxInverseElement{1E8}; // Larger: E1 considered ill-conditioned (CCouplingSolver, CSigmaSweep)
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return true if a system of size n with numNonZero elements is solved by
+	  CSparseLu rather than CLuFactor
+	*******************************************************************************/
+	bool preferSparse(size_t n, size_t numNonZero)
+	{
+		return n >= SparseMinSize && double(numNonZero) <= SparseMaxDensity * double(n) * double(n);
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return Number of nonzero elements of E1 (see fillCouplingMatrix())
+	*******************************************************************************/
+	size_t numNonZeroCoupling(const CExpMatrix& mod)
+	{
+		size_t ret{};
+		fillCouplingMatrix(mod, 0, [&ret](unsigned, unsigned, double val) { ret += val != 0.0; });
+		return ret;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Determinant of the order x order exponent matrix, by CSparseLu.
+	@param withD: Column 0 replaced by the negative coefficients of d
+	@param rcond: [out/optional] Estimated reciprocal condition (see CSparseLu::rcond())
+	*******************************************************************************/
+	double sparseExpDet(const CExpMatrix& mod, bool withD, double* rcond = nullptr)
+	{
+		const size_t order{mod.order()};
+		SCsrMatrix a(order);
+		for (size_t rx{}; rx < order; rx++)
+		{
+			a.append(rx, 0, withD ? -mod.getExpD(rx) : mod.getExp(rx, 0));
+			for (size_t cx{1}; cx < order; cx++)
+			{
+				a.append(rx, cx, mod.getExp(rx, cx));
+			}
+		}
+		a.finish();
+		CSparseLu lu;
+		lu.factorize(a);
+		if (rcond)
+		{
+			*rcond = lu.rcond();
+		}
+		return lu.det();
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Determinants of the order x order exponent matrix, by CLuFactor or CSparseLu.
+	@param     e0: [out] Of the exponent matrix
+	@param     e1: [out] With column 0 replaced by the negative coefficients of d
+	@param rcond1: [out] Estimated reciprocal condition of the matrix of e1
+	*******************************************************************************/
+	void expDets(const CExpMatrix& mod, double& e0, double& e1, double& rcond1)
+	{
+		const size_t order{mod.order()};
+		size_t numNonZero{};
+		for (size_t rx{}; rx < order; rx++)
+		{
+			for (size_t cx{}; cx < order; cx++)
+			{
+				numNonZero += mod.getExp(rx, cx) != 0;
+			}
+		}
+		if (preferSparse(order, numNonZero))
+		{	// Large multi-field models
+			e0 = sparseExpDet(mod, false);
+			e1 = sparseExpDet(mod, true, &rcond1);
+			return;
+		}
+		std::vector<double> mtrx(order * order);
+		PROFILE_COUNT("matrixAllocs", 1);
+		for (size_t rx{}; rx < order; rx++)
+		{
+			for (unsigned cx{}; cx < order; cx++)
+			{
+				mtrx[rx * order + cx] = mod.getExp(rx, cx);
+			}
+		}
+		CLuFactor lu;
+		lu.factorize(mtrx, order);
+		e0 = lu.det();
+		for (size_t row {}; row < order; row++)
+		{	// Contribution proportional to d
+			mtrx[row * order] = -mod.getExpD(row);
+		}
+		lu.factorize(mtrx, order);
+		e1 = lu.det();
+		rcond1 = lu.rcond();
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Replaces a threshold on det1, which depends on the scale of the matrix.
+	  Batch results (CBatchSolver keeps no factors) are not estimated: the
+	  exponents are integers, so is the determinant of a regular matrix.
+	@return true if the matrix of det1 (see expDets()) is regular
+	*******************************************************************************/
+	bool regularDet1(const CFactorCache::SEntry& entry)
+	{
+		if (entry.rcond1 < 0.0)
+		{
+			return fabs(entry.det1) >= 0.5;
+		}
+		return entry.det1 != 0.0 && !CNumerics::isSingular(entry.rcond1);
+	}
+
+	enum EKeyKind // Of CFactorCache keys
+	{
+		eLeadingBlock = 1, // Determinants and rank
+		eCouplingDense,    // CLuFactor of E1
+		eCouplingSparse    // CSparseLu of E1
+	};
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return CFactorCache key of the first order() terms, which determine the
+	  critical dimension and the rank. Shared by models extended by further
+	  terms and by reorderings of the first terms (the rows are sorted; the
+	  determinants may differ in sign).
+	*******************************************************************************/
+	std::vector<int> leadingBlockKey(const CExpMatrix& mod)
+	{
+		const size_t order{mod.order()};
+		const size_t numRow{std::min(mod.numTerm(), order)};
+		std::vector<std::vector<int>> rows(numRow);
+		for (size_t rx{}; rx < numRow; rx++)
+		{
+			rows[rx].push_back(mod.getExpD(rx));
+			for (size_t cx{}; cx < order; cx++)
+			{
+				rows[rx].push_back(mod.getExp(rx, cx));
+			}
+		}
+		// Critical dimension and rank do not depend on the order of the terms
+		std::sort(rows.begin(), rows.end());
+		std::vector<int> key{eLeadingBlock, int(order), int(numRow)};
+		key.reserve(key.size() + numRow * (order + 1));
+		for (const auto& row : rows)
+		{
+			key.insert(key.end(), row.begin(), row.end());
+		}
+		return key;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return CFactorCache key of E1 (see fillCouplingMatrix())
+	*******************************************************************************/
+	std::vector<int> couplingKey(const CExpMatrix& mod, int rxOfCoupling, bool sparse)
+	{
+		const size_t order{mod.order()};
+		std::vector<int> key{sparse ? eCouplingSparse : eCouplingDense, int(mod.numTerm()), int(order), rxOfCoupling};
+		key.reserve(key.size() + mod.numTerm() * order);
+		for (size_t rx{}; rx < mod.numTerm(); rx++)
+		{
+			for (size_t cx{1}; cx < order; cx++)
+			{
+				key.push_back(mod.getExp(rx, cx));
+			}
+		}
+		return key;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Factorizes E1 (see fillCouplingMatrix()).
+	@param entry: [out] lu or sparseLu set
+	@param    E1: [out] Dense E1, not set for sparse
+	*******************************************************************************/
+	void factorizeCoupling(const CExpMatrix& mod, int rxOfCoupling, bool sparse,
+		CFactorCache::SEntry& entry, std::vector<double>& E1)
+	{
+		const size_t n{mod.numTerm()};
+		if (sparse)
+		{	// Large multi-field models: E1 is mostly zeros
+			SCsrMatrix csr(n);
+			fillCouplingMatrix(mod, rxOfCoupling, [&csr](unsigned rx, unsigned cx, double val) { csr.append(rx, cx, val); });
+			csr.finish();
+			std::shared_ptr<CSparseLu> lu{std::make_shared<CSparseLu>()};
+			lu->factorize(csr);
+			PROFILE_COUNT("sparseSolves", 1);
+			PROFILE_COUNT("sparseNonZeros", lu->numNonZero());
+			entry.sparseLu = lu;
+		}
+		else
+		{
+			E1.assign(n * n, 0.0);
+			PROFILE_COUNT("matrixAllocs", 2);
+			fillCouplingMatrix(mod, rxOfCoupling, [&E1, n](unsigned rx, unsigned cx, double val) { E1[rx * n + cx] = val; });
+			std::shared_ptr<CLuFactor> lu{std::make_shared<CLuFactor>()};
+			lu->factorize(E1, n);
+			entry.lu = lu;
+		}
+	}
 }
 
+
 /* METHOD *********************************************************************/
 /**
-  Determines the canonical dimensions
-@param critDim: [out]
+  Determines the canonical dimensions as affine functions of d and of further
+  parameters. E1 is real: it is factorized once, the constant part, the
+  coefficient of d and those of the parameters are right hand side columns.
+@param critDim: [out] At which the dimension of the coupling constant vanishes
+  (the further parameters set to 0)
 @param  canDim: [out] Canonical dimensions of coords/fields/coupling constants.
 @param     mod: [in]
 @param rxOfCoupling: 0-based index of term selected as coupling constant
 @param expMatrix: [out/optional] Exponent matrix
 @param invMatrix: [out/optional] Inverted matrix
+@param  params: [in/optional] Per further parameter (e.g. a long range exponent
+  sigma) the coefficients, per term, in the exponent of the 1st coordinate
+  (analogous to CExpMatrix::getExpD()). Results in SCanDim::paramVal.
 *******************************************************************************/
 void CNumerics::determineCanonicalDimensions(double& critDim, std::vector<SCanDim>& canDim,
-	const CModelData& mod, int rxOfCoupling,
-	matrix<double>* expMatrix, matrix<double>* invMatrix)
+	const CExpMatrix& mod, int rxOfCoupling,
+	matrix<double>* expMatrix, matrix<double>* invMatrix,
+	const std::vector<std::vector<double>>* params)
 {
+	PROFILE_SCOPE("determineCanonicalDimensions");
+	PROFILE_COUNT("solves", 1);
 #if 1
 	determineRank(mod);
 #endif
 	// Set output to default//
 	critDim = INVALID_CRITDIM;
 	canDim.clear();
-	SCanDim dimFirstCoord;
-	dimFirstCoord.constVal = 1.0;
-	dimFirstCoord.dVal = 0.0;
+	SCanDim dimFirstCoord{1.0, 0.0, std::vector<double>()};
+	const size_t numParam{params ? params->size() : 0};
+	dimFirstCoord.paramVal.assign(numParam, 0.0);
 	canDim.push_back(dimFirstCoord);
-	// Create E1 matrix (WITHOUT exponents of 1st coordinate, which enter the rhsVector). //
+	// Create E1 matrix (WITHOUT exponents of 1st coordinate, which enter the rhs). //
 	// E1 also hast 1 in all columns with index >= modelOrder (first 1 for rxOfCoupling). //
-	matrix<TComplex> E1(mod.numTerm(), mod.numTerm());
-	// Columns in which 1.0 is to be inserted for a coupling constant.
-	unsigned couplingCol{unsigned(mod.modelOrder())};
-	unsigned rx1{unsigned(rxOfCoupling + 1)};
-	for (unsigned rx{1}; rx <= mod.numTerm(); rx++)
-	{	// All terms (with extra terms)
-		for (unsigned cx{1}; cx <= mod.numTerm(); cx++)
-		{	// First column gets removed
-			if (cx < mod.modelOrder())
-			{	// Includes contribution from 1-dimensional integrals (and delta-function)
-				double Exp{double(mod.getExp(rx - 1, cx))};
-				E1(rx - 1, cx - 1) = Exp;
-			}
-			else if (cx == couplingCol)
-			{	// Add one 1.0 for each coupling constant
-				double Exp{};
-				if (rx == rx1 || (rx > mod.modelOrder() && rx == cx))
-				{	// Explicitely selected coupling (rx1) or extra term
-					rx1 = UINT_MAX;
-					Exp = 1.0;
-					couplingCol++;
-				}
-				E1(rx - 1, cx - 1) = Exp;
-			}
+	const size_t n{mod.numTerm()};
+	// Rhs columns (WITH KNOWN exponents of 1st coordinate): negative d-independent
+	// wave vector exponent, contribution proportional to d, further parameters.
+	const size_t numRhs{2 + numParam};
+	std::vector<double> canon(n * numRhs);
+	for (size_t rx{}; rx < n; rx++)
+	{
+		canon[rx * numRhs]     = -mod.getExp(rx, 0);
+		canon[rx * numRhs + 1] = -mod.getExpD(rx);
+		for (size_t px{}; px < numParam; px++)
+		{
+			canon[rx * numRhs + 2 + px] = -(*params)[px].at(rx);
 		}
-		//fprintf(stderr, "\n");
 	}
-//	dbgPrintMatrix("(can) E1 = ", E1, false);
-	// Generate the rhsVector (WITH KNOWN exponents of 1st coordinate)//
-	matrix<TComplex> rhsVector(mod.numTerm(), 1);
-	for (unsigned rx{}; rx < mod.numTerm(); rx++)
+	const bool optionalOutput{expMatrix && invMatrix};
+	const bool sparse{!optionalOutput && preferSparse(n, numNonZeroCoupling(mod))};
+	const std::vector<int> key{couplingKey(mod, rxOfCoupling, sparse)};
+	CFactorCache::SEntry entry;
+	std::vector<double> E1;
+	if (optionalOutput || !CFactorCache::instance().find(key, entry))
 	{
-		// real part is negative d-independent wave vector exponent,
-		// Imaginary part is the contribution proportional to d.
-		const int expD{mod.getExpD(rx)};
-		rhsVector(rx, 0) = TComplex(-mod.getExp(rx, 0), -expD);
+		factorizeCoupling(mod, rxOfCoupling, sparse, entry, E1);
+		CFactorCache::instance().insert(key, entry);
 	}
 	// Get canonical dimensions//
-	matrix<TComplex> E2;
-	E1.Invert(E2);
-//	dbgPrintMatrix("1/E1 = ", E2, true);
-	matrix<TComplex> canon(mod.numTerm(), 1);
-	canon = E2.multiplied(rhsVector);
-//	dbgPrintMatrix("Canonical dimensions", canon);/**/
-	const TComplex u(canon(mod.modelOrder() - 1, 0));
-	critDim = -std::real(u) / std::imag(u);
-	// Fill output variables//
-	for (unsigned ix{}; ix < canon.RowNo(); ix++)
-	{	// Append nontrivial canonical dimensions
-		SCanDim dim;
-		dim.constVal = std::real(canon(ix, 0));
-		dim.dVal     = std::imag(canon(ix, 0));
-		canDim.push_back(dim);
+	if (entry.sparseLu ? entry.sparseLu->singular() : entry.lu->singular())
+	{
+		throw matrix_error("matrixT::operator!: Inversion of a singular matrix");
 	}
-	//fprintf(stderr, "%s, critDim = %f\n", mod.name().c_str(), critDim);
-	if (expMatrix && invMatrix)
+	if (entry.sparseLu)
+	{
+		entry.sparseLu->solve(canon, numRhs);
+	}
+	else
+	{
+		entry.lu->solve(canon, numRhs);
+	}
+	if (optionalOutput)
 	{	// Optional output
-		expMatrix->SetSize(mod.numTerm(), mod.numTerm());
-		invMatrix->SetSize(mod.numTerm(), mod.numTerm());
-		for (unsigned rx{}; rx < mod.numTerm(); rx++)
+		std::vector<double> inv;
+		entry.lu->inverse(inv);
+		expMatrix->SetSize(n, n);
+		invMatrix->SetSize(n, n);
+		for (unsigned rx{}; rx < n; rx++)
 		{
 			// Set output matrix
-			for (unsigned cx{}; cx < mod.numTerm(); cx++)
+			for (unsigned cx{}; cx < n; cx++)
 			{
-				(*expMatrix)(rx, cx)    = std::real(E1(rx, cx));
-				(*invMatrix)(rx, cx) = std::real(E2(rx, cx));
-				//fprintf(stderr, " %f", real(E2(rx, cx)));
+				(*expMatrix)(rx, cx) = E1[rx * n + cx];
+				(*invMatrix)(rx, cx) = inv[rx * n + cx];
 			}
 		}
 	}
+	const size_t ixU{mod.order() - 1};
+	critDim = -canon[ixU * numRhs] / canon[ixU * numRhs + 1];
+	// Fill output variables//
+	for (size_t ix{}; ix < n; ix++)
+	{	// Append nontrivial canonical dimensions
+		const double* row{&canon[ix * numRhs]};
+		canDim.push_back(SCanDim{row[0], row[1], std::vector<double>(row + 2, row + numRhs)});
+	}
+	//fprintf(stderr, "%s, critDim = %f\n", mod.name().c_str(), critDim);
+}
+
+/* METHOD *********************************************************************/
+/**
+  Estimates the condition of E1 (see determineCanonicalDimensions()) from its
+  factors in the CFactorCache, without inversion: O(n^2) after
+  determineCanonicalDimensions() with the same interaction.
+@param rxInteraction: 0-based index of term selected as coupling constant
+@return Reciprocal condition in the 1-norm, 0 if E1 is singular. Below
+  ILL_CONDITIONED_RCOND the canonical dimensions are unreliable.
+*******************************************************************************/
+double CNumerics::reciprocalCondition(const CExpMatrix& mod, int rxInteraction)
+{
+	PROFILE_SCOPE("reciprocalCondition");
+	if (mod.numTerm() < mod.order())
+	{
+		return 0.0;
+	}
+	const bool sparse{preferSparse(mod.numTerm(), numNonZeroCoupling(mod))};
+	const std::vector<int> key{couplingKey(mod, rxInteraction, sparse)};
+	CFactorCache::SEntry entry;
+	if (!CFactorCache::instance().find(key, entry))
+	{
+		std::vector<double> E1;
+		factorizeCoupling(mod, rxInteraction, sparse, entry, E1);
+		CFactorCache::instance().insert(key, entry);
+	}
+	return entry.sparseLu ? entry.sparseLu->rcond() : entry.lu->rcond();
 }
 
 /* METHOD *********************************************************************/
@@ -178,48 +453,331 @@ void CNumerics::determineCanonicalDimensions(double& critDim, std::vector<SCanDi
 @param    mod: Model to examine
 @return true on success
 *******************************************************************************/
-bool CNumerics::determineCritDim(double& critDim, const CModelData& mod)
+bool CNumerics::determineCritDim(double& critDim, const CExpMatrix& mod)
 {
-	const size_t order{mod.modelOrder()};
+	PROFILE_SCOPE("determineCritDim");
+	const size_t order{mod.order()};
 	critDim = INVALID_CRITDIM;
 	if (mod.numTerm() < unsigned(order))
 	{
 		return false;
 	}
-	matrix<double> mtrx(order, order);
-	for (size_t rx{}; rx < order; rx++)
+	const std::vector<int> key{leadingBlockKey(mod)};
+	CFactorCache::SEntry entry;
+	if (!CFactorCache::instance().find(key, entry) || !entry.haveDets)
+	{
+		expDets(mod, entry.det0, entry.det1, entry.rcond1);
+		entry.haveDets = true;
+		CFactorCache::instance().insert(key, entry);
+	}
+	if (regularDet1(entry))
+	{
+		critDim = entry.det0/entry.det1;
+		return true;
+	}
+	return false;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Batched determineCritDim(): models are grouped by modelOrder(), the two
+  determinants of each model are computed in lanes of CBatchSolver.
+@param   models: Models to examine
+@param critDims: [out] Critical dimensions, INVALID_CRITDIM where undetermined
+*******************************************************************************/
+void CNumerics::determineCritDims(const std::vector<const CExpMatrix*>& models, std::vector<double>& critDims)
+{
+	PROFILE_SCOPE("determineCritDims");
+	critDims.assign(models.size(), INVALID_CRITDIM);
+	std::map<size_t, std::vector<size_t>> byOrder;
+	std::vector<std::vector<int>> keys(models.size());
+	std::vector<CFactorCache::SEntry> entries(models.size());
+	for (size_t mx{}; mx < models.size(); mx++)
 	{
-		for (unsigned cx{}; cx < order; cx++)
+		if (models[mx]->numTerm() < models[mx]->order())
 		{
-			const int val{mod.getExp(rx, cx)};
-			mtrx(rx, cx) = val;
+			continue;
 		}
+		keys[mx] = leadingBlockKey(*models[mx]);
+		const CFactorCache::SEntry& entry(entries[mx]);
+		if (CFactorCache::instance().find(keys[mx], entries[mx]) && entry.haveDets)
+		{	// Same leading terms evaluated before
+			if (regularDet1(entry))
+			{
+				critDims[mx] = entry.det0/entry.det1;
+			}
+			continue;
+		}
+		byOrder[models[mx]->order()].push_back(mx);
 	}
-	const double e0{mtrx.Det()};
-	for (size_t row {}; row < order; row++)
-	{	// Contribution proportional to d
-		const int expD{mod.getExpD(row)};
-		mtrx(row, 0) = -expD;
+	for (const auto& group : byOrder)
+	{
+		const size_t order{group.first};
+		// Lanes 0..Lanes/2-1: exponent matrices, then the same with column 0 = -expD.
+		const size_t half{CBatchSolver::Lanes / 2};
+		CBatchSolver solver(order);
+		for (size_t begin{}; begin < group.second.size(); begin += half)
+		{
+			const size_t num{std::min(half, group.second.size() - begin)};
+			solver.clear();
+			for (size_t lx{}; lx < num; lx++)
+			{
+				const CExpMatrix& mod(*models[group.second[begin + lx]]);
+				for (size_t rx{}; rx < order; rx++)
+				{
+					for (size_t cx{}; cx < order; cx++)
+					{
+						solver.a(lx, rx, cx) = solver.a(half + lx, rx, cx) = mod.getExp(rx, cx);
+					}
+					solver.a(half + lx, rx, 0) = -mod.getExpD(rx);
+				}
+			}
+			solver.factorize();
+			PROFILE_COUNT("batchDeterminants", 2*num);
+			for (size_t lx{}; lx < num; lx++)
+			{
+				const size_t mx{group.second[begin + lx]};
+				CFactorCache::SEntry& entry(entries[mx]);
+				entry.det0 = solver.det(lx);
+				entry.det1 = solver.det(half + lx);
+				entry.rcond1 = -1.0;
+				entry.haveDets = true;
+				CFactorCache::instance().insert(keys[mx], entry);
+				if (regularDet1(entry))
+				{
+					critDims[mx] = entry.det0/entry.det1;
+				}
+			}
+		}
 	}
-	//dbgPrintMatrix("determineCritDim mtrx = ", mtrx);
-	const double e1{mtrx.Det()};
-	if (fabs(e1) > 1E-8)
+}
+
+/* METHOD *********************************************************************/
+/**
+  Batched determineCanonicalDimensions() with the 1st term as coupling: models
+  are grouped by numTerm(), E1 is solved for the real and the imaginary part
+  of the rhs vector (E1 is real) in lanes of CBatchSolver.
+@param   models: Models to examine
+@param critDims: [in/out] From determineCritDims(), models with INVALID_CRITDIM
+  are skipped. Updated like the scalar version.
+@param  canDims: [out] Canonical dimensions, empty where E1 is singular (the
+  caller then tries other terms as coupling).
+*******************************************************************************/
+void CNumerics::determineCanonicalDimensions(const std::vector<const CExpMatrix*>& models,
+	std::vector<double>& critDims, std::vector<std::vector<SCanDim>>& canDims)
+{
+	PROFILE_SCOPE("determineCanonicalDimensionsBatch");
+	canDims.assign(models.size(), std::vector<SCanDim>());
+	std::map<size_t, std::vector<size_t>> byNumTerm;
+	for (size_t mx{}; mx < models.size(); mx++)
 	{
-		critDim = e0/e1;
-		return true;
+		if (critDims[mx] != INVALID_CRITDIM)
+		{
+			byNumTerm[models[mx]->numTerm()].push_back(mx);
+		}
+	}
+	for (const auto& group : byNumTerm)
+	{
+		const size_t numTerm{group.first};
+		CBatchSolver solver(numTerm, 2);
+		for (size_t begin{}; begin < group.second.size(); begin += CBatchSolver::Lanes)
+		{
+			const size_t num{std::min(size_t(CBatchSolver::Lanes), group.second.size() - begin)};
+			solver.clear();
+			for (size_t lx{}; lx < num; lx++)
+			{
+				const CExpMatrix& mod(*models[group.second[begin + lx]]);
+				fillCouplingMatrix(mod, 0, [&solver, lx](unsigned rx, unsigned cx, double val)
+				{
+					solver.a(lx, rx, cx) = val;
+				});
+				for (size_t rx{}; rx < numTerm; rx++)
+				{
+					solver.b(lx, rx, 0) = -mod.getExp(rx, 0);
+					solver.b(lx, rx, 1) = -mod.getExpD(rx);
+				}
+			}
+			solver.factorize();
+			solver.solve();
+			PROFILE_COUNT("batchSolves", num);
+			for (size_t lx{}; lx < num; lx++)
+			{
+				if (solver.singular(lx))
+				{
+					continue;
+				}
+				const size_t mx{group.second[begin + lx]};
+				std::vector<SCanDim>& canDim(canDims[mx]);
+				canDim.push_back(SCanDim{1.0, 0.0, std::vector<double>()});
+				for (size_t ix{}; ix < numTerm; ix++)
+				{
+					canDim.push_back(SCanDim{solver.x(lx, ix, 0), solver.x(lx, ix, 1), std::vector<double>()});
+				}
+				const size_t ixU{models[mx]->order() - 1};
+				critDims[mx] = -solver.x(lx, ixU, 0) / solver.x(lx, ixU, 1);
+			}
+		}
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Determines critical dimension, canonical dimensions and normal vector.
+  The first order() terms are attempted as interaction until one works.
+@param    mod: Model to examine
+@param result: [in/out] Only critDim is updated if it cannot be determined.
+  rxInteraction: The term which worked.
+@return true on success
+*******************************************************************************/
+bool CNumerics::evaluate(const CExpMatrix& mod, SEvaluation& result)
+{
+	if (!determineCritDim(result.critDim, mod))
+	{
+		return false;
+	}
+	for (size_t tx{}; tx < mod.order(); tx++)
+	{	// Attempt terms as interaction until OK.
+		try
+		{
+			result.rank = determineRank(mod);
+			determineCanonicalDimensions(result.critDim, result.canDim, mod, int(tx));
+			result.normalVect = normalVector(result.canDim, result.critDim, mod.order());
+			result.rxInteraction = int(tx);
+			return true;
+		}
+		catch (...)
+		{	// Ignore
+		}
+		PROFILE_COUNT("singularRetries", 1);
 	}
 	return false;
 }
 
+/* METHOD *********************************************************************/
+/**
+  Evaluates all models like evaluate(), but the determinants and the solution
+  with the 1st term as coupling are computed in batches (see CBatchSolver).
+  Models for which this fails take the scalar path, as do large models with
+  sparse exponent matrices (see CSparseLu).
+@param  models: Models to examine
+@param results: [out] One per model
+*******************************************************************************/
+void CNumerics::evaluate(const std::vector<const CExpMatrix*>& models, std::vector<SEvaluation>& results)
+{
+	PROFILE_SCOPE("evaluateBatch");
+	results.assign(models.size(), SEvaluation{INVALID_CRITDIM, -1, std::vector<SCanDim>(), std::vector<int>(), -1});
+	std::vector<const CExpMatrix*> batched;
+	std::vector<size_t> batchedIndex; // Per batched model: index in models
+	for (size_t mx{}; mx < models.size(); mx++)
+	{
+		if (preferSparse(models[mx]->numTerm(), numNonZeroCoupling(*models[mx])))
+		{
+			evaluate(*models[mx], results[mx]);
+		}
+		else
+		{
+			batched.push_back(models[mx]);
+			batchedIndex.push_back(mx);
+		}
+	}
+	std::vector<double> critDims;
+	determineCritDims(batched, critDims);
+	std::vector<std::vector<SCanDim>> canDims;
+	determineCanonicalDimensions(batched, critDims, canDims);
+	for (size_t bx{}; bx < batched.size(); bx++)
+	{
+		SEvaluation& result(results[batchedIndex[bx]]);
+		result.critDim = critDims[bx];
+		if (result.critDim == INVALID_CRITDIM)
+		{	// As evaluate()
+			continue;
+		}
+		if (!canDims[bx].empty())
+		{
+			try
+			{
+				result.rank = determineRank(*batched[bx]);
+				result.canDim.swap(canDims[bx]);
+				result.normalVect = normalVector(result.canDim, result.critDim, batched[bx]->order());
+				result.rxInteraction = 0;
+				continue;
+			}
+			catch (...)
+			{	// Scalar path below
+			}
+		}
+		PROFILE_COUNT("batchFallbacks", 1);
+		evaluate(*batched[bx], result);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Determines the normal vector (=Signature). The normal vector is an order-
+  dimensional vector, the components of which are the dimensions of the
+  coordinates and fields (multiplied with a common factor to get integer
+  values). The 1st component denotes D-dimensional space.
+@param  canDim: Canonical dimensions (see determineCanonicalDimensions())
+@param critDim: Critical dimension
+@param   order: Number of coordinates and fields
+@return Normal vector, empty if canDim is incomplete
+*******************************************************************************/
+std::vector<int> CNumerics::normalVector(const std::vector<SCanDim>& canDim, double critDim, size_t order)
+{
+	std::vector<int> normalVect;
+	if (canDim.size() < order)
+	{
+		return normalVect;
+	}
+	double common{};
+	double val{};
+	for (size_t fx{}; fx < order; fx++)
+	{
+		const double EPS{0.01};
+		if (val > EPS)
+		{
+			common = val;
+		}
+		val = canDim[fx].value(critDim);
+		if (fx == 0)
+		{
+			common = val;
+		}
+		else 
+		{
+			if (val > common + EPS)
+			{
+				for (; val > common + EPS && common > EPS;)
+				{
+					val -= common;
+				}
+				common = val;
+			}
+			else if (common > val + EPS && val > EPS)
+			{
+				for (; common > val + EPS && val > EPS;)
+				{
+					common -= val;
+				}
+			}
+		}
+	}
+	for (size_t fx{}; fx < order; fx++)
+	{
+		normalVect.push_back(int(floor(0.49 + canDim[fx].value(critDim) / common)));
+	}
+	return normalVect;
+}
+
 /* METHOD *********************************************************************/
 /**
   Projects exponent points onto the plane k1 = 0.
 @param mtrx: [out]
 @param  mod: Model to examine
 *******************************************************************************/
-void CNumerics::getSpanningMatrix(matrix<double>& mtrx, const CModelData& mod)
+void CNumerics::getSpanningMatrix(matrix<double>& mtrx, const CExpMatrix& mod)
 {
-	const size_t order{mod.modelOrder()};
+	const size_t order{mod.order()};
 	const size_t numTerm{mtrx.RowNo()};
 	for (size_t rx{}; rx < numTerm; rx++)
 	{
@@ -244,18 +802,28 @@ void CNumerics::getSpanningMatrix(matrix<double>& mtrx, const CModelData& mod)
 @param  mod: Model to examine
 @return Rank
 *******************************************************************************/
-int CNumerics::determineRank(const CModelData& mod)
+int CNumerics::determineRank(const CExpMatrix& mod)
 {
-	const size_t order{mod.modelOrder()};
+	PROFILE_SCOPE("determineRank");
+	PROFILE_COUNT("matrixAllocs", 2);
+	const size_t order{mod.order()};
 	size_t numRow{mod.numTerm()};
 	if (numRow > order)
 	{
 		numRow = order;
 	}
+	const std::vector<int> key{leadingBlockKey(mod)};
+	CFactorCache::SEntry entry;
+	if (CFactorCache::instance().find(key, entry) && entry.rank >= 0)
+	{
+		return entry.rank;
+	}
 	matrix<double> mtrx(numRow, order);
 	getSpanningMatrix(mtrx, mod);
 	// Rank of the modelOrder-1 rows must be maximal (=dimension of hyperplane)
 	const int rank{mtrx.Rank()};
+	entry.rank = rank;
+	CFactorCache::instance().insert(key, entry);
 	if (rank != int(order))
 	{
 		//////fprintf(stderr, "Rank mismatch %d/%d %s\n", rank, order, mod.name().c_str());
@@ -274,9 +842,9 @@ determine rows that don't contribute to the hyperplane.
 @side_effects setTermRemovable()
 @param  mod: Model to examine
 *******************************************************************************/
-void CNumerics::determineUselessTerms(CModelData& mod)
+void CNumerics::determineUselessTerms(const CExpMatrix& mod)
 {
-	const size_t order{mod.modelOrder()};
+	const size_t order{mod.order()};
 	matrix<double> mtrx(order, order);
 	getSpanningMatrix(mtrx, mod);
 	// Rank of the modelOrder-1 rows must be maximal (==dimension of hyperplane)
@@ -314,4 +882,531 @@ void CNumerics::determineUselessTerms(CModelData& mod)
 	*/
 }
 
+/* METHOD *********************************************************************/
+/**
+  Forgets the stored factorization.
+*******************************************************************************/
+void CCouplingSolver::clear()
+{
+	m_Order = 0;
+	m_Rows.clear();
+	m_Col.clear();
+	m_Inv.clear();
+	m_NumUpdate = 0;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Matches the terms of mod with the stored rows.
+@param perm: [out] Per term of mod: stored row
+@return false if the terms are not a permutation of the stored ones
+*******************************************************************************/
+bool CCouplingSolver::match(const CExpMatrix& mod, std::vector<size_t>& perm) const
+{
+	const size_t n{mod.numTerm()};
+	if (mod.order() != m_Order || n != m_Rows.size())
+	{
+		return false;
+	}
+	std::map<std::vector<int>, std::vector<size_t>> rows; // Equal terms are interchangeable
+	for (size_t sx{n}; sx-- > 0;)
+	{
+		rows[m_Rows[sx]].push_back(sx);
+	}
+	perm.resize(n);
+	std::vector<int> row(m_Order + 1);
+	for (size_t rx{}; rx < n; rx++)
+	{
+		for (size_t cx{}; cx < m_Order; cx++)
+		{
+			row[cx] = mod.getExp(rx, cx);
+		}
+		row[m_Order] = mod.getExpD(rx);
+		const auto it = rows.find(row);
+		if (it == rows.end() || it->second.empty())
+		{
+			return false;
+		}
+		perm[rx] = it->second.back();
+		it->second.pop_back();
+	}
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Factorizes E1 of mod, stores its inverse; the stored rows are the terms of mod.
+@throws matrix_error if E1 is singular
+*******************************************************************************/
+void CCouplingSolver::factorize(const CExpMatrix& mod, int rxOfCoupling)
+{
+	PROFILE_COUNT("couplingSolverFactorizations", 1);
+	clear();
+	const size_t n{mod.numTerm()};
+	const size_t order{mod.order()};
+	std::vector<double> E1(n * n, 0.0);
+	fillCouplingMatrix(mod, rxOfCoupling, [&E1, n](unsigned rx, unsigned cx, double val) { E1[rx * n + cx] = val; });
+	CLuFactor lu;
+	if (!lu.factorize(E1, n))
+	{
+		throw matrix_error("matrixT::operator!: Inversion of a singular matrix");
+	}
+	lu.inverse(m_Inv);
+	checkConditioned();
+	m_Order = order;
+	m_Rows.assign(n, std::vector<int>(order + 1));
+	m_Col.assign(n, -1);
+	for (size_t rx{}; rx < n; rx++)
+	{
+		for (size_t cx{}; cx < order; cx++)
+		{
+			m_Rows[rx][cx] = mod.getExp(rx, cx);
+		}
+		m_Rows[rx][order] = mod.getExpD(rx);
+		if (rx == size_t(rxOfCoupling))
+		{
+			m_Col[rx] = int(order) - 1;
+		}
+		else if (rx >= order)
+		{	// Extra term
+			m_Col[rx] = int(rx);
+		}
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Prevents updates of an inverse of a (nearly) singular E1, which the LU does
+  not always detect: rounding errors would be carried on to the following
+  orders of the terms. The next call factorizes again.
+*******************************************************************************/
+void CCouplingSolver::checkConditioned()
+{
+	for (double val : m_Inv)
+	{
+		if (!(fabs(val) < MaxInverseElement))
+		{
+			m_NumUpdate = MaxUpdates;
+			return;
+		}
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Moves the coupling constant column of row rowLost to row rowGained:
+  E1 + (e_gained - e_lost) e_col^T, the inverse by Sherman-Morrison.
+@return false if the result is (nearly) singular; nothing changed then.
+*******************************************************************************/
+bool CCouplingSolver::update(size_t rowLost, size_t rowGained)
+{
+	const size_t n{m_Rows.size()};
+	const size_t col{size_t(m_Col[rowLost])};
+	const double* w{&m_Inv[col * n]};    // Row col of the inverse
+	const double denom{1.0 + w[rowGained] - w[rowLost]};
+	if (fabs(denom) < 1E-10)
+	{
+		return false;
+	}
+	std::vector<double> z(n);            // Inverse times (e_gained - e_lost)
+	for (size_t rx{}; rx < n; rx++)
+	{
+		z[rx] = m_Inv[rx * n + rowGained] - m_Inv[rx * n + rowLost];
+	}
+	const std::vector<double> wCopy(w, w + n);
+	for (size_t rx{}; rx < n; rx++)
+	{
+		const double f{z[rx] / denom};
+		double* inv{&m_Inv[rx * n]};
+		for (size_t cx{}; cx < n; cx++)
+		{
+			inv[cx] -= f * wCopy[cx];
+		}
+	}
+	m_Col[rowGained] = int(col);
+	m_Col[rowLost] = -1;
+	m_NumUpdate++;
+	checkConditioned();
+	PROFILE_COUNT("couplingSolverUpdates", 1);
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  As CNumerics::determineCanonicalDimensions(), reusing the stored inverse.
+@param critDim: [out]
+@param  canDim: [out]
+@param     mod: [in]
+@param rxOfCoupling: 0-based index of term selected as coupling constant
+*******************************************************************************/
+void CCouplingSolver::determineCanonicalDimensions(double& critDim, std::vector<SCanDim>& canDim,
+	const CExpMatrix& mod, int rxOfCoupling)
+{
+	PROFILE_SCOPE("couplingSolver");
+	const size_t n{mod.numTerm()};
+	const size_t order{mod.order()};
+	if (n < order || rxOfCoupling < 0 || size_t(rxOfCoupling) >= order
+		|| preferSparse(n, numNonZeroCoupling(mod)))
+	{
+		clear();
+		CNumerics::determineCanonicalDimensions(critDim, canDim, mod, rxOfCoupling);
+		return;
+	}
+	std::vector<size_t> perm;
+	bool reuse{match(mod, perm)};
+	if (reuse)
+	{	// Rows of the terms which lost/gained a coupling constant
+		std::vector<bool> coupled(n);
+		for (size_t rx{}; rx < n; rx++)
+		{
+			coupled[perm[rx]] = rx == size_t(rxOfCoupling) || rx >= order;
+		}
+		std::vector<size_t> lost, gained;
+		for (size_t sx{}; sx < n; sx++)
+		{
+			if (m_Col[sx] >= 0 && !coupled[sx])
+			{
+				lost.push_back(sx);
+			}
+			else if (m_Col[sx] < 0 && coupled[sx])
+			{
+				gained.push_back(sx);
+			}
+		}
+		if (lost.size() != gained.size() || lost.size() > 1)
+		{
+			reuse = false;
+		}
+		else
+		{
+			reuse = m_NumUpdate < MaxUpdates && (lost.empty() || update(lost[0], gained[0]));
+		}
+	}
+	if (!reuse)
+	{
+		factorize(mod, rxOfCoupling);
+		perm.resize(n);
+		for (size_t rx{}; rx < n; rx++)
+		{
+			perm[rx] = rx;
+		}
+	}
+	else
+	{
+		PROFILE_COUNT("couplingSolverReuses", 1);
+	}
+	// Right hand sides in the order of the stored rows, see CNumerics::determineCanonicalDimensions()
+	std::vector<double> b(2 * n);
+	for (size_t sx{}; sx < n; sx++)
+	{
+		b[2 * sx]     = -m_Rows[sx][0];
+		b[2 * sx + 1] = -m_Rows[sx][order];
+	}
+	std::vector<double> x(2 * n, 0.0);
+	for (size_t rx{}; rx < n; rx++)
+	{
+		const double* inv{&m_Inv[rx * n]};
+		for (size_t cx{}; cx < n; cx++)
+		{
+			x[2 * rx]     += inv[cx] * b[2 * cx];
+			x[2 * rx + 1] += inv[cx] * b[2 * cx + 1];
+		}
+	}
+	// Columns: coordinates/fields, coupling constant of the interaction, those of the extra terms
+	canDim.assign(1, SCanDim{1.0, 0.0, std::vector<double>()});
+	for (size_t cx{}; cx + 1 < order; cx++)
+	{
+		canDim.push_back(SCanDim{x[2 * cx], x[2 * cx + 1], std::vector<double>()});
+	}
+	for (size_t rx{size_t(rxOfCoupling)}; rx < n; rx = rx < order ? order : rx + 1)
+	{
+		const size_t col{size_t(m_Col[perm[rx]])};
+		canDim.push_back(SCanDim{x[2 * col], x[2 * col + 1], std::vector<double>()});
+	}
+	const SCanDim& coupling(canDim[order]);
+	critDim = -coupling.constVal / coupling.dVal;
+}
+
+/* METHOD *********************************************************************/
+/**
+  As CNumerics::reciprocalCondition(), exact from the stored inverse (the
+  order of the rows does not change the norms).
+@precondition determineCanonicalDimensions() with the same arguments
+*******************************************************************************/
+double CCouplingSolver::reciprocalCondition(const CExpMatrix& mod, int rxOfCoupling) const
+{
+	if (m_Inv.empty())
+	{	// Solved by CNumerics
+		return CNumerics::reciprocalCondition(mod, rxOfCoupling);
+	}
+	const size_t n{m_Rows.size()};
+	std::vector<double> colSums(n), colSumsInv(n);
+	for (size_t rx{}; rx < n; rx++)
+	{
+		for (size_t cx{1}; cx < m_Order; cx++)
+		{	// Column cx of the exponents is column cx - 1 of E1
+			colSums[cx - 1] += fabs(m_Rows[rx][cx]);
+		}
+		if (m_Col[rx] >= 0)
+		{
+			colSums[size_t(m_Col[rx])] += 1.0;
+		}
+		for (size_t cx{}; cx < n; cx++)
+		{
+			colSumsInv[cx] += fabs(m_Inv[rx * n + cx]);
+		}
+	}
+	const double norm{*std::max_element(colSums.begin(), colSums.end())};
+	const double normInv{*std::max_element(colSumsInv.begin(), colSumsInv.end())};
+	return norm > 0.0 && normInv > 0.0 ? 1.0 / (norm * normInv) : 0.0;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Ctor
+@param         mod: Exponents at sigma = 0
+@param   sigmaExps: Coefficients of sigma in the exponents (getExpD() unused)
+@param rxInteraction: 0-based index of term selected as coupling constant
+@throws matrix_error if the model has less terms than coordinates and fields
+*******************************************************************************/
+CSigmaSweep::CSigmaSweep(const CExpMatrix& mod, const CExpMatrix& sigmaExps, int rxInteraction)
+	: m_N{mod.numTerm()}
+	, m_Order{mod.order()}
+	, m_RxInteraction{rxInteraction}
+	, m_E1(m_N * m_N, 0.0)
+	, m_Rhs(3 * m_N)
+	, m_SigmaCols()
+	, m_SigmaE1()
+{
+	if (m_N < m_Order || sigmaExps.numTerm() != m_N || sigmaExps.order() != m_Order
+		|| rxInteraction < 0 || size_t(rxInteraction) >= m_Order)
+	{
+		throw matrix_error("CSigmaSweep: Model incomplete");
+	}
+	const size_t n{m_N};
+	fillCouplingMatrix(mod, rxInteraction, [this, n](unsigned rx, unsigned cx, double val) { m_E1[rx * n + cx] = val; });
+	for (size_t rx{}; rx < n; rx++)
+	{	// As CNumerics::determineCanonicalDimensions()
+		m_Rhs[3 * rx]     = -mod.getExp(rx, 0);
+		m_Rhs[3 * rx + 1] = -mod.getExpD(rx);
+		m_Rhs[3 * rx + 2] = -sigmaExps.getExp(rx, 0);
+	}
+	for (size_t cx{1}; cx < m_Order; cx++)
+	{	// Column cx of the exponents is column cx - 1 of E1
+		for (size_t rx{}; rx < n; rx++)
+		{
+			if (sigmaExps.getExp(rx, cx) != 0)
+			{
+				if (m_SigmaE1.empty())
+				{
+					m_SigmaE1.assign(n * n, 0.0);
+				}
+				if (m_SigmaCols.empty() || m_SigmaCols.back() != cx - 1)
+				{
+					m_SigmaCols.push_back(cx - 1);
+				}
+				m_SigmaE1[rx * n + cx - 1] = sigmaExps.getExp(rx, cx);
+			}
+		}
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+@return true if sigma enters the exponents of the 1st coordinate
+*******************************************************************************/
+bool CSigmaSweep::hasSigmaRhs() const
+{
+	for (size_t rx{}; rx < m_N; rx++)
+	{
+		if (m_Rhs[3 * rx + 2] != 0.0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Solves E1(sigma) x = rhs.
+@param      x: [out] Per row: constant part, coefficient of d, of sigma (of the
+  right hand side), with column: the column of E1 depending on sigma
+@param withColumn: See x, requires one column depending on sigma
+@return false if E1(sigma) is singular
+*******************************************************************************/
+bool CSigmaSweep::solve(double sigma, std::vector<double>& x, bool withColumn) const
+{
+	PROFILE_COUNT("sigmaSweepSolves", 1);
+	const size_t n{m_N};
+	std::vector<double> E1(m_E1);
+	for (size_t ix{}; ix < m_SigmaE1.size(); ix++)
+	{
+		E1[ix] += sigma * m_SigmaE1[ix];
+	}
+	CLuFactor lu;
+	if (!lu.factorize(E1, n))
+	{
+		return false;
+	}
+	const size_t numRhs{withColumn ? 4U : 3U};
+	x.assign(n * numRhs, 0.0);
+	for (size_t rx{}; rx < n; rx++)
+	{
+		std::copy(&m_Rhs[3 * rx], &m_Rhs[3 * rx] + 3, &x[rx * numRhs]);
+		if (withColumn)
+		{
+			x[rx * numRhs + 3] = m_SigmaE1[rx * n + m_SigmaCols[0]];
+		}
+	}
+	lu.solve(x, numRhs);
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Sets the results of a grid point.
+@param x0, xD: Solutions: constant part, coefficient of d
+*******************************************************************************/
+void CSigmaSweep::fill(SSweepPoint& pt, double sigma, const std::vector<double>& x0, const std::vector<double>& xD) const
+{
+	pt.sigma = sigma;
+	pt.canDim.assign(1, SCanDim{1.0, 0.0, std::vector<double>()});
+	for (size_t rx{}; rx < m_N; rx++)
+	{
+		pt.canDim.push_back(SCanDim{x0[rx], xD[rx], std::vector<double>()});
+	}
+	const size_t ixU{m_Order - 1};
+	pt.critDim = -x0[ixU] / xD[ixU];
+}
+
+/* METHOD *********************************************************************/
+/**
+  Evaluates the model at sigma (E1 factorized).
+@param pt: [out]
+*******************************************************************************/
+void CSigmaSweep::evaluate(double sigma, SSweepPoint& pt) const
+{
+	std::vector<double> x;
+	if (!solve(sigma, x, false))
+	{
+		pt = SSweepPoint{sigma, CNumerics::INVALID_CRITDIM, std::vector<SCanDim>()};
+		return;
+	}
+	std::vector<double> x0(m_N), xD(m_N);
+	for (size_t rx{}; rx < m_N; rx++)
+	{
+		x0[rx] = x[3 * rx] + sigma * x[3 * rx + 2];
+		xD[rx] = x[3 * rx + 1];
+	}
+	fill(pt, sigma, x0, xD);
+}
 
+/* METHOD *********************************************************************/
+/**
+  Evaluates the model on an equidistant grid. E1 is factorized at from,
+  the other points are obtained by updates (see class description).
+@param numStep: Number of intervals, numStep + 1 points
+@param  points: [out]
+*******************************************************************************/
+void CSigmaSweep::sweep(double from, double to, size_t numStep, std::vector<SSweepPoint>& points) const
+{
+	PROFILE_SCOPE("sigmaSweep");
+	points.assign(numStep + 1, SSweepPoint{});
+	const double step{numStep ? (to - from) / double(numStep) : 0.0};
+	const bool withColumn{m_SigmaCols.size() == 1};
+	std::vector<double> x;
+	bool update{m_SigmaCols.size() <= 1 && solve(from, x, withColumn)};
+	for (size_t ix{}; update && ix < x.size(); ix++)
+	{	// E1(from) singular, not detected by the LU
+		update = fabs(x[ix]) < MaxInverseElement;
+	}
+	if (!update)
+	{	// E1 not a rank-1 update of a regular E1(from)
+		for (size_t px{}; px <= numStep; px++)
+		{
+			evaluate(px == numStep ? to : from + double(px) * step, points[px]);
+		}
+		return;
+	}
+	const size_t n{m_N};
+	const size_t numRhs{withColumn ? 4U : 3U};
+	const size_t cx{withColumn ? m_SigmaCols[0] : 0};
+	std::vector<double> x0(n), xD(n);
+	for (size_t px{}; px <= numStep; px++)
+	{
+		const double sigma{px == numStep ? to : from + double(px) * step};
+		for (size_t rx{}; rx < n; rx++)
+		{
+			x0[rx] = x[rx * numRhs] + sigma * x[rx * numRhs + 2];
+			xD[rx] = x[rx * numRhs + 1];
+		}
+		if (withColumn)
+		{	// E1(sigma) = E1(from) + (sigma - from) s e_cx^T
+			const double t{sigma - from};
+			const double denom{1.0 + t * x[cx * numRhs + 3]};
+			if (fabs(denom) < 1E-10)
+			{	// E1(sigma) (nearly) singular
+				evaluate(sigma, points[px]);
+				continue;
+			}
+			const double f0{t * x0[cx] / denom};
+			const double fD{t * xD[cx] / denom};
+			for (size_t rx{}; rx < n; rx++)
+			{
+				const double u{x[rx * numRhs + 3]};
+				x0[rx] -= f0 * u;
+				xD[rx] -= fD * u;
+			}
+		}
+		fill(points[px], sigma, x0, xD);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Writes the curve as comma separated values: sigma, critical dimension and
+  the canonical dimensions (at the critical dimension) of the coordinates,
+  fields and coupling constants following the 1st coordinate. Points where
+  E1 is singular have empty cells.
+@param  names: Column captions of the canonical dimensions, one per column written
+*******************************************************************************/
+void CSigmaSweep::writeCsv(std::ostream& os, const std::vector<SSweepPoint>& points,
+	const std::vector<std::string>& names)
+{
+	auto quote = [](const std::string& text)
+	{
+		if (text.find_first_of(",\"\n") == std::string::npos)
+		{
+			return text;
+		}
+		std::string ret("\"");
+		for (char ch : text)
+		{
+			ret += ch == '"' ? std::string("\"\"") : std::string(1, ch);
+		}
+		return ret + '"';
+	};
+	auto number = [](double val)
+	{
+		char buf[32];
+		snprintf(buf, sizeof(buf), "%.10g", val);
+		return std::string(buf);
+	};
+	os << "sigma,critical dimension";
+	for (const auto& name : names)
+	{
+		os << ',' << quote(name);
+	}
+	os << '\n';
+	for (const auto& pt : points)
+	{
+		const bool valid{pt.critDim != CNumerics::INVALID_CRITDIM && std::isfinite(pt.critDim)};
+		os << number(pt.sigma) << ',' << (valid ? number(pt.critDim) : std::string());
+		for (size_t cx{1}; cx <= names.size(); cx++)
+		{
+			os << ',' << (valid && cx < pt.canDim.size() ? number(pt.canDim[cx].value(pt.critDim)) : std::string());
+		}
+		os << '\n';
+	}
+}
@@ -1,7 +1,12 @@
 #ifndef NUMERICS_H
 #define NUMERICS_H
 
-class CModelData;
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class CExpMatrix;
 
 namespace math
 {
@@ -14,24 +19,137 @@ using math::matrix;
 *******************************************************************************/
 struct SCanDim       // Contains a canonical dimension
 {
-	double constVal; // Value for d = 0
+	double constVal; // Value for d = 0 (and further parameters = 0)
 	double dVal;     // Coefficient of contribution linear in d
+	std::vector<double> paramVal; // Coefficients of further parameters (see determineCanonicalDimensions())
+	double value(double d, const std::vector<double>& params = std::vector<double>()) const
+	{	// At given d and parameter values (missing ones are 0)
+		double ret{constVal + dVal * d};
+		for (size_t px{}; px < paramVal.size() && px < params.size(); px++)
+		{
+			ret += paramVal[px] * params[px];
+		}
+		return ret;
+	}
+};
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Results of CNumerics::evaluate()
+*******************************************************************************/
+struct SEvaluation
+{
+	double critDim;
+	int rank;                    // -1: not determined
+	std::vector<SCanDim> canDim; // 1st coordinate, coordinates/fields, coupling constants
+	std::vector<int> normalVect;
+	int rxInteraction;           // Term used as coupling constant, -1: none
 };
 
 /* CLASS DECLARATION **********************************************************/
 /**
+  Independent of Qt: models are given by their exponents (CExpMatrix).
 *******************************************************************************/
 class CNumerics
 {
 public:
 	static const double INVALID_CRITDIM;
-	static bool determineCritDim(double &critDim, const CModelData&);
-	static int  determineRank(const CModelData&);
-	static void determineCanonicalDimensions(double& critDim, std::vector<SCanDim>&, const CModelData&, int rxInteraction,
-		matrix<double>* expMatrix = 0, matrix<double>* invMatrix = nullptr);
+	static const double ILL_CONDITIONED_RCOND; // See reciprocalCondition()
+	static const double SINGULAR_RCOND;
+	static bool determineCritDim(double &critDim, const CExpMatrix&);
+	static int  determineRank(const CExpMatrix&);
+	static void determineCanonicalDimensions(double& critDim, std::vector<SCanDim>&, const CExpMatrix&, int rxInteraction,
+		matrix<double>* expMatrix = 0, matrix<double>* invMatrix = nullptr,
+		const std::vector<std::vector<double>>* params = nullptr);
+	static void determineCritDims(const std::vector<const CExpMatrix*>&, std::vector<double>& critDims);
+	static void determineCanonicalDimensions(const std::vector<const CExpMatrix*>&, std::vector<double>& critDims,
+		std::vector<std::vector<SCanDim>>& canDims);
+	static bool evaluate(const CExpMatrix&, SEvaluation&);
+	static void evaluate(const std::vector<const CExpMatrix*>&, std::vector<SEvaluation>&);
+	static std::vector<int> normalVector(const std::vector<SCanDim>&, double critDim, size_t order);
+	static double reciprocalCondition(const CExpMatrix&, int rxInteraction);
+	static bool isIllConditioned(double rcond) { return rcond < ILL_CONDITIONED_RCOND; }
+	static bool isSingular(double rcond) { return rcond <= SINGULAR_RCOND; }
 private:
-	static void determineUselessTerms(CModelData&);
-	static void getSpanningMatrix(matrix<double>& mtrx, const CModelData&);
+	static void determineUselessTerms(const CExpMatrix&);
+	static void getSpanningMatrix(matrix<double>& mtrx, const CExpMatrix&);
+};
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Solver state of the edited model: keeps the inverse of E1 (see
+  CNumerics::determineCanonicalDimensions()), its rows identified by the
+  exponents of the terms. After the terms have been reordered (e.g. an extra
+  term dragged up to become the interaction) the rows are matched again:
+  - the same terms coupled: the stored solution is relabeled, no solve;
+  - one term lost and another one gained a coupling constant: the inverse is
+    updated in O(n^2) (Sherman-Morrison);
+  - otherwise, after MaxUpdates updates, for an ill-conditioned E1 and for
+    large sparse systems (see CSparseLu): E1 is factorized again.
+  Results equal those of CNumerics::determineCanonicalDimensions() (without
+  further parameters) up to rounding.
+  Independent of Qt.
+*******************************************************************************/
+class CCouplingSolver
+{
+	size_t m_Order;
+	std::vector<std::vector<int>> m_Rows; // Per stored row: exponents and expD of its term
+	std::vector<int> m_Col;               // Per stored row: its coupling constant column or -1
+	std::vector<double> m_Inv;            // Inverse of the stored E1, row major
+	unsigned m_NumUpdate;                 // Since the last factorization
+	bool match(const CExpMatrix&, std::vector<size_t>& perm) const;
+	void factorize(const CExpMatrix&, int rxOfCoupling);
+	bool update(size_t rowLost, size_t rowGained);
+	void checkConditioned();
+public:
+	enum { MaxUpdates = 16 };
+	CCouplingSolver() : m_Order(), m_Rows(), m_Col(), m_Inv(), m_NumUpdate() {}
+	void clear();
+	unsigned numUpdate() const { return m_NumUpdate; } // Since the last factorization
+	void determineCanonicalDimensions(double& critDim, std::vector<SCanDim>&, const CExpMatrix&, int rxOfCoupling);
+	double reciprocalCondition(const CExpMatrix&, int rxOfCoupling) const;
+};
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Result of CSigmaSweep at one value of sigma
+*******************************************************************************/
+struct SSweepPoint
+{
+	double sigma;
+	double critDim;              // INVALID_CRITDIM if E1 is singular at sigma
+	std::vector<SCanDim> canDim; // As CNumerics::determineCanonicalDimensions(), at sigma
+};
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Critical dimension and canonical dimensions of a model with a long range
+  exponent sigma (e.g. |k|^sigma, see CGlyphCoordinate): the exponents are
+  those of mod plus sigma times those of sigmaExps.
+  sigma in the exponents of the 1st coordinate enters the right hand sides
+  only, sigma in one other column changes one column of E1 (a rank-1
+  change): E1 is factorized once for a sweep, each grid point costs O(n)
+  (Sherman-Morrison). sigma in several columns: E1 is factorized per point.
+  Independent of Qt.
+*******************************************************************************/
+class CSigmaSweep
+{
+	size_t m_N;                      // Number of terms
+	size_t m_Order;
+	int m_RxInteraction;
+	std::vector<double> m_E1;        // At sigma = 0, row major
+	std::vector<double> m_Rhs;       // Per row: constant part, coefficient of d, of sigma
+	std::vector<size_t> m_SigmaCols; // Columns of E1 depending on sigma
+	std::vector<double> m_SigmaE1;   // Coefficients of sigma in E1, row major
+	bool solve(double sigma, std::vector<double>& x, bool withColumn) const;
+	void fill(SSweepPoint&, double sigma, const std::vector<double>& x0, const std::vector<double>& xD) const;
+public:
+	CSigmaSweep(const CExpMatrix& mod, const CExpMatrix& sigmaExps, int rxInteraction);
+	bool dependsOnSigma() const { return !m_SigmaCols.empty() || hasSigmaRhs(); }
+	bool hasSigmaRhs() const;
+	void evaluate(double sigma, SSweepPoint&) const;
+	void sweep(double from, double to, size_t numStep, std::vector<SSweepPoint>&) const;
+	static void writeCsv(std::ostream&, const std::vector<SSweepPoint>&, const std::vector<std::string>& names);
 };
 
 #endif
@@ -0,0 +1,209 @@
+/******************************************************************************/
+/**
+@file         COperatorEnum.cpp
+@copyright
+*
+@description  Enumeration and classification of candidate terms (operators).
+*******************************************************************************/
+#include <algorithm>
+#include "COperatorEnum.h"
+
+using std::vector;
+
+namespace
+{
+	const double Eps{0.001}; // As CModelData::printRelevanceExtra()
+}
+
+/* METHOD *********************************************************************/
+/**
+  Ctor
+@param   settings: Limits and constraints (see SSettings, filled by
+                   CModelData::enumerateOperators())
+@param   numCoord: Number of coordinates, followed by the fields
+@param responseField: Per field, true for response fields
+*******************************************************************************/
+COperatorEnum::COperatorEnum(const SSettings& settings, size_t numCoord, const vector<bool>& responseField)
+	: m_Settings(settings)
+	, m_NumCoord{numCoord}
+	, m_ResponseField(responseField)
+	, m_Width{numCoord + responseField.size() + 1}
+	, m_Exps()
+	, m_Degree()
+	, m_Derivative()
+	, m_Dim()
+	, m_DVal()
+	, m_Order()
+	, m_Truncated()
+{
+}
+
+/* METHOD *********************************************************************/
+/**
+  Enumerates the candidates, replaces previous ones.
+@return Number of candidates
+*******************************************************************************/
+size_t COperatorEnum::enumerate()
+{
+	m_Exps.clear();
+	m_Degree.clear();
+	m_Derivative.clear();
+	m_Dim.clear();
+	m_DVal.clear();
+	m_Order.clear();
+	m_Truncated = false;
+	if (m_NumCoord == 0 || m_ResponseField.empty())
+	{
+		return 0;
+	}
+	vector<int> row(m_Width);
+	row[m_Width - 1] = -1; // Integral over the d-dimensional coordinate
+	addDerivatives(row, 0, m_Settings.maxDerivative);
+	return size();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Distributes up to derivative derivatives over the coordinates from cx on.
+*******************************************************************************/
+void COperatorEnum::addDerivatives(vector<int>& row, size_t cx, unsigned derivative)
+{
+	if (cx == m_NumCoord)
+	{
+		addFields(row, 0, 0, m_Settings.maxDerivative - derivative);
+		return;
+	}
+	const bool even{cx == 0 ? m_Settings.evenGradients : m_Settings.evenOtherDerivatives};
+	const int integral{cx == 0 ? 0 : -1}; // The integral over coordinate 0 enters expD
+	for (unsigned nx{}; nx <= derivative && !m_Truncated; nx += even ? 2 : 1)
+	{
+		row[cx] = integral + int(nx);
+		addDerivatives(row, cx + 1, derivative - nx);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Distributes the field exponents from field fx on, appends complete rows
+  satisfying the constraints.
+@param     degree: Sum of exponents of fields before fx
+@param derivative: Number of derivatives in row
+*******************************************************************************/
+void COperatorEnum::addFields(vector<int>& row, size_t fx, unsigned degree, unsigned derivative)
+{
+	if (fx == m_ResponseField.size())
+	{
+		if (degree < 2)
+		{	// Linear terms can be removed by a shift of the field.
+			return;
+		}
+		bool haveResponse{}, haveOther{}, anyResponse{};
+		for (size_t ix{}; ix < m_ResponseField.size(); ix++)
+		{
+			const bool present{row[m_NumCoord + ix] > 0};
+			anyResponse = anyResponse || m_ResponseField[ix];
+			haveResponse = haveResponse || (present && m_ResponseField[ix]);
+			haveOther = haveOther || (present && !m_ResponseField[ix]);
+		}
+		if ((m_Settings.needResponseField && anyResponse && !haveResponse)
+			|| (m_Settings.needOtherField && !haveOther))
+		{
+			return;
+		}
+		if (size() >= MaxNumOperator)
+		{
+			m_Truncated = true;
+			return;
+		}
+		m_Exps.insert(m_Exps.end(), row.begin(), row.end());
+		m_Degree.push_back(degree);
+		m_Derivative.push_back(derivative);
+		return;
+	}
+	for (unsigned nx{}; degree + nx <= m_Settings.maxDegree && !m_Truncated; nx++)
+	{
+		row[m_NumCoord + fx] = int(nx);
+		addFields(row, fx + 1, degree + nx, derivative);
+	}
+	row[m_NumCoord + fx] = 0;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Determines the dimensions of the coupling constants of all candidates:
+  one product of the candidate matrix with the two columns (value at critDim,
+  coefficient of d) of the canonical dimensions, then sorts.
+@param dimAtCritDim: Per coordinate/field, dimension at critDim
+@param         dVal: Per coordinate/field, coefficient of d
+@param      critDim: Critical dimension
+*******************************************************************************/
+void COperatorEnum::classify(const vector<double>& dimAtCritDim, const vector<double>& dVal, double critDim)
+{
+	const size_t numCol{m_Width - 1};
+	vector<double> w0(dimAtCritDim.begin(), dimAtCritDim.begin() + std::min(numCol, dimAtCritDim.size()));
+	vector<double> w1(dVal.begin(), dVal.begin() + std::min(numCol, dVal.size()));
+	w0.resize(numCol);
+	w1.resize(numCol);
+	w0.push_back(critDim); // Column of expD
+	w1.push_back(1.0);
+	const size_t num{size()};
+	m_Dim.assign(num, 0.0);
+	m_DVal.assign(num, 0.0);
+	const int* exps{m_Exps.data()};
+	for (size_t ox{}; ox < num; ox++, exps += m_Width)
+	{
+		double sum0{}, sum1{};
+		for (size_t cx{}; cx < m_Width; cx++)
+		{
+			sum0 += exps[cx] * w0[cx];
+			sum1 += exps[cx] * w1[cx];
+		}
+		m_Dim[ox] = -sum0;
+		m_DVal[ox] = -sum1;
+	}
+	m_Order.resize(num);
+	for (size_t ox{}; ox < num; ox++)
+	{
+		m_Order[ox] = ox;
+	}
+	std::stable_sort(m_Order.begin(), m_Order.end(), [this](size_t a, size_t b)
+	{
+		if (m_Dim[a] != m_Dim[b])
+		{
+			return m_Dim[a] > m_Dim[b];
+		}
+		if (m_Degree[a] != m_Degree[b])
+		{
+			return m_Degree[a] < m_Degree[b];
+		}
+		return m_Derivative[a] < m_Derivative[b];
+	});
+}
+
+/* METHOD *********************************************************************/
+/**
+  Passes the candidates by descending dimension of the coupling constant.
+@precondition classify() called
+*******************************************************************************/
+void COperatorEnum::stream(const std::function<void(const SOperator&)>& sink) const
+{
+	for (const size_t ox : m_Order)
+	{
+		const SOperator op{&m_Exps[ox * m_Width], m_Exps[ox * m_Width + m_Width - 1],
+			m_Degree[ox], m_Derivative[ox], m_Dim[ox], m_DVal[ox], relevance(m_Dim[ox])};
+		sink(op);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+@param dim: Dimension of a coupling constant at the critical dimension
+*******************************************************************************/
+COperatorEnum::ERelevance COperatorEnum::relevance(double dim)
+{
+	if (dim > Eps)
+	{
+		return eRelevant;
+	}
+	return dim < -Eps ? eIrrelevant : eMarginal;
+}
@@ -0,0 +1,77 @@
+/******************************************************************************/
+/**
+@file         COperatorEnum.h
+@copyright
+*
+@description  Enumeration and classification of candidate terms (operators).
+*******************************************************************************/
+#ifndef COPERATORENUM_H
+#define COPERATORENUM_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Enumerates all monomials of the fields up to a total field degree and a
+  total derivative order. Each candidate is integrated over all coordinates,
+  derivatives add to the exponents of the coordinates. The dimensions of the
+  coupling constants of all candidates are the product of the candidate
+  matrix with the canonical dimensions of the coordinates/fields.
+  Independent of Qt.
+*******************************************************************************/
+class COperatorEnum
+{
+public:
+	enum ERelevance
+	{
+		eRelevant,
+		eMarginal,
+		eIrrelevant
+	};
+	struct SSettings
+	{
+		unsigned maxDegree;        // Of the fields, at least 2
+		unsigned maxDerivative;    // Sum over all coordinates
+		bool evenGradients;        // Isotropy: even number of gradients (1st coordinate)
+		bool evenOtherDerivatives; // Derivatives of further coordinates in pairs (e.g. QFT)
+		bool needResponseField;    // Dynamic functional: each term has a response field
+		bool needOtherField;       // Absorbing state: each term has a non-response field
+	};
+	struct SOperator
+	{
+		const int* exps;     // Per coordinate/field, column 0 without d
+		int expD;            // Coefficient of d in column 0
+		unsigned degree;     // Sum of field exponents
+		unsigned derivative; // Number of derivatives
+		double dim;          // Dimension of the coupling constant at the critical dimension
+		double dVal;         // Coefficient of d of that dimension
+		ERelevance relevance;
+	};
+	enum { MaxNumOperator = 200000 };
+private:
+	SSettings m_Settings;
+	size_t m_NumCoord;
+	std::vector<bool> m_ResponseField; // Per field
+	size_t m_Width;                    // Coordinates, fields, d
+	std::vector<int> m_Exps;           // Row major, m_Width columns
+	std::vector<unsigned> m_Degree;
+	std::vector<unsigned> m_Derivative;
+	std::vector<double> m_Dim;
+	std::vector<double> m_DVal;
+	std::vector<size_t> m_Order;       // Sorted by descending dimension
+	bool m_Truncated;
+	void addFields(std::vector<int>& row, size_t fx, unsigned degree, unsigned derivative);
+	void addDerivatives(std::vector<int>& row, size_t cx, unsigned derivative);
+public:
+	COperatorEnum(const SSettings&, size_t numCoord, const std::vector<bool>& responseField);
+	size_t enumerate();
+	void classify(const std::vector<double>& dimAtCritDim, const std::vector<double>& dVal, double critDim);
+	size_t size() const { return m_Degree.size(); }
+	bool truncated() const { return m_Truncated; }
+	void stream(const std::function<void(const SOperator&)>& sink) const;
+	static ERelevance relevance(double dim);
+};
+
+#endif
@@ -0,0 +1,176 @@
+/******************************************************************************/
+/**
+@file         CProfiler.cpp
+@copyright
+*
+@description  Scoped timers and counters for performance diagnostics.
+*******************************************************************************/
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include "CProfiler.h"
+#include "strutil.h"
+
+using std::string;
+using namespace std::chrono;
+
+/* METHOD *********************************************************************/
+/**
+  Ctor
+*******************************************************************************/
+CProfiler::CProfiler()
+	: m_Mutex()
+	, m_Stats()
+	, m_TraceEvents()
+	, m_TraceFile()
+	, m_Start(steady_clock::now())
+	, m_Dumped(false)
+{
+}
+
+/* METHOD *********************************************************************/
+/**
+  Dtor. Dumps the summary at exit, unless dump() was already called.
+*******************************************************************************/
+CProfiler::~CProfiler()
+{
+#ifdef KANON_PROFILE
+	if (!m_Dumped)
+	{
+		dump();
+	}
+#endif
+}
+
+/* FUNCTION *******************************************************************/
+/**
+@return Singleton instance
+*******************************************************************************/
+CProfiler& CProfiler::instance()
+{
+	static CProfiler s_Profiler;
+	return s_Profiler;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Adds num to the counter name.
+@param name: Static string (e.g. "filesParsed")
+*******************************************************************************/
+void CProfiler::count(const char* name, long long num)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Stats[name].m_Count += num;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Accumulates a timer interval, records a trace event if tracing is on.
+*******************************************************************************/
+void CProfiler::addInterval(const char* name, steady_clock::time_point start, steady_clock::time_point stop)
+{
+	const double ms{duration<double, std::milli>(stop - start).count()};
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	SStat& stat(m_Stats[name]);
+	stat.m_IsTimer = true;
+	stat.m_Count++;
+	stat.m_TotalMs += ms;
+	if (ms > stat.m_MaxMs)
+	{
+		stat.m_MaxMs = ms;
+	}
+	if (!m_TraceFile.empty())
+	{
+		STraceEvent ev;
+		ev.m_Name = name;
+		ev.m_StartUs = duration_cast<microseconds>(start - m_Start).count();
+		ev.m_DurationUs = duration_cast<microseconds>(stop - start).count();
+		ev.m_ThreadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+		m_TraceEvents.push_back(ev);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Enables recording of trace events, written by dump().
+@param pathname: Destination of the Chrome trace (JSON), empty to disable.
+*******************************************************************************/
+void CProfiler::setTraceFile(const string& pathname)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_TraceFile = pathname;
+}
+
+/* METHOD *********************************************************************/
+/**
+*******************************************************************************/
+void CProfiler::reset()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Stats.clear();
+	m_TraceEvents.clear();
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Table of timers and counters
+*******************************************************************************/
+string CProfiler::summary()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	string ret(toString("%-28s %10s %12s %10s %10s\n", "Timer/counter", "Count", "Total [ms]", "Mean [ms]", "Max [ms]"));
+	for (const auto& elem : m_Stats)
+	{
+		const SStat& stat(elem.second);
+		if (stat.m_IsTimer)
+		{
+			ret += toString("%-28s %10lld %12.3f %10.4f %10.4f\n", elem.first.c_str(), stat.m_Count,
+				stat.m_TotalMs, stat.m_TotalMs / stat.m_Count, stat.m_MaxMs);
+		}
+		else
+		{
+			ret += toString("%-28s %10lld\n", elem.first.c_str(), stat.m_Count);
+		}
+	}
+	return ret;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Writes the summary to stderr and the trace file (if any).
+*******************************************************************************/
+void CProfiler::dump()
+{
+	m_Dumped = true;
+	fprintf(stderr, "%s", summary().c_str());
+	writeTrace();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Writes trace events in the Chrome trace event format.
+*******************************************************************************/
+void CProfiler::writeTrace()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_TraceFile.empty())
+	{
+		return;
+	}
+	FILE* file{fopen(m_TraceFile.c_str(), "w")};
+	if (!file)
+	{
+		fprintf(stderr, "Cannot write trace file %s\n", m_TraceFile.c_str());
+		return;
+	}
+	fprintf(file, "{\"traceEvents\":[\n");
+	for (size_t ix{}; ix < m_TraceEvents.size(); ix++)
+	{
+		const STraceEvent& ev(m_TraceEvents[ix]);
+		fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%lld,\"dur\":%lld}%s\n",
+			ev.m_Name, ev.m_ThreadId % 100000, ev.m_StartUs, ev.m_DurationUs,
+			ix + 1 < m_TraceEvents.size() ? "," : "");
+	}
+	fprintf(file, "],\n\"displayTimeUnit\":\"ms\"}\n");
+	fclose(file);
+}
@@ -0,0 +1,93 @@
+/******************************************************************************/
+/**
+@file         CProfiler.h
+@copyright
+*
+@description  Scoped timers and counters for performance diagnostics.
+  Compiled in with DEFINES += KANON_PROFILE (see kanon.pro), otherwise the
+  PROFILE_XXX macros expand to nothing.
+*******************************************************************************/
+#ifndef CPROFILER_H
+#define CPROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* CONSTANT DECLARATIONS ******************************************************/
+#ifdef KANON_PROFILE
+#	define PROFILE_CONCAT2(a, b) a##b
+#	define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#	define PROFILE_SCOPE(name) const CProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#	define PROFILE_COUNT(name, num) CProfiler::instance().count(name, num)
+#	define PROFILE_DUMP() CProfiler::instance().dump()
+#else
+#	define PROFILE_SCOPE(name) do {} while (0)
+#	define PROFILE_COUNT(name, num) do {} while (0)
+#	define PROFILE_DUMP() do {} while (0)
+#endif
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Singleton collecting timer and counter statistics.
+  Optionally records the timer intervals as Chrome trace events
+  (chrome://tracing, JSON object format with a "traceEvents" array), see
+  setTraceFile().
+*******************************************************************************/
+class CProfiler
+{
+	struct SStat
+	{
+		bool   m_IsTimer;
+		long long m_Count;  // Number of intervals or accumulated counter value
+		double m_TotalMs;
+		double m_MaxMs;
+		SStat() : m_IsTimer(), m_Count(), m_TotalMs(), m_MaxMs() {}
+	};
+	struct STraceEvent
+	{
+		const char* m_Name;
+		long long m_StartUs;
+		long long m_DurationUs;
+		size_t m_ThreadId;
+	};
+	std::mutex m_Mutex;
+	std::map<std::string, SStat> m_Stats;
+	std::vector<STraceEvent> m_TraceEvents;
+	std::string m_TraceFile;
+	const std::chrono::steady_clock::time_point m_Start;
+	std::atomic<bool> m_Dumped;      // Set by dump() on any thread, read by the dtor
+	CProfiler();
+	void writeTrace();
+public:
+	~CProfiler();
+	static CProfiler& instance();
+	void count(const char* name, long long num = 1);
+	void addInterval(const char* name, std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point stop);
+	void setTraceFile(const std::string& pathname);
+	void reset();
+	std::string summary();
+	void dump();
+};
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Measures the lifetime of the instance. Use via PROFILE_SCOPE().
+*******************************************************************************/
+class CProfileScope
+{
+	const char* m_Name;
+	const std::chrono::steady_clock::time_point m_Start;
+public:
+	CProfileScope(const char* name) : m_Name(name), m_Start(std::chrono::steady_clock::now()) {}
+	~CProfileScope()
+	{
+		CProfiler::instance().addInterval(m_Name, m_Start, std::chrono::steady_clock::now());
+	}
+};
+
+#endif
@@ -0,0 +1,671 @@
+/******************************************************************************/
+/**
+@file         CQueryServer.cpp
+@copyright
+*
+@description  Query daemon over the evaluated model library.
+*******************************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QTimer>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+#include "CModelData.h"
+#include "CProfiler.h"
+#include "CQueryServer.h"
+#include "Util.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+	QJsonObject error(const string& text)
+	{
+		QJsonObject reply;
+		reply["ok"] = false;
+		reply["error"] = QString::fromStdString(text);
+		return reply;
+	}
+	void printErrors(const vector<string>& errMsgs)
+	{
+		for (const auto& errMsg : errMsgs)
+		{
+			fprintf(stderr, "%s\n", errMsg.c_str());
+		}
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Ctor, loads and evaluates the library.
+@param path: Directory of the *.kxm files
+*******************************************************************************/
+CQueryServer::CQueryServer(const string& path, QObject* parent)
+	: QObject(parent)
+	, m_Path(path)
+	, m_Server(new QLocalServer(this))
+	, m_Watcher(new QFileSystemWatcher(this))
+	, m_RefreshTimer(new QTimer(this))
+	, m_NumRequest()
+	, m_Replies()
+	, m_Jobs()
+	, m_Stop()
+	, m_Mutex()
+	, m_JobAdded()
+	, m_Workers()
+{
+	vector<string> errMsgs;
+	CModelData::loadLibrary(m_Path, errMsgs);
+	printErrors(errMsgs);
+	fprintf(stderr, "%u models in %s\n", unsigned(CModelData::size()), m_Path.c_str());
+	m_Watcher->addPath(m_Path.c_str());
+	CModelData::updateWatcher(*m_Watcher, m_Path);
+	m_RefreshTimer->setSingleShot(true);
+	m_RefreshTimer->setInterval(250);
+	connect(m_Watcher, SIGNAL(directoryChanged(const QString&)), m_RefreshTimer, SLOT(start()));
+	connect(m_Watcher, SIGNAL(fileChanged(const QString&)), m_RefreshTimer, SLOT(start()));
+	connect(m_RefreshTimer, SIGNAL(timeout()), this, SLOT(onLibraryChanged()));
+	connect(m_Server, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+	const unsigned numWorkers{std::max(1U, std::thread::hardware_concurrency())};
+	for (unsigned tx{}; tx < numWorkers; tx++)
+	{
+		m_Workers.emplace_back(&CQueryServer::work, this);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Dtor, stops the workers (evaluations not started are dropped).
+*******************************************************************************/
+CQueryServer::~CQueryServer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_JobAdded.notify_all();
+	for (auto& worker : m_Workers)
+	{
+		worker.join();
+	}
+	for (const auto& job : m_Jobs)
+	{
+		if (job.temporary)
+		{
+			QFile::remove(job.pathname.c_str());
+		}
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Worker thread: loads and evaluates the models of "evaluate" requests, the
+  replies are completed on the event loop (see finishEvaluate()). The
+  library is not accessed.
+*******************************************************************************/
+void CQueryServer::work()
+{
+	for (;;)
+	{
+		SJob job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_JobAdded.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+			if (m_Stop)
+			{
+				return;
+			}
+			job = m_Jobs.front();
+			m_Jobs.pop_front();
+		}
+		const std::shared_ptr<CModelData> mod(std::make_shared<CModelData>());
+		bool valid{};
+		string errMsg;
+		const bool ok{loadEvaluate(job.pathname, *mod, valid, errMsg)};
+		QMetaObject::invokeMethod(this, [this, job, mod, ok, valid, errMsg]()
+		{
+			finishEvaluate(job, ok ? mod.get() : nullptr, valid, errMsg);
+		}, Qt::QueuedConnection);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Slot: Applies changes of the library directory or archive.
+*******************************************************************************/
+void CQueryServer::onLibraryChanged()
+{
+	vector<string> errMsgs;
+	if (CModelData::refreshLibrary(m_Path, errMsgs))
+	{
+		fprintf(stderr, "%u models in %s\n", unsigned(CModelData::size()), m_Path.c_str());
+	}
+	CModelData::updateWatcher(*m_Watcher, m_Path);
+	printErrors(errMsgs);
+}
+
+/* METHOD *********************************************************************/
+/**
+  Starts listening on a local socket (a stale socket of that name is removed).
+@param   name: Socket name
+@param errMsg: [out]
+@return true on success
+*******************************************************************************/
+bool CQueryServer::listen(const QString& name, string& errMsg)
+{
+	QLocalServer::removeServer(name);
+	if (!m_Server->listen(name))
+	{
+		errMsg = m_Server->errorString().toStdString();
+		return false;
+	}
+	fprintf(stderr, "Listening on %s\n", m_Server->fullServerName().toStdString().c_str());
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Slot
+*******************************************************************************/
+void CQueryServer::onNewConnection()
+{
+	while (QLocalSocket* socket = m_Server->nextPendingConnection())
+	{
+		connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+		connect(socket, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Slot: Drops the replies pending for the client.
+*******************************************************************************/
+void CQueryServer::onDisconnected()
+{
+	QLocalSocket* socket{qobject_cast<QLocalSocket*>(sender())};
+	if (socket)
+	{
+		m_Replies.erase(socket);
+		socket->deleteLater();
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Slot: Answers the complete lines received, partial lines stay buffered.
+  Replies following one of a pending evaluation are held back.
+*******************************************************************************/
+void CQueryServer::onReadyRead()
+{
+	QLocalSocket* socket{qobject_cast<QLocalSocket*>(sender())};
+	if (socket)
+	{
+		while (socket->canReadLine())
+		{
+			const TReply reply(std::make_shared<SReply>());
+			m_Replies[socket].push_back(reply);
+			reply->text = handle(socket->readLine(), socket, reply);
+			reply->done = !reply->text.isEmpty();
+		}
+		writeReplies(socket);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Sends the replies completed, up to the first pending one.
+*******************************************************************************/
+void CQueryServer::writeReplies(QLocalSocket* socket)
+{
+	const auto it(m_Replies.find(socket));
+	if (it == m_Replies.end())
+	{	// Disconnected
+		return;
+	}
+	std::deque<TReply>& replies(it->second);
+	while (!replies.empty() && replies.front()->done)
+	{
+		socket->write(replies.front()->text);
+		replies.pop_front();
+	}
+	socket->flush();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Queues an "evaluate" request for the workers.
+@param reply: Completed by finishEvaluate()
+@return false if the model cannot be passed to a worker
+*******************************************************************************/
+bool CQueryServer::startEvaluate(const QJsonObject& request, QLocalSocket* socket, const TReply& reply,
+	string& errMsg)
+{
+	SJob job{socket, reply, request, string(), false};
+	if (!modelFile(request, job.pathname, job.temporary, errMsg))
+	{
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back(job);
+	}
+	m_JobAdded.notify_one();
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Completes the reply of an evaluation on the event loop (compares with the
+  library in its current state) and sends it, if the client is connected.
+@param mod: Evaluated model, nullptr if it could not be loaded
+*******************************************************************************/
+void CQueryServer::finishEvaluate(const SJob& job, const CModelData* mod, bool valid, const string& errMsg)
+{
+	if (job.temporary)
+	{
+		QFile::remove(job.pathname.c_str());
+	}
+	QJsonObject reply;
+	try
+	{
+		reply = mod ? evaluated(*mod, valid) : error(errMsg);
+	}
+	catch (const std::exception& e)
+	{
+		reply = error(e.what());
+	}
+	job.reply->text = toLine(reply, job.request);
+	job.reply->done = true;
+	if (job.socket)
+	{
+		writeReplies(job.socket);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Serves requests from stdin until end of file. Changes of the library are
+  applied between requests.
+*******************************************************************************/
+void CQueryServer::serveStdio()
+{
+	string line;
+	while (std::getline(std::cin, line))
+	{
+		QCoreApplication::processEvents();
+		const QByteArray reply(handle(QByteArray::fromStdString(line)));
+		fwrite(reply.constData(), 1, size_t(reply.size()), stdout);
+		fflush(stdout);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Answers a request on the calling thread.
+@param line: Request (JSON object)
+@return Reply (JSON object) terminated by a line feed
+*******************************************************************************/
+QByteArray CQueryServer::handle(const QByteArray& line)
+{
+	return handle(line, nullptr, TReply());
+}
+
+/* METHOD *********************************************************************/
+/**
+@param     line: Request (JSON object)
+@param   socket: Client, nullptr: evaluate on the calling thread
+@param deferred: Reply completed by a worker (evaluation for a client)
+@return Reply (JSON object) terminated by a line feed, empty if deferred
+*******************************************************************************/
+QByteArray CQueryServer::handle(const QByteArray& line, QLocalSocket* socket, const TReply& deferred)
+{
+	PROFILE_SCOPE("query");
+	m_NumRequest++;
+	QJsonParseError parseError;
+	const QJsonDocument doc(QJsonDocument::fromJson(line.trimmed(), &parseError));
+	const QJsonObject request(doc.object()); // Empty unless an object
+	QJsonObject reply;
+	if (!doc.isObject())
+	{
+		reply = error("Invalid request: " + parseError.errorString().toStdString());
+	}
+	else
+	{
+		const QString cmd(request["cmd"].toString());
+		try
+		{
+			if (cmd == "list")
+			{
+				reply = list(request);
+			}
+			else if (cmd == "lookup")
+			{
+				reply = lookup(request);
+			}
+			else if (cmd == "evaluate" && socket)
+			{
+				string errMsg;
+				if (startEvaluate(request, socket, deferred, errMsg))
+				{
+					return QByteArray();
+				}
+				reply = error(errMsg);
+			}
+			else if (cmd == "evaluate")
+			{
+				reply = evaluate(request);
+			}
+			else if (cmd == "ping")
+			{
+				reply["ok"] = true;
+				reply["models"] = int(CModelData::size());
+				reply["requests"] = int(m_NumRequest);
+			}
+			else
+			{
+				reply = error("Unknown command: " + cmd.toStdString());
+			}
+		}
+		catch (const std::exception& e)
+		{
+			reply = error(e.what());
+		}
+	}
+	return toLine(reply, request);
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Reply (with the "id" of the request) terminated by a line feed
+*******************************************************************************/
+QByteArray CQueryServer::toLine(QJsonObject reply, const QJsonObject& request)
+{
+	if (request.contains("id"))
+	{	// Allows clients to match replies
+		reply["id"] = request["id"];
+	}
+	return QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\n';
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Models passing the filters, in the list order or sorted
+*******************************************************************************/
+QJsonObject CQueryServer::list(const QJsonObject& request) const
+{
+	vector<size_t> rows;
+	const string query(request["query"].toString().toStdString());
+	if (!query.empty())
+	{
+		string errMsg;
+		if (!CModelData::signatureIndex().query(query, rows, errMsg))
+		{
+			return error(errMsg.empty() ? "Invalid query: " + query : errMsg);
+		}
+	}
+	else
+	{
+		for (size_t ix{}; ix < CModelData::size(); ix++)
+		{
+			rows.push_back(ix);
+		}
+	}
+	const string name(request["name"].toString().toStdString());
+	if (!name.empty())
+	{
+		vector<size_t> found;
+		for (const size_t ix : rows)
+		{
+			if (stringMatchesFilter(name, CModelData::at(ix).name(), eCaseInsensitive))
+			{
+				found.push_back(ix);
+			}
+		}
+		rows.swap(found);
+	}
+	const QString sort(request["sort"].toString());
+	if (!sort.isEmpty())
+	{
+		int column{-1};
+		for (int cx{}; cx < CModelData::columnCount(); cx++)
+		{
+			if (0 == CModelData::columnCaption(cx).compare(sort, Qt::CaseInsensitive))
+			{
+				column = cx;
+			}
+		}
+		if (column < 0)
+		{
+			return error("Unknown column: " + sort.toStdString());
+		}
+		const bool descending{request["descending"].toBool()};
+		std::stable_sort(rows.begin(), rows.end(), [column, descending](size_t x, size_t y)
+		{
+			return descending ? CModelData::lessThan(column, CModelData::at(y), CModelData::at(x))
+				: CModelData::lessThan(column, CModelData::at(x), CModelData::at(y));
+		});
+	}
+	const int limit{request["limit"].toInt(-1)};
+	QJsonArray models;
+	for (size_t ix{}; ix < rows.size() && (limit < 0 || int(ix) < limit); ix++)
+	{
+		models.append(toJson(CModelData::at(rows[ix]), false));
+	}
+	QJsonObject reply;
+	reply["ok"] = true;
+	reply["count"] = int(rows.size());
+	reply["models"] = models;
+	return reply;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Library models with the name (case insensitive) or the path given
+*******************************************************************************/
+QJsonObject CQueryServer::lookup(const QJsonObject& request) const
+{
+	const QString name(request["name"].toString());
+	const QString path(request["path"].toString());
+	const QString canonicalPath(QFileInfo(path).canonicalFilePath());
+	if (name.isEmpty() && path.isEmpty())
+	{
+		return error("lookup requires \"name\" or \"path\"");
+	}
+	QJsonArray models;
+	for (size_t ix{}; ix < CModelData::size(); ix++)
+	{
+		const CModelData& mod(CModelData::at(ix));
+		if ((!name.isEmpty() && 0 == name.compare(mod.name().c_str(), Qt::CaseInsensitive))
+			|| (!path.isEmpty() && (path == mod.pathname().c_str()
+			|| (!canonicalPath.isEmpty() && canonicalPath == QFileInfo(mod.pathname().c_str()).canonicalFilePath()))))
+		{
+			models.append(toJson(mod, true));
+		}
+	}
+	QJsonObject reply;
+	reply["ok"] = true;
+	reply["models"] = models;
+	return reply;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Evaluates a model which need not be part of the library, on the calling
+  thread.
+@return As evaluated()
+*******************************************************************************/
+QJsonObject CQueryServer::evaluate(const QJsonObject& request) const
+{
+	string pathname;
+	bool temporary{};
+	string errMsg;
+	if (!modelFile(request, pathname, temporary, errMsg))
+	{
+		return error(errMsg);
+	}
+	CModelData mod;
+	bool valid{};
+	const bool ok{loadEvaluate(pathname, mod, valid, errMsg)};
+	if (temporary)
+	{
+		QFile::remove(pathname.c_str());
+	}
+	return ok ? evaluated(mod, valid) : error(errMsg);
+}
+
+/* METHOD *********************************************************************/
+/**
+  File of the model of an "evaluate" request: its "path", or a temporary file
+  receiving its "model".
+@param  pathname: [out]
+@param temporary: [out] true if pathname is to be removed after use
+@return false if there is no model
+*******************************************************************************/
+bool CQueryServer::modelFile(const QJsonObject& request, string& pathname, bool& temporary, string& errMsg)
+{
+	pathname = request["path"].toString().toStdString();
+	temporary = false;
+	if (!pathname.empty())
+	{
+		return true;
+	}
+	const QByteArray content(request["model"].toString().toUtf8());
+	if (content.isEmpty())
+	{
+		errMsg = "evaluate requires \"path\" or \"model\"";
+		return false;
+	}
+	QTemporaryFile file(QDir::tempPath() + "/kanon_XXXXXX.kxm");
+	file.setAutoRemove(false);
+	if (!file.open() || file.write(content) != content.size())
+	{
+		errMsg = "Cannot write " + file.fileName().toStdString();
+		file.remove();
+		return false;
+	}
+	file.close();
+	pathname = file.fileName().toStdString();
+	temporary = true;
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Loads and evaluates a model, independent of the library (any thread).
+@param  valid: [out] Result of CModelData::evaluate()
+@return false if the model could not be loaded
+*******************************************************************************/
+bool CQueryServer::loadEvaluate(const string& pathname, CModelData& mod, bool& valid, string& errMsg)
+{
+	PROFILE_SCOPE("queryEvaluate");
+	try
+	{
+		if (!mod.loadData(pathname, errMsg, CModelData::eLoadHeader))
+		{
+			return false;
+		}
+		valid = mod.evaluate();
+	}
+	catch (const std::exception& e)
+	{
+		errMsg = e.what();
+		return false;
+	}
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Results, library models equivalent to mod (see CExpMatrix::canonical())
+*******************************************************************************/
+QJsonObject CQueryServer::evaluated(const CModelData& mod, bool valid) const
+{
+	QJsonObject reply;
+	reply["ok"] = true;
+	reply["valid"] = valid;
+	reply["model"] = toJson(mod, true);
+	QJsonArray duplicates;
+	const SHash128 hash(mod.expMatrix().canonicalHash(mod.sigmaMatrix()));
+	for (size_t ix{}; ix < CModelData::size(); ix++)
+	{
+		if (CModelData::at(ix).canonicalHash() == hash)
+		{
+			duplicates.append(QString(CModelData::at(ix).pathname().c_str()));
+		}
+	}
+	reply["duplicates"] = duplicates;
+	return reply;
+}
+
+/* METHOD *********************************************************************/
+/**
+@param details: Add the canonical dimensions of the coordinates and fields
+*******************************************************************************/
+QJsonObject CQueryServer::toJson(const CModelData& mod, bool details)
+{
+	QJsonObject obj;
+	obj["name"] = QString(mod.name().c_str());
+	obj["path"] = QString(mod.pathname().c_str());
+	obj["tag"] = QString(mod.category().c_str());
+	obj["flags"] = QString(mod.flags().c_str());
+	obj["numCoord"] = int(mod.numCoord());
+	obj["numField"] = int(mod.numField());
+	obj["numTerm"] = int(mod.numTerm());
+	const bool valid{mod.critDim() > CNumerics::INVALID_CRITDIM};
+	obj["critDim"] = valid ? QJsonValue(mod.critDim()) : QJsonValue();
+	QJsonArray normalVect;
+	for (const int val : mod.normalVect())
+	{
+		normalVect.append(val);
+	}
+	obj["normalVect"] = normalVect;
+	if (details && valid && mod.canDim().size() >= mod.modelOrder())
+	{
+		QJsonArray canDim;
+		for (size_t cx{}; cx < mod.modelOrder(); cx++)
+		{
+			QJsonObject dim;
+			dim["const"] = mod.canDim()[cx].constVal;
+			dim["d"] = mod.canDim()[cx].dVal;
+			dim["atCritDim"] = mod.getDimensionAtCritDim(cx);
+			canDim.append(dim);
+		}
+		obj["canDim"] = canDim;
+	}
+	return obj;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Client side (stand-in for tools): sends one request and waits for the reply.
+@param    name: Socket name
+@param request: JSON object
+@return Reply, empty on failure
+*******************************************************************************/
+QByteArray CQueryServer::query(const QString& name, const QByteArray& request, int timeoutMs)
+{
+	QLocalSocket socket;
+	socket.connectToServer(name);
+	if (!socket.waitForConnected(timeoutMs))
+	{
+		return QByteArray();
+	}
+	socket.write(request.trimmed() + '\n');
+	socket.flush();
+	QByteArray reply;
+	while (!reply.endsWith('\n') && socket.waitForReadyRead(timeoutMs))
+	{
+		reply += socket.readAll();
+	}
+	return reply;
+}
@@ -0,0 +1,103 @@
+/******************************************************************************/
+/**
+@file         CQueryServer.h
+@copyright
+*
+@description  Query daemon over the evaluated model library.
+*******************************************************************************/
+#ifndef CQUERYSERVER_H
+#define CQUERYSERVER_H
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <QtCore/QJsonObject>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+
+/* FORWARD DECLARATIONS *******************************************************/
+class CModelData;
+class QFileSystemWatcher;
+class QLocalServer;
+class QLocalSocket;
+class QTimer;
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Loads and evaluates the library once and keeps it up to date (see
+  CModelData::refreshLibrary()). Requests and replies are JSON objects, one
+  per line, received over a local socket (a Unix domain socket, a named pipe
+  on Windows) or stdin/stdout.
+  Requests ("cmd"):
+  - "list": Optional "query" (see CSignatureIndex::query()), "name" (part of
+    the name), "sort" (column caption), "descending", "limit".
+  - "lookup": "name" or "path" of a library model.
+  - "evaluate": "path" of a file or "model" (content of a *.kxm file).
+  - "ping"
+  The library is accessed by the event loop only, so it is refreshed between
+  requests. "list", "lookup" and "ping" are answered on the event loop; the
+  file of "evaluate" is loaded and evaluated by worker threads (the reply is
+  completed on the event loop), so a slow evaluation does not delay other
+  clients. Each client receives its replies in the order of its requests.
+*******************************************************************************/
+class CQueryServer : public QObject
+{
+	Q_OBJECT
+	struct SReply
+	{
+		QByteArray text;        // Line sent to the client
+		bool done;
+	};
+	typedef std::shared_ptr<SReply> TReply;
+	struct SJob
+	{
+		QPointer<QLocalSocket> socket;
+		TReply reply;
+		QJsonObject request;
+		std::string pathname;   // Model to evaluate
+		bool temporary;         // pathname removed when done
+	};
+	std::string m_Path;         // Library directory
+	QLocalServer* m_Server;
+	QFileSystemWatcher* m_Watcher;
+	QTimer* m_RefreshTimer;     // Collects change notifications
+	unsigned m_NumRequest;
+	std::map<QLocalSocket*, std::deque<TReply>> m_Replies; // Per client, in the order of the requests
+	std::deque<SJob> m_Jobs;    // Evaluations not yet started
+	bool m_Stop;
+	std::mutex m_Mutex;         // Guards m_Jobs, m_Stop
+	std::condition_variable m_JobAdded;
+	std::vector<std::thread> m_Workers;
+	void work();
+	QByteArray handle(const QByteArray& line, QLocalSocket*, const TReply& deferred);
+	bool startEvaluate(const QJsonObject& request, QLocalSocket*, const TReply&, std::string& errMsg);
+	void finishEvaluate(const SJob&, const CModelData*, bool valid, const std::string& errMsg);
+	void writeReplies(QLocalSocket*);
+	QJsonObject list(const QJsonObject& request) const;
+	QJsonObject lookup(const QJsonObject& request) const;
+	QJsonObject evaluate(const QJsonObject& request) const;
+	QJsonObject evaluated(const CModelData&, bool valid) const;
+	static bool modelFile(const QJsonObject& request, std::string& pathname, bool& temporary, std::string& errMsg);
+	static bool loadEvaluate(const std::string& pathname, CModelData&, bool& valid, std::string& errMsg);
+	static QByteArray toLine(QJsonObject reply, const QJsonObject& request);
+	static QJsonObject toJson(const CModelData&, bool details);
+public:
+	CQueryServer(const std::string& path, QObject* parent = nullptr);
+	~CQueryServer();
+	bool listen(const QString& name, std::string& errMsg);
+	QByteArray handle(const QByteArray& line);
+	void serveStdio();
+	static QByteArray query(const QString& name, const QByteArray& request, int timeoutMs = 30000);
+private slots:
+	void onNewConnection();
+	void onReadyRead();
+	void onDisconnected();
+	void onLibraryChanged();
+};
+
+#endif
@@ -0,0 +1,127 @@
+/******************************************************************************/
+/**
+@file         CReadAhead.cpp
+@copyright
+*
+@description  Reads files ahead of their consumer on a dedicated thread.
+*******************************************************************************/
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+#include <QtCore/QFile>
+#include "CProfiler.h"
+#include "CReadAhead.h"
+
+using std::string;
+using std::vector;
+
+/* METHOD *********************************************************************/
+/**
+  Ctor, starts reading.
+@param pathnames: Files in the order of next()
+*******************************************************************************/
+CReadAhead::CReadAhead(const vector<string>& pathnames)
+	: m_Pathnames(pathnames)
+	, m_Buffers()
+	, m_NumBuffered()
+	, m_NumConsumed()
+	, m_Stop()
+	, m_Mutex()
+	, m_Changed()
+	, m_Reader()
+{
+	if (!m_Pathnames.empty())
+	{
+		m_Reader = std::thread(&CReadAhead::read, this);
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Dtor, stops reading (files not consumed are dropped).
+*******************************************************************************/
+CReadAhead::~CReadAhead()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_Changed.notify_all();
+	if (m_Reader.joinable())
+	{
+		m_Reader.join();
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Reader thread: reads the files in order, waits while the window is full.
+*******************************************************************************/
+void CReadAhead::read()
+{
+	PROFILE_SCOPE("readAhead");
+	for (size_t fx{}; fx < m_Pathnames.size(); fx++)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Changed.wait(lock, [this]()
+			{
+				return m_Stop || m_Buffers.empty()
+					|| (m_Buffers.size() < MaxFiles && m_NumBuffered < size_t(MaxBytes));
+			});
+			if (m_Stop)
+			{
+				return;
+			}
+		}
+		QByteArray data;
+		QFile file(m_Pathnames[fx].c_str());
+		if (file.open(QIODevice::ReadOnly))
+		{
+#ifdef __linux__
+			// One large request instead of growing read-ahead windows
+			posix_fadvise(file.handle(), 0, 0, POSIX_FADV_WILLNEED);
+#endif
+			data = file.readAll();
+			if (data.isNull())
+			{	// Empty file, not a failure
+				data = QByteArray("");
+			}
+		}
+		PROFILE_COUNT("readAheadBytes", data.size());
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_NumBuffered += size_t(data.size());
+			m_Buffers.push_back(data);
+		}
+		m_Changed.notify_all();
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Waits for the next file.
+@param data: [out] Its content
+@return false if the file could not be read (or all files are consumed)
+*******************************************************************************/
+bool CReadAhead::next(QByteArray& data)
+{
+	data = QByteArray();
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	if (m_NumConsumed >= m_Pathnames.size())
+	{
+		return false;
+	}
+	if (m_Buffers.empty())
+	{
+		PROFILE_COUNT("readAheadStalls", 1);
+		m_Changed.wait(lock, [this]() { return !m_Buffers.empty(); });
+	}
+	data = m_Buffers.front();
+	m_Buffers.pop_front();
+	m_NumBuffered -= size_t(data.size());
+	m_NumConsumed++;
+	lock.unlock();
+	m_Changed.notify_all();
+	return !data.isNull();
+}
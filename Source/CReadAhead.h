@@ -0,0 +1,52 @@
+/******************************************************************************/
+/**
+@file         CReadAhead.h
+@copyright
+*
+@description  Reads files ahead of their consumer on a dedicated thread.
+*******************************************************************************/
+#ifndef CREADAHEAD_H
+#define CREADAHEAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <QtCore/QByteArray>
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  I/O stage of the library load: a reader thread reads the files in the
+  given order into buffers, while the caller parses the previous ones
+  (see CModelData::loadLibrary()). At most MaxFiles files or MaxBytes bytes
+  are buffered ahead of the caller. next() returns the files in order.
+*******************************************************************************/
+class CReadAhead
+{
+public:
+	enum
+	{
+		MaxFiles = 32,
+		MaxBytes = 16 << 20
+	};
+private:
+	std::vector<std::string> m_Pathnames;
+	std::deque<QByteArray> m_Buffers;    // Read, not yet consumed; null: failed
+	size_t m_NumBuffered;                // Bytes in m_Buffers
+	size_t m_NumConsumed;
+	bool m_Stop;
+	std::mutex m_Mutex;
+	std::condition_variable m_Changed;
+	std::thread m_Reader;
+	CReadAhead(const CReadAhead&) = delete;
+	CReadAhead& operator=(const CReadAhead&) = delete;
+	void read();
+public:
+	explicit CReadAhead(const std::vector<std::string>& pathnames);
+	~CReadAhead();
+	bool next(QByteArray& data);
+};
+
+#endif
@@ -0,0 +1,269 @@
+/******************************************************************************/
+/**
+@file         CReportRenderer.cpp
+@copyright
+*
+@description  Renders model reports to PDF or SVG files without GUI.
+*******************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QUrl>
+#include <QtGui/QImage>
+#include <QtGui/QPainter>
+#include <QtGui/QPdfWriter>
+#include <QtGui/QTextDocument>
+#include <QtSvg/QSvgGenerator>
+#include "CFormula.h"
+#include "CModelData.h"
+#include "CProfiler.h"
+#include "CReportRenderer.h"
+#include "HtmlOutput.h"
+#include "strutil.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+	const int DocumentPointSize{11}; // As CDlgHtml
+	const int FormulaScale{4};       // Pixels of the pictures per pixel of the layout, for print resolution
+	const qreal SvgWidth{800};       // Layout width of SVG reports
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Paints formula into an image (as CFormulaPixmap, without widget), adds it
+	  to the resources of doc.
+	@return <img> tag referring to the image
+	*******************************************************************************/
+	string addFormulaImage(QTextDocument& doc, const CFormula& formula, const CModelData& mod, size_t tx)
+	{
+		QFont font(doc.defaultFont());
+		const QFontMetrics fm(font);
+		const int height{2 * fm.height()};
+		int width{};
+		{	// Measure
+			QImage probe(1, 1, QImage::Format_ARGB32_Premultiplied);
+			QPainter p(&probe);
+			p.setFont(font);
+			width = std::max(1, formula.paint(p, mod));
+		}
+		QImage image(width * FormulaScale, height * FormulaScale, QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::transparent);
+		{
+			QPainter p(&image);
+			p.setRenderHint(QPainter::Antialiasing);
+			p.setRenderHint(QPainter::TextAntialiasing);
+			p.scale(FormulaScale, FormulaScale);
+			p.setFont(font);
+			p.translate(0, height/2 + fm.ascent()/3);
+			formula.paint(p, mod);
+		}
+		const string url(toString("formula:%d", int(tx)));
+		doc.addResource(QTextDocument::ImageResource, QUrl(url.c_str()), image);
+		return toString("<img src=\"%s\" width=\"%d\" height=\"%d\"/>", url.c_str(), width, height);
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Attempts the terms of the model as interaction until one works (as
+	  CNumerics::evaluate()).
+	@param rxInteraction: [out] Term used as coupling constant
+	@return false if the model has no critical dimension
+	*******************************************************************************/
+	bool determineInteraction(CModelData& mod, size_t& rxInteraction, string& errMsg)
+	{
+		for (rxInteraction = 0; rxInteraction < mod.modelOrder(); rxInteraction++)
+		{
+			try
+			{
+				if (!mod.determineCanonicalDimensions(rxInteraction))
+				{
+					errMsg = "No critical dimension";
+					return false;
+				}
+				if (mod.canDim().size() == 1 + mod.numTerm())
+				{
+					return true;
+				}
+			}
+			catch (const std::exception& e)
+			{
+				errMsg = e.what();
+			}
+		}
+		if (errMsg.empty())
+		{
+			errMsg = "No term usable as interaction";
+		}
+		return false;
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Ctor
+@param outDir: Directory receiving the files
+*******************************************************************************/
+CReportRenderer::CReportRenderer(const string& outDir, EFormat format)
+	: m_OutDir(outDir)
+	, m_Format{format}
+{
+}
+
+/* METHOD *********************************************************************/
+/**
+@return File of the report of mod: its base name in the output directory
+*******************************************************************************/
+string CReportRenderer::pathname(const CModelData& mod) const
+{
+	const QString baseName(QFileInfo(mod.pathname().c_str()).completeBaseName());
+	return QDir(m_OutDir.c_str()).filePath(baseName + (m_Format == eFormatPdf ? ".pdf" : ".svg")).toStdString();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Renders the report of a model. May run on any thread, for distinct models.
+@precondition mod loaded completely (see CModelData::ensureLoaded()).
+@param    mod: Its canonical dimensions are determined.
+@param errMsg: [out] Reason of a failure
+@return true if the file has been written
+*******************************************************************************/
+bool CReportRenderer::render(CModelData& mod, string& errMsg) const
+{
+	PROFILE_SCOPE("renderReport");
+	errMsg.clear();
+	const string path(pathname(mod));
+	try
+	{
+		size_t rxInteraction{};
+		if (!determineInteraction(mod, rxInteraction, errMsg))
+		{
+			return false;
+		}
+		CHtmlReport report;
+		report.update(mod, rxInteraction);
+		QTextDocument doc;
+		QFont font(doc.defaultFont());
+		font.setPointSize(DocumentPointSize);
+		doc.setDefaultFont(font);
+		vector<string> images;
+		for (size_t tx{}; tx < mod.monomials().size(); tx++)
+		{
+			images.push_back(addFormulaImage(doc, mod.monomials()[tx], mod, tx));
+		}
+		string html;
+		report.write([&html](const string& text) { html += text; }, htmlTermTable(mod, images));
+		doc.setHtml(QString::fromUtf8(html.c_str()));
+		if (m_Format == eFormatPdf)
+		{
+			QPdfWriter writer(path.c_str());
+			writer.setPageSize(QPageSize(QPageSize::A4));
+			writer.setPageMargins(QMarginsF(15, 15, 15, 15), QPageLayout::Millimeter);
+			writer.setTitle(mod.name().c_str());
+			writer.setCreator("Kanon");
+			doc.print(&writer);
+		}
+		else
+		{
+			doc.setTextWidth(SvgWidth);
+			const QSizeF size(doc.size());
+			QSvgGenerator generator;
+			generator.setFileName(path.c_str());
+			generator.setSize(size.toSize());
+			generator.setViewBox(QRectF(QPointF(), size));
+			generator.setTitle(mod.name().c_str());
+			QPainter p;
+			if (!p.begin(&generator))
+			{
+				errMsg = "Cannot write " + path;
+				return false;
+			}
+			doc.drawContents(&p);
+			p.end();
+		}
+	}
+	catch (const std::exception& e)
+	{
+		errMsg = e.what();
+		return false;
+	}
+	if (!QFileInfo(path.c_str()).exists())
+	{
+		errMsg = "Cannot write " + path;
+		return false;
+	}
+	return true;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Renders all models of the library (see CModelData::loadLibrary()). The
+  list entries are copied and loaded completely first, so the workers share
+  no model.
+@param numThreads: 0: One per core
+@param    errMsgs: [out] Appended, one per failed model
+@return Number of files written
+*******************************************************************************/
+size_t CReportRenderer::renderLibrary(unsigned numThreads, vector<string>& errMsgs) const
+{
+	PROFILE_SCOPE("renderLibrary");
+	if (!QDir().mkpath(m_OutDir.c_str()))
+	{
+		errMsgs.push_back("Cannot create " + m_OutDir);
+		return 0;
+	}
+	vector<CModelData> models;
+	models.reserve(CModelData::size());
+	for (size_t ix{}; ix < CModelData::size(); ix++)
+	{
+		CModelData mod(CModelData::at(ix));
+		string errMsg;
+		if (mod.ensureLoaded(errMsg))
+		{
+			models.push_back(mod);
+		}
+		else
+		{
+			errMsgs.push_back(errMsg);
+		}
+	}
+	if (numThreads == 0)
+	{
+		numThreads = std::max(1U, std::thread::hardware_concurrency());
+	}
+	std::atomic<size_t> next{0};
+	vector<string> modelErrMsgs(models.size());
+	auto work = [&]()
+	{
+		for (size_t ix{next++}; ix < models.size(); ix = next++)
+		{
+			render(models[ix], modelErrMsgs[ix]);
+		}
+	};
+	vector<std::thread> workers;
+	for (unsigned tx{1}; tx < std::min(size_t(numThreads), models.size()); tx++)
+	{
+		workers.emplace_back(work);
+	}
+	work();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+	size_t ret{};
+	for (size_t ix{}; ix < models.size(); ix++)
+	{
+		if (modelErrMsgs[ix].empty())
+		{
+			ret++;
+		}
+		else
+		{
+			errMsgs.push_back(models[ix].pathname() + ": " + modelErrMsgs[ix]);
+		}
+	}
+	return ret;
+}
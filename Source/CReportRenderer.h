@@ -0,0 +1,45 @@
+/******************************************************************************/
+/**
+@file         CReportRenderer.h
+@copyright
+*
+@description  Renders model reports to PDF or SVG files without GUI.
+*******************************************************************************/
+#ifndef CREPORTRENDERER_H
+#define CREPORTRENDERER_H
+
+#include <string>
+#include <vector>
+
+/* FORWARD DECLARATIONS *******************************************************/
+class CModelData;
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Writes the report of a model (see CHtmlReport), with the terms of the
+  Lagrangian as pictures (see CFormula::paint(), against the coordinates and
+  fields of the model itself), into one file per model.
+  No dialogs and no widgets are used: a QGuiApplication, e.g. on the
+  "offscreen" platform plugin, suffices. renderLibrary() renders the models
+  of the library on several threads; the files are read beforehand on the
+  calling thread.
+*******************************************************************************/
+class CReportRenderer
+{
+public:
+	enum EFormat
+	{
+		eFormatPdf, // A4 pages
+		eFormatSvg  // One picture of the complete report
+	};
+private:
+	std::string m_OutDir;
+	EFormat m_Format;
+public:
+	CReportRenderer(const std::string& outDir, EFormat format);
+	std::string pathname(const CModelData& mod) const;
+	bool render(CModelData& mod, std::string& errMsg) const;
+	size_t renderLibrary(unsigned numThreads, std::vector<std::string>& errMsgs) const;
+};
+
+#endif
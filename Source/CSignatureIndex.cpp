@@ -0,0 +1,231 @@
+/******************************************************************************/
+/**
+@file         CSignatureIndex.cpp
+@copyright
+*
+@description  Lookup of library models by normal vector or critical dimension.
+*******************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "CSignatureIndex.h"
+#include "strutil.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+	const double DefaultTolerance{1e-6};
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Parses a number at pos, skips leading blanks.
+	@return false if no number found
+	*******************************************************************************/
+	bool parseNumber(const string& text, size_t& pos, double& val)
+	{
+		for (; pos < text.size() && isspace((unsigned char)text[pos]); pos++) {}
+		const char* begin{text.c_str() + pos};
+		char* end{};
+		val = strtod(begin, &end);
+		if (end == begin)
+		{
+			return false;
+		}
+		pos += size_t(end - begin);
+		for (; pos < text.size() && isspace((unsigned char)text[pos]); pos++) {}
+		return true;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return true if text at pos starts with token (pos is advanced).
+	*******************************************************************************/
+	bool skipToken(const string& text, size_t& pos, const string& token)
+	{
+		if (text.compare(pos, token.size(), token) == 0)
+		{
+			pos += token.size();
+			return true;
+		}
+		return false;
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+*******************************************************************************/
+void CSignatureIndex::clear()
+{
+	m_BySignature.clear();
+	m_ByCritDim.clear();
+}
+
+/* METHOD *********************************************************************/
+/**
+  Adds an evaluated model, finish() must be called after the last one.
+@param        row: Row in the model list
+@param normalVect: Normal vector (empty if not evaluated)
+@param   numCoord: Number of coordinates (the other components are fields)
+@param    critDim: Critical dimension (NaN if not determined)
+*******************************************************************************/
+void CSignatureIndex::add(size_t row, const vector<int>& normalVect, size_t numCoord, double critDim)
+{
+	if (!normalVect.empty())
+	{
+		m_BySignature[key(normalVect, numCoord)].push_back(row);
+	}
+	if (std::isfinite(critDim))
+	{
+		m_ByCritDim.push_back({critDim, row});
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Sorts the index on the critical dimension.
+*******************************************************************************/
+void CSignatureIndex::finish()
+{
+	std::sort(m_ByCritDim.begin(), m_ByCritDim.end());
+}
+
+/* METHOD *********************************************************************/
+/**
+  Models differing only in the order of the fields or of the coordinates (other
+  than the d-dimensional one) get the same key.
+@return Key of the signature, e.g. "2,1;1,1"
+*******************************************************************************/
+string CSignatureIndex::key(const vector<int>& normalVect, size_t numCoord)
+{
+	vector<int> sorted(normalVect);
+	numCoord = std::min(numCoord, sorted.size());
+	if (numCoord > 1)
+	{
+		std::sort(sorted.begin() + 1, sorted.begin() + numCoord);
+	}
+	std::sort(sorted.begin() + numCoord, sorted.end());
+	string ret;
+	for (size_t cx{}; cx < sorted.size(); cx++)
+	{
+		if (cx > 0)
+		{
+			ret += cx == numCoord ? ";" : ",";
+		}
+		ret += toString(sorted[cx]);
+	}
+	return ret;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Rows of the models with the given signature (in list order)
+*******************************************************************************/
+vector<size_t> CSignatureIndex::findSignature(const vector<int>& normalVect, size_t numCoord) const
+{
+	const auto it(m_BySignature.find(key(normalVect, numCoord)));
+	return it == m_BySignature.end() ? vector<size_t>() : it->second;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Rows of the models with lo <= critical dimension <= hi (in list order)
+*******************************************************************************/
+vector<size_t> CSignatureIndex::findCritDim(double lo, double hi) const
+{
+	vector<size_t> rows;
+	auto it(std::lower_bound(m_ByCritDim.begin(), m_ByCritDim.end(), std::make_pair(lo, size_t(0))));
+	for (; it != m_ByCritDim.end() && it->first <= hi; ++it)
+	{
+		rows.push_back(it->second);
+	}
+	std::sort(rows.begin(), rows.end());
+	return rows;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Evaluates a search text:
+  "2, 1; 1, 1"  Normal vector (coordinates; fields)
+  "4"           Critical dimension
+  "4 +- 0.1"    Critical dimension within a tolerance ("±" also accepted)
+  "3.5 .. 4.5"  Range of the critical dimension
+@param    text: Search text
+@param    rows: [out] Rows of the matching models, in list order
+@param  errMsg: [out] Set if the text is no valid query
+@return true if the text is a query of this index
+*******************************************************************************/
+bool CSignatureIndex::query(const string& text, vector<size_t>& rows, string& errMsg) const
+{
+	rows.clear();
+	errMsg.clear();
+	// Keep strtod() from taking the dot of ".." as decimal point.
+	const string str(trimWhite(replace(text, "..", " .. ", 9999)));
+	size_t pos{};
+	double val{};
+	if (!parseNumber(str, pos, val))
+	{
+		return false;
+	}
+	if (pos < str.size() && (str[pos] == ',' || str[pos] == ';'))
+	{	// Normal vector
+		vector<int> normalVect{int(val)};
+		size_t numCoord{};
+		for (; pos < str.size();)
+		{
+			if (str[pos] == ';')
+			{
+				numCoord = normalVect.size();
+			}
+			else if (str[pos] != ',')
+			{
+				errMsg = "Invalid normal vector, expected e.g. \"2, 1; 1, 1\"";
+				return true;
+			}
+			++pos;
+			if (!parseNumber(str, pos, val))
+			{
+				errMsg = "Invalid normal vector, expected e.g. \"2, 1; 1, 1\"";
+				return true;
+			}
+			normalVect.push_back(int(val));
+		}
+		if (numCoord == 0)
+		{
+			errMsg = "Separate coordinates and fields by ';'";
+			return true;
+		}
+		rows = findSignature(normalVect, numCoord);
+		return true;
+	}
+	double lo{val - DefaultTolerance};
+	double hi{val + DefaultTolerance};
+	double arg{};
+	if (skipToken(str, pos, "+-") || skipToken(str, pos, "\xC2\xB1"))
+	{	// Tolerance (also UTF-8 "±")
+		if (!parseNumber(str, pos, arg))
+		{
+			errMsg = "Tolerance expected";
+			return true;
+		}
+		lo = val - fabs(arg);
+		hi = val + fabs(arg);
+	}
+	else if (skipToken(str, pos, ".."))
+	{
+		if (!parseNumber(str, pos, arg))
+		{
+			errMsg = "Upper bound expected";
+			return true;
+		}
+		lo = std::min(val, arg);
+		hi = std::max(val, arg);
+	}
+	if (pos < str.size())
+	{
+		return false;
+	}
+	rows = findCritDim(lo, hi);
+	return true;
+}
@@ -0,0 +1,39 @@
+/******************************************************************************/
+/**
+@file         CSignatureIndex.h
+@copyright
+*
+@description  Lookup of library models by normal vector or critical dimension.
+*******************************************************************************/
+#ifndef CSIGNATUREINDEX_H
+#define CSIGNATUREINDEX_H
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Index over the evaluated model list: a hash map on the normal vector (with
+  sorted field components, see key()) and an ordered index on the critical
+  dimension. Entries are rows of the list; rebuild after the list changed.
+  Independent of Qt.
+*******************************************************************************/
+class CSignatureIndex
+{
+	std::unordered_map<std::string, std::vector<size_t>> m_BySignature;
+	std::vector<std::pair<double, size_t>> m_ByCritDim; // Sorted
+public:
+	CSignatureIndex() : m_BySignature(), m_ByCritDim() {}
+	void clear();
+	void add(size_t row, const std::vector<int>& normalVect, size_t numCoord, double critDim);
+	void finish();
+	size_t size() const { return m_ByCritDim.size(); }
+	std::vector<size_t> findSignature(const std::vector<int>& normalVect, size_t numCoord) const;
+	std::vector<size_t> findCritDim(double lo, double hi) const;
+	bool query(const std::string& text, std::vector<size_t>& rows, std::string& errMsg) const;
+	static std::string key(const std::vector<int>& normalVect, size_t numCoord);
+};
+
+#endif
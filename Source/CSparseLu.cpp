@@ -0,0 +1,341 @@
+/******************************************************************************/
+/**
+@file         CSparseLu.cpp
+@copyright
+*
+@description  Sparse LU factorization of a real square matrix.
+*******************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include "CLuFactor.h"
+#include "CSparseLu.h"
+
+using std::vector;
+
+namespace
+{
+	const double PivotThreshold{0.1}; // Pivot candidates: at least this fraction of the column maximum
+	const size_t SearchColumns{4};    // Columns of least count examined per pivot
+}
+
+/* METHOD *********************************************************************/
+/**
+@param a: Matrix (see SCsrMatrix::finish())
+@return false if the matrix is singular
+*******************************************************************************/
+bool CSparseLu::factorize(const SCsrMatrix& a)
+{
+	const size_t n{a.n};
+	m_N = n;
+	m_PivRow.clear();
+	m_PivCol.clear();
+	m_L.clear();
+	m_U.clear();
+	m_Diag.clear();
+	m_NumNonZero = 0;
+	m_Singular = false;
+	m_Rows.assign(n, TEntries());
+	m_ColRows.assign(n, vector<size_t>());
+	m_ColQueue.clear();
+	vector<double> colSums(n);
+	for (size_t rx{}; rx < n; rx++)
+	{
+		for (size_t ix{a.rowStart[rx]}; ix < a.rowStart[rx + 1]; ix++)
+		{
+			m_Rows[rx].push_back(std::make_pair(a.col[ix], a.val[ix]));
+			m_ColRows[a.col[ix]].push_back(rx);
+			colSums[a.col[ix]] += fabs(a.val[ix]);
+		}
+	}
+	m_Norm1 = n ? *std::max_element(colSums.begin(), colSums.end()) : 0.0;
+	for (size_t cx{}; cx < n; cx++)
+	{
+		m_ColQueue.insert(std::make_pair(m_ColRows[cx].size(), cx));
+	}
+	for (size_t k{}; k < n; k++)
+	{	// Markowitz search over the columns of least count
+		size_t pivRow{n}, pivCol{n}, bestCost{}, numSearched{};
+		double bestVal{};
+		for (auto it = m_ColQueue.begin(); it != m_ColQueue.end() && numSearched < SearchColumns; ++it, numSearched++)
+		{
+			const size_t count{it->first}, cx{it->second};
+			if (count == 0)
+			{
+				m_Singular = true;
+				break;
+			}
+			if (pivRow < n && bestCost == 0)
+			{	// No fill possible
+				break;
+			}
+			double amax{};
+			for (const size_t rx : m_ColRows[cx])
+			{
+				amax = std::max(amax, fabs(find(m_Rows[rx], cx)));
+			}
+			for (const size_t rx : m_ColRows[cx])
+			{
+				const double val{fabs(find(m_Rows[rx], cx))};
+				if (val < PivotThreshold * amax)
+				{
+					continue;
+				}
+				const size_t cost{(m_Rows[rx].size() - 1) * (count - 1)};
+				if (pivRow == n || cost < bestCost || (cost == bestCost && val > bestVal))
+				{
+					pivRow = rx;
+					pivCol = cx;
+					bestCost = cost;
+					bestVal = val;
+				}
+			}
+		}
+		if (m_Singular || pivRow == n)
+		{
+			m_Singular = true;
+			break;
+		}
+		eliminate(pivRow, pivCol);
+	}
+	m_Rows.clear();
+	m_ColRows.clear();
+	m_ColQueue.clear();
+	return !m_Singular;
+}
+
+/* METHOD *********************************************************************/
+/**
+  One elimination step: the pivot row becomes a row of U, the multipliers of
+  the other rows of the pivot column a column of L.
+*******************************************************************************/
+void CSparseLu::eliminate(size_t pivRow, size_t pivCol)
+{
+	TEntries pivEntries;
+	pivEntries.swap(m_Rows[pivRow]);
+	const double diag{find(pivEntries, pivCol)};
+	for (const auto& entry : pivEntries)
+	{	// The pivot row leaves the active submatrix
+		vector<size_t>& rows(m_ColRows[entry.first]);
+		rows.erase(std::find(rows.begin(), rows.end(), pivRow));
+		if (entry.first != pivCol)
+		{
+			setColCount(entry.first, rows.size() + 1);
+		}
+	}
+	m_ColQueue.erase(std::make_pair(m_ColRows[pivCol].size() + 1, pivCol));
+	TEntries lower;
+	vector<size_t> colRows;
+	colRows.swap(m_ColRows[pivCol]);
+	for (const size_t rx : colRows)
+	{	// Row rx -= f * pivot row, column pivCol vanishes
+		const TEntries& row(m_Rows[rx]);
+		const double f{find(row, pivCol) / diag};
+		lower.push_back(std::make_pair(rx, f));
+		TEntries merged;
+		merged.reserve(row.size() + pivEntries.size());
+		size_t ix{}, px{};
+		while (ix < row.size() || px < pivEntries.size())
+		{
+			const size_t cx{ix == row.size() ? pivEntries[px].first
+				: px == pivEntries.size() ? row[ix].first
+				: std::min(row[ix].first, pivEntries[px].first)};
+			const bool inRow{ix < row.size() && row[ix].first == cx};
+			const bool inPiv{px < pivEntries.size() && pivEntries[px].first == cx};
+			double val{inRow ? row[ix++].second : 0.0};
+			if (inPiv)
+			{
+				val -= f * pivEntries[px++].second;
+			}
+			if (cx == pivCol)
+			{
+				continue;
+			}
+			if (val != 0.0)
+			{
+				merged.push_back(std::make_pair(cx, val));
+				if (!inRow)
+				{	// Fill
+					m_ColRows[cx].push_back(rx);
+					setColCount(cx, m_ColRows[cx].size() - 1);
+				}
+			}
+			else if (inRow)
+			{	// Cancellation
+				vector<size_t>& rows(m_ColRows[cx]);
+				rows.erase(std::find(rows.begin(), rows.end(), rx));
+				setColCount(cx, rows.size() + 1);
+			}
+		}
+		m_Rows[rx].swap(merged);
+	}
+	m_NumNonZero += lower.size() + pivEntries.size();
+	m_PivRow.push_back(pivRow);
+	m_PivCol.push_back(pivCol);
+	m_L.push_back(TEntries());
+	m_L.back().swap(lower);
+	m_U.push_back(TEntries());
+	m_U.back().swap(pivEntries);
+	m_Diag.push_back(diag);
+}
+
+/* METHOD *********************************************************************/
+/**
+  Moves active column cx in the queue after its count changed.
+*******************************************************************************/
+void CSparseLu::setColCount(size_t cx, size_t oldCount)
+{
+	m_ColQueue.erase(std::make_pair(oldCount, cx));
+	m_ColQueue.insert(std::make_pair(m_ColRows[cx].size(), cx));
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Element of column cx of a sorted row, 0 if not stored
+*******************************************************************************/
+double CSparseLu::find(const TEntries& row, size_t cx)
+{
+	const auto it = std::lower_bound(row.begin(), row.end(), cx,
+		[](const std::pair<size_t, double>& entry, size_t col) { return entry.first < col; });
+	return it != row.end() && it->first == cx ? it->second : 0.0;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Solves A x = b for all columns of b.
+@precondition factorize() succeeded.
+@param      b: [in/out] n x numRhs, row major; replaced by the solutions.
+@param numRhs: Number of columns
+*******************************************************************************/
+void CSparseLu::solve(vector<double>& b, size_t numRhs) const
+{
+	for (size_t k{}; k < m_N; k++)
+	{	// Forward: apply the eliminations in order
+		const double* bp{&b[m_PivRow[k] * numRhs]};
+		for (const auto& entry : m_L[k])
+		{
+			double* br{&b[entry.first * numRhs]};
+			for (size_t ix{}; ix < numRhs; ix++)
+			{
+				br[ix] -= entry.second * bp[ix];
+			}
+		}
+	}
+	vector<double> x(m_N * numRhs);
+	for (size_t k{m_N}; k-- > 0;)
+	{	// Back substitution, later pivot columns are known
+		const size_t cx{m_PivCol[k]};
+		double* xc{&x[cx * numRhs]};
+		const double* bp{&b[m_PivRow[k] * numRhs]};
+		for (size_t ix{}; ix < numRhs; ix++)
+		{
+			xc[ix] = bp[ix];
+		}
+		for (const auto& entry : m_U[k])
+		{
+			if (entry.first != cx)
+			{
+				const double* xj{&x[entry.first * numRhs]};
+				for (size_t ix{}; ix < numRhs; ix++)
+				{
+					xc[ix] -= entry.second * xj[ix];
+				}
+			}
+		}
+		for (size_t ix{}; ix < numRhs; ix++)
+		{
+			xc[ix] /= m_Diag[k];
+		}
+	}
+	b.swap(x);
+}
+
+/* METHOD *********************************************************************/
+/**
+  Solves A^T x = b: A = M^-1 U, M the eliminations applied by solve() and U
+  the rows of m_U, so U^T w = b is solved in pivot order, then x = M^T w.
+@precondition factorize() succeeded.
+@param b: [in/out] n elements; replaced by the solution.
+*******************************************************************************/
+void CSparseLu::solveTransposed(vector<double>& b) const
+{
+	vector<double> w(m_N);
+	for (size_t k{}; k < m_N; k++)
+	{	// Column m_PivCol[k] of b is complete: earlier steps are subtracted
+		const size_t cx{m_PivCol[k]};
+		const double wk{b[cx] / m_Diag[k]};
+		w[m_PivRow[k]] = wk;
+		for (const auto& entry : m_U[k])
+		{
+			if (entry.first != cx)
+			{
+				b[entry.first] -= entry.second * wk;
+			}
+		}
+	}
+	for (size_t k{m_N}; k-- > 0;)
+	{	// Transposed eliminations in reverse order
+		double& wp(w[m_PivRow[k]]);
+		for (const auto& entry : m_L[k])
+		{
+			wp -= entry.second * w[entry.first];
+		}
+	}
+	b.swap(w);
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Estimate of 1 / (|A| |A^-1|) in the 1-norm, 0 if singular (see
+  CLuFactor::rcond())
+*******************************************************************************/
+double CSparseLu::rcond() const
+{
+	if (m_Singular || m_N == 0)
+	{
+		return 0.0;
+	}
+	const double normInv{estimateInverseNorm1(m_N, [this](vector<double>& b) { solve(b, 1); },
+		[this](vector<double>& b) { solveTransposed(b); })};
+	return normInv > 0.0 && m_Norm1 > 0.0 ? 1.0 / (m_Norm1 * normInv) : 0.0;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Determinant, 0 if singular
+*******************************************************************************/
+double CSparseLu::det() const
+{
+	if (m_Singular)
+	{
+		return 0.0;
+	}
+	double ret{double(permutationSign(m_PivRow) * permutationSign(m_PivCol))};
+	for (const double diag : m_Diag)
+	{
+		ret *= diag;
+	}
+	return ret;
+}
+
+/* METHOD *********************************************************************/
+/**
+@return Sign of a permutation of 0..n-1, by its cycles
+*******************************************************************************/
+int CSparseLu::permutationSign(const vector<size_t>& perm)
+{
+	vector<bool> visited(perm.size());
+	int sign{1};
+	for (size_t ix{}; ix < perm.size(); ix++)
+	{
+		size_t len{};
+		for (size_t jx{ix}; !visited[jx]; jx = perm[jx], len++)
+		{
+			visited[jx] = true;
+		}
+		if (len > 1 && len % 2 == 0)
+		{
+			sign = -sign;
+		}
+	}
+	return sign;
+}
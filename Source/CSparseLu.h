@@ -0,0 +1,95 @@
+/******************************************************************************/
+/**
+@file         CSparseLu.h
+@copyright
+*
+@description  Sparse LU factorization of a real square matrix.
+*******************************************************************************/
+#ifndef CSPARSELU_H
+#define CSPARSELU_H
+
+#include <cstddef>
+#include <set>
+#include <utility>
+#include <vector>
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Square matrix in compressed sparse row format. Rows are appended in order,
+  the elements of a row by ascending column; zeros are not stored.
+*******************************************************************************/
+struct SCsrMatrix
+{
+	size_t n;
+	std::vector<size_t> rowStart; // n + 1 entries, row rx is [rowStart[rx], rowStart[rx + 1])
+	std::vector<size_t> col;
+	std::vector<double> val;
+	explicit SCsrMatrix(size_t size = 0) : n{size}, rowStart(1, 0), col(), val() {}
+	void append(size_t rx, size_t cx, double value)
+	{	// rx must not decrease
+		while (rowStart.size() <= rx + 1)
+		{
+			rowStart.push_back(col.size());
+		}
+		if (value != 0.0)
+		{
+			col.push_back(cx);
+			val.push_back(value);
+			rowStart.back() = col.size();
+		}
+	}
+	void finish()
+	{	// Terminates the rows after the last appended one
+		while (rowStart.size() <= n)
+		{
+			rowStart.push_back(col.size());
+		}
+	}
+	size_t numNonZero() const { return val.size(); }
+};
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  P A Q = L U for sparse matrices. The pivots are chosen during elimination
+  by the Markowitz criterion (fill-reducing): a column of least count, in it a
+  row of least length among the candidates passing a threshold test against
+  the largest element of the column (partial pivoting relaxed to keep fill
+  low). Exact zeros arising from cancellation are dropped; a column without
+  element makes the matrix singular (as in CLuFactor).
+  One factorization serves any number of right hand side columns.
+  rcond() estimates the reciprocal condition from the factors (as CLuFactor).
+  Independent of Qt.
+*******************************************************************************/
+class CSparseLu
+{
+	typedef std::vector<std::pair<size_t, double>> TEntries; // Column or row index, value
+	size_t m_N;
+	double m_Norm1;                // Of A, max. column sum
+	std::vector<size_t> m_PivRow;  // Per step: row of A
+	std::vector<size_t> m_PivCol;  // Per step: column of A
+	std::vector<TEntries> m_L;     // Per step: rows of A below the pivot, multipliers
+	std::vector<TEntries> m_U;     // Per step: pivot row, columns of A (diagonal included)
+	std::vector<double> m_Diag;    // Per step
+	size_t m_NumNonZero;           // Of L and U, for statistics
+	bool m_Singular;
+	std::vector<TEntries> m_Rows;               // Active submatrix during factorize()
+	std::vector<std::vector<size_t>> m_ColRows; // Active rows per active column
+	std::set<std::pair<size_t, size_t>> m_ColQueue; // Active columns by count
+	void eliminate(size_t pivRow, size_t pivCol);
+	void setColCount(size_t cx, size_t oldCount);
+	static double find(const TEntries& row, size_t cx);
+	static int permutationSign(const std::vector<size_t>& perm);
+public:
+	CSparseLu() : m_N(), m_Norm1(), m_PivRow(), m_PivCol(), m_L(), m_U(), m_Diag(), m_NumNonZero(),
+		m_Singular(true), m_Rows(), m_ColRows(), m_ColQueue() {}
+	bool factorize(const SCsrMatrix& a);
+	void solve(std::vector<double>& b, size_t numRhs) const;
+	void solveTransposed(std::vector<double>& b) const;
+	double rcond() const;
+	double det() const;
+	size_t size() const { return m_N; }
+	size_t numNonZero() const { return m_NumNonZero; }
+	bool singular() const { return m_Singular; }
+};
+
+#endif
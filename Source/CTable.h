@@ -67,6 +67,15 @@ public:
     beginResetModel();
     endResetModel();
   }
+  // Incremental updates (proxy models and views keep filter, sort order and selection)
+  void beginInsert(int row) { beginInsertRows(QModelIndex(), row, row); }
+  void endInsert() { endInsertRows(); }
+  void beginRemove(int row) { beginRemoveRows(QModelIndex(), row, row); }
+  void endRemove() { endRemoveRows(); }
+  void rowChanged(int row)
+  {
+    emit dataChanged(index(row, 0), index(row, TTable::columnCount() - 1));
+  }
 };
 
 /* CLASS DECLARATION **********************************************************/
@@ -184,6 +193,32 @@ public:
       s_Array.erase(begin(s_Array) + ix);
     }
   }
+  static void insertRow(size_t ix, const TRow& row)
+  { // row.Pk must be set (see createPk()). Notifies the view.
+    s_TableModel->beginInsert(int(ix));
+    s_Array.insert(begin(s_Array) + ix, row);
+    s_TableModel->endInsert();
+  }
+  static void removeRow(size_t ix)
+  { // Like erase(), notifies the view.
+    if (ix < s_Array.size())
+    {
+      s_TableModel->beginRemove(int(ix));
+      s_Array.erase(begin(s_Array) + ix);
+      s_TableModel->endRemove();
+    }
+  }
+  static void notifyRowChanged(size_t ix)
+  { // Row ix was modified in place
+    s_TableModel->rowChanged(int(ix));
+  }
+  static void replaceRow(size_t ix, const TRow& row)
+  { // Keeps the primary key. Notifies the view.
+    const unsigned pk{s_Array.at(ix).Pk};
+    s_Array[ix] = row;
+    s_Array[ix].Pk = pk;
+    s_TableModel->rowChanged(int(ix));
+  }
   static bool del(unsigned pk)
   {
     for (size_t ix{}; ix < s_Array.size(); ix++) if (s_Array[ix].Pk == pk)
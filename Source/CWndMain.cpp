@@ -2,6 +2,7 @@
 *******************************************************************************/ 
 #include <cstdlib>
 #include <cstdio>
+#include <fstream>
 #include <string>
 #include <QtGui/QKeyEvent> 
 #include <QSettings>
@@ -32,6 +33,8 @@
 #include "CMmlWdgtOperator.h" 
 #include "CMmlWdgtRow.h" 
 #include "CModelData.h" 
+#include "CNumerics.h" 
+#include "CProfiler.h" 
 #include "CWndMain.h" 
 #include "HtmlOutput.h" 
 #include "strutil.h" 
@@ -52,9 +55,12 @@ namespace
 		idBtnCategory,
 		idBtnComment,
 		idBtnHelp,
+		idBtnOperators,
 		idBtnReferences,
 		idBtnResult,
 		idBtnTag,
+		idEditRedo,
+		idEditUndo,
 		idFileClose,
 		idFileModelList,
 		idFileNew,
@@ -62,8 +68,10 @@ namespace
 		idFilePrint,
 		idFileSave,
 		idFileSaveAs,
+		idFileSweep,
 		idHelpAbout,
 		idHelpHelp,
+		idHelpProfile,
 	};
 	static QString s_DefaultDirectory("./Data");
 	void addSeparator(QBoxLayout* lo)
@@ -82,12 +90,17 @@ CWndMain::CWndMain(QWidget *parent)
 	, m_ActFileClose()
 	, m_ActRecentFile()
 	, m_ActSeparator()
+	, m_ActUndo()
+	, m_ActRedo()
 	, m_LblCritDim()
 	, m_TxtCritDim()
 	, m_TxtName()
 	, m_Operators()
 	, m_LoCoordField()
 	, m_BtnResult()
+	, m_BtnOperators()
+	, m_DlgResult()
+	, m_Report()
 { 
 	setWindowTitle("Kanon");
 	setMinimumWidth(800);
@@ -123,6 +136,11 @@ CWndMain::CWndMain(QWidget *parent)
 		"the canonical wave vector dimensions\n"
 		"of coupling constants, coordinates and fields.");
 	m_BtnResult->setEnabled(false);
+	m_BtnOperators = addButton(this, loComment, signMap, "&Operators..", idBtnOperators,
+		"Lists all terms up to a given number\n"
+		"of fields and derivatives, sorted by the\n"
+		"dimensions of their coupling constants.");
+	m_BtnOperators->setEnabled(false);
 	// Critical dimension//
 	QFormLayout* lf{new QFormLayout};
 	loComment->addLayout(lf);
@@ -187,7 +205,6 @@ CWndMain::~CWndMain()
 void CWndMain::clear() 
 { 
 	guiMatrix().clear();
-	guiMatrix().addEmptyRow();
 	m_TxtName->setText("");
 	for (auto& op : m_Operators)
 	{   // Index 0 is d-dimensional space, exists always.
@@ -207,6 +224,7 @@ void CWndMain::createMenus(QSignalMapper* signMap)
 	addMenuAction(this, menuFile, "&Open file...", "Ctrl+O", signMap, idFileOpen);
 	addMenuAction(this, menuFile, "&Save", "Ctrl+S", signMap, idFileSave);
 	addMenuAction(this, menuFile, "&Save As...", "", signMap, idFileSaveAs);
+	addMenuAction(this, menuFile, "Export sigma s&weep...", "", signMap, idFileSweep);
 	m_ActFileClose = addMenuAction(this, menuFile, "&Close...", "", signMap, idFileClose);
 	// Recent file list//
 	menuFile->addSeparator();
@@ -224,10 +242,18 @@ void CWndMain::createMenus(QSignalMapper* signMap)
 	exitAct->setShortcut(tr("Ctrl+Q"));
 	connect(exitAct, SIGNAL(triggered()), this, SLOT(close()));
 	menuFile->addAction(exitAct);
+	QMenu* menuEdit(new QMenu("&Edit", this));//
+	menuBar()->addMenu(menuEdit);
+	m_ActUndo = addMenuAction(this, menuEdit, "&Undo", "Ctrl+Z", signMap, idEditUndo);
+	m_ActRedo = addMenuAction(this, menuEdit, "&Redo", "Ctrl+Y", signMap, idEditRedo);
+	updateUndoActions();
 	QMenu* menuHelp(new QMenu("&Help", this));//
 	menuBar()->addMenu(menuHelp);
 	addMenuAction(this, menuHelp, "&Help", "", signMap, idHelpHelp);
 	addMenuAction(this, menuHelp, "&About", "", signMap, idHelpAbout);
+#ifdef KANON_PROFILE
+	addMenuAction(this, menuHelp, "&Profile summary", "", signMap, idHelpProfile);
+#endif
 } 
  
 /* METHOD *********************************************************************/ 
@@ -288,7 +314,7 @@ void CWndMain::updateTitle()
 *******************************************************************************/ 
 void CWndMain::displayCritDim(bool valid, double critDim, int rank) 
 { 
-	if (m_TxtCritDim && m_LblCritDim && m_BtnResult)
+	if (m_TxtCritDim && m_LblCritDim && m_BtnResult && m_BtnOperators)
 	{
 		const auto order{model().modelOrder()};
 		QPalette pal(m_TxtCritDim->palette());
@@ -307,14 +333,52 @@ void CWndMain::displayCritDim(bool valid, double critDim, int rank)
 		QString ttRank(QString("Displays the rank of the exponent matrix\n"
 			"as long as it is smaller than the minimal rank,\n"
 			"which is %1 for %2 coordinate(s) and %3 field(s).").arg(order).arg(model().numCoord()).arg(model().numField()));
-		m_TxtCritDim->setToolTip(valid ? QString("Displays the\ncritical dimension.") : ttRank);
+		const QString ttCritDim(model().hasSigma() ? "Displays the\ncritical dimension at \xCF\x83 = 0." : "Displays the\ncritical dimension.");
+		m_TxtCritDim->setToolTip(valid ? ttCritDim : ttRank);
 		m_BtnResult->setEnabled(valid);
+		m_BtnOperators->setEnabled(valid);
 		if (m_ActFileClose)
 		{
 			m_ActFileClose->setEnabled(true);
 		}
+		if (valid)
+		{
+			updateResult(false);
+		}
 	}
 } 
+
+/* METHOD *********************************************************************/
+/**
+  Regenerates the changed sections of the result window, if shown.
+@param showErrors: false: exceptions (e.g. a singular coupling term while
+  editing) keep the previous result
+*******************************************************************************/
+void CWndMain::updateResult(bool showErrors)
+{
+	if (!m_DlgResult || !m_DlgResult->isVisible() || guiMatrix().isRxInteractionSingular())
+	{
+		return;
+	}
+	try
+	{
+		const unsigned changed{m_Report.update(size_t(guiMatrix().getRxInteraction()))};
+		for (size_t sx{}; sx < CHtmlReport::numSection; sx++)
+		{
+			if (changed & (1U << sx))
+			{
+				m_DlgResult->setSection(sx, QString::fromUtf8(m_Report.section(sx).c_str()));
+			}
+		}
+	}
+	catch (const std::exception&)
+	{
+		if (showErrors)
+		{
+			throw;
+		}
+	}
+}
  
 /* METHOD *********************************************************************/ 
 /** 
@@ -330,6 +394,19 @@ void CWndMain::updateMml()
 	updateCoordFields();
 } 
  
+/* METHOD *********************************************************************/
+/**
+  Enables undo/redo according to the history of guiMatrix().
+*******************************************************************************/
+void CWndMain::updateUndoActions()
+{
+	if (m_ActUndo)
+	{
+		m_ActUndo->setEnabled(guiMatrix().canUndo());
+		m_ActRedo->setEnabled(guiMatrix().canRedo());
+	}
+}
+
 /* METHOD *********************************************************************/ 
 /** 
 @param coordIndex: 
@@ -591,6 +668,7 @@ void CWndMain::onSignMap(int id)
 					{
 						dlg.dump();
 						model().setComment(text);
+						updateResult(false);
 					}
 				}
 			}
@@ -633,16 +711,48 @@ void CWndMain::onSignMap(int id)
 					{
 						dlg.dump();
 						model().setReferences(text);
+						updateResult(false);
 					}
 				}
 			}
 			break;
+		case idEditRedo:
+			guiMatrix().redo();
+			break;
+		case idEditUndo:
+			guiMatrix().undo();
+			break;
 		case idBtnResult:
 			{
-				string text(htmlModelOutput(guiMatrix().getRxInteraction()));
-				//std::ofstream file("x.htm", std::ios::out); file << text;
-				CDlgHtml dlg(text.c_str(), this);
-				dlg.exec();
+				if (!m_DlgResult)
+				{
+					m_DlgResult = new CDlgHtml(QString(), this);
+				}
+				m_DlgResult->show();
+				m_DlgResult->raise();
+				m_DlgResult->activateWindow();
+				updateResult(true);
+			}
+			break;
+		case idBtnOperators:
+			{
+				CDlgInput dlg("Kanon: Enumerate terms", this, 400);
+				string degree("4");
+				string derivative("2");
+				dlg.addTextField("Maximal number of fields", &degree);
+				dlg.addTextField("Maximal number of derivatives", &derivative);
+				if (QDialog::Accepted == dlg.exec() && dlg.id() == 0)
+				{
+					dlg.dump();
+					const int maxDegree{atoi(degree.c_str())};
+					const int maxDerivative{atoi(derivative.c_str())};
+					if (maxDegree < 2 || maxDerivative < 0)
+					{
+						throwError("At least 2 fields and no negative number of derivatives required");
+					}
+					CDlgHtml dlgHtml(htmlOperatorTable(unsigned(maxDegree), unsigned(maxDerivative)).c_str(), this);
+					dlgHtml.exec();
+				}
 			}
 			break;
 		case idFileModelList:
@@ -685,6 +795,56 @@ void CWndMain::onSignMap(int id)
 		case idFileSaveAs:
 			fileSave("");
 			break;
+		case idFileSweep:
+			{
+				CDlgInput dlg("Kanon: Sweep the long range exponent sigma", this, 400);
+				string from("0");
+				string to("2");
+				string steps("100");
+				dlg.addTextField("sigma from", &from);
+				dlg.addTextField("sigma to", &to);
+				dlg.addTextField("Number of steps", &steps);
+				if (QDialog::Accepted == dlg.exec() && dlg.id() == 0)
+				{
+					dlg.dump();
+					const int numStep{atoi(steps.c_str())};
+					if (numStep < 1)
+					{
+						throwError("At least 1 step required");
+					}
+					const CSigmaSweep sweep(model().expMatrix(), model().sigmaMatrix(), guiMatrix().getRxInteraction());
+					if (!sweep.dependsOnSigma())
+					{
+						throwError("No exponent depends on sigma (Ctrl+PgUp/PgDn at a coordinate or operator)");
+					}
+					const QString pathname(QFileDialog::getSaveFileName(this, "Kanon: Export sigma sweep",
+						s_DefaultDirectory, "CSV files (*.csv)"));
+					if (!pathname.isEmpty())
+					{
+						vector<SSweepPoint> points;
+						sweep.sweep(atof(from.c_str()), atof(to.c_str()), size_t(numStep), points);
+						vector<string> names;
+						for (size_t cx{1}; cx < model().modelOrder(); cx++)
+						{	// Coordinates, fields, then the coupling constants
+							const CGlyphCoordField& glyph(cx < model().numCoord() ? model().coords()[cx]
+								: model().fields()[cx - model().numCoord()]);
+							names.push_back(glyph.comment().empty() ? glyph.toStr() : glyph.comment());
+						}
+						names.push_back(toString("g (term %d)", guiMatrix().getRxInteraction() + 1));
+						for (size_t tx{model().modelOrder()}; tx < model().numTerm(); tx++)
+						{
+							names.push_back(toString("g (term %d)", int(tx) + 1));
+						}
+						std::ofstream file(qPrintable(pathname));
+						CSigmaSweep::writeCsv(file, points, names);
+						if (!file)
+						{
+							throwError("Cannot write " + pathname);
+						}
+					}
+				}
+			}
+			break;
 		case idFileClose:
 			if (makeClean())
 			{
@@ -698,6 +858,14 @@ void CWndMain::onSignMap(int id)
 		case idHelpAbout:
 			QMessageBox::about(this, "About ...", ("Version: " + getVersionString()).c_str());
 			break;
+#ifdef KANON_PROFILE
+		case idHelpProfile:
+			{
+				CDlgHtml dlg(("<pre>" + CProfiler::instance().summary() + "</pre>").c_str(), this);
+				dlg.exec();
+			}
+			break;
+#endif
 		case idBtnHelp: [[fallthrough]];
 		case idHelpHelp:
 			help().show("Purpose.htm");
@@ -4,7 +4,9 @@
 #define MAIN_WINDOW_H
 #include <QtWidgets/QMainWindow>
 #include <QtWidgets/QLabel>
+#include "HtmlOutput.h"
 
+class CDlgHtml;
 class CGuiMatrix;
 class CMmlWdgtOperator;
 class CMmlWdgtRow;
@@ -28,6 +30,7 @@ public:
 	~CWndMain();
 	void displayCritDim(bool valid, double critDim, int rank);
 	void removeCoordFromOperator(unsigned coordIndex);
+	void updateUndoActions();
 	void updateMml();
 	void permuteFields();
 protected:
@@ -39,12 +42,17 @@ private:
 	QAction* m_ActFileClose;
 	QAction* m_ActRecentFile[eNumMaxRecentFile];
 	QAction* m_ActSeparator;
+	QAction* m_ActUndo;
+	QAction* m_ActRedo;
 	QLabel*    m_LblCritDim;
 	QLineEdit* m_TxtCritDim;
 	QLineEdit* m_TxtName;
 	std::vector<CMmlWdgtOperator*> m_Operators;
 	QGridLayout* m_LoCoordField;
 	QPushButton* m_BtnResult;
+	QPushButton* m_BtnOperators;
+	CDlgHtml* m_DlgResult;      // Non-modal, kept up to date while editing
+	CHtmlReport m_Report;       // Shown in m_DlgResult
 
 	bool makeClean();
 	QLabel* createLabel(const QString&, QWidget* buddy);
@@ -56,6 +64,7 @@ private:
 	void updateCoordFields();
 	void updateRecentFileActions();
 	void updateTitle();
+	void updateResult(bool showErrors);
 private slots:
 	void onOpenRecent();
 	void onSignMap(int);
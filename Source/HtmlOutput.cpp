@@ -8,8 +8,11 @@
 @description  Minimal html output formatting
 ********************************************************************************
 *******************************************************************************/
+#include <algorithm>
 #include <cmath>
+#include "CFormatFloat.h"
 #include "CModelData.h"
+#include "CProfiler.h"
 #include "HtmlOutput.h"
 #include "strutil.h"
 
@@ -50,6 +53,32 @@ namespace
 	{
 		return "<i>" + str + "</i>";
 	}
+	string printExp0(int expC, int expD)
+	{	// Exponent of d-dimensional coordinate, e.g. "2-d"
+		string str;
+		if (expC != 0)
+		{
+			str = toString("%-d", expC);
+			if (expD > 0)
+			{
+				str += "+";
+			}
+		}
+		if (expD < 0)
+		{
+			str += "-";
+		}
+		if (expD != 0)
+		{
+			int expDAbs{abs(expD)};
+			if (expDAbs != 1)
+			{
+				str += toString(abs(expDAbs));
+			}
+			str += "d";
+		}
+		return str;
+	}
 }
 
 /* CLASS DECLARATION **********************************************************/
@@ -73,13 +102,18 @@ public:
 		m_Html += "<title>" + title + "</title>\r\n" + headTags + "</head>\r\n\n"
 			"<body " + bodyAttr + ">\r\r\n";
 	}
+	CHtml() : m_Html() {}  // Fragment, without head and body tags
 	string text() const
 	{
 		return m_Html;
 	}
+	static string closing()
+	{
+		return "\r\n</body>\r\n</html>\r\n";
+	}
 	void close()
 	{
-		m_Html += "\r\n</body>\r\n</html>\r\n";
+		m_Html += closing();
 	}
 	void h1(const string& text)
 	{
@@ -146,230 +180,551 @@ private:
 	}
 };
 
-/* FUNCTION *******************************************************************/
-/**
-  Creates a HTML file with results.
-@precondition getModel() != 0.
-@param rxInteraction
-*******************************************************************************/
-string htmlModelOutput(size_t rxInteraction)
+namespace
 {
-	const bool haveDim{true};
-	const bool xhtml{};
-	CModelData& mod{model()};
-	const auto modelOrder{mod.modelOrder()};
-	const char* Css{
-		"<style type=\"text/css\" media=\"all | print | screen\">\r\n"
-#if 0
-		"	body{font-size: 15; font-family: Arial, Helvetica, Sans-Serif; background: #FFFFFF;}\r\n"
-		"	h1{font-weight: bold; font-family: Times; font-size: 24pt; background-color: #E8E8D8;}\r\n"
-		"	h2{font-weight: bold; font-family: Times; font-size: 20pt; background-color: #E8E8D8;}\r\n"
-		"	h3{font-weight: bold; font-family: Times; font-size: 14pt; }\r\n"
-#endif
-		"</style>\r\n"};
-	const string prefix(xhtml ? "<?xml version=\"1.0\"?>\r\n<!DOCTYPE html SYSTEM \"mathml.dtd\">" : "");
-	const string htmlAttrs(xhtml ? "xmlns=\"http://www.w3.org/1999/xhtml\" "
-		"xmlns:math=\"http://www.w3.org/1998/Math/MathML\" "
-		"xmlns:xlink=\"http://www.w3.org/1999/xlink\""
-		: "");
-
-	CHtml html("Kanon-Output", Css, "", prefix, htmlAttrs);
-	if (!haveDim)
+	/* CLASS DECLARATION **********************************************************/
+	/**
+	  FNV-1a hash of the inputs of a report section.
+	*******************************************************************************/
+	struct SInputKey
 	{
-		return html.text();
-	}
-	string name(trimWhite(mod.name()));
-	if (name.empty())
+		uint64_t hash;
+		SInputKey() : hash{14695981039346656037ULL} {}
+		void add(const void* data, size_t len)
+		{
+			const unsigned char* bytes{static_cast<const unsigned char*>(data)};
+			for (size_t ix{}; ix < len; ix++)
+			{
+				hash ^= bytes[ix];
+				hash *= 1099511628211ULL;
+			}
+		}
+		void add(long long val) { add(&val, sizeof(val)); }
+		void add(double val) { add(&val, sizeof(val)); }
+		void add(const string& str) { add(str.data(), str.size()); add((long long)str.size()); }
+		void add(const std::vector<SCanDim>& canDim)
+		{
+			for (const auto& dim : canDim)
+			{
+				add(dim.constVal);
+				add(dim.dVal);
+			}
+			add((long long)canDim.size());
+		}
+	};
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return Hash of the inputs of section sx of the report of mod.
+	*******************************************************************************/
+	uint64_t sectionKey(const CModelData& mod, size_t sx, size_t rxInteraction)
 	{
-		name = "Name?";
-	}
-	html.h1(toHtml(name));
-	mod.determineNormalVector();
-	html.para(toString("Critical dimension <i>d<sub>c</sub> = %s</i>, <i>model order = %d</i>, "
-		"normal vector <i>(%s)</i>.",
-		mod.printCriticalDimension().c_str(), modelOrder, mod.printSortedNormalVector().c_str()));
-	// Exponent Matrix//
-	string coordFieldWarning(". ");
-	html.tag("table", "border = \"1\"");
-	html.tag1(1, "caption", "<b>Exponent matrix &nbsp;" + mod.getCoordsFieldsList() + "</b>");
-	for (size_t tx{}; tx <= mod.numTerm() + 1; tx++)
-	{	// tx=0 is the column header row, then follow exponents -
-		html.indent();
-		html.tag("tr");
-		if (tx == 0)
+		SInputKey key;
+		const size_t modelOrder{mod.modelOrder()};
+		switch (sx)
 		{
-			html.tableCell("&nbsp;", CHtml::bg("lightcyan"));
-			html.tableCell("Comment", CHtml::bg("lightcyan"));
+		case CHtmlReport::eSectionHeader:
+			key.add(mod.name());
+			key.add((long long)mod.hasSigma());
+			key.add(mod.critDim());
+			key.add(mod.canDim());
+			key.add((long long)modelOrder);
+			break;
+		case CHtmlReport::eSectionMatrix:
+			key.add((long long)rxInteraction);
+			key.add((long long)mod.numCoord());
+			key.add((long long)mod.numTerm());
+			key.add(mod.getCoordsFieldsList());
+			for (size_t cx{}; cx < modelOrder; cx++)
+			{
+				key.add((long long)mod.isResponseField(cx));
+			}
+			for (size_t tx{}; tx < mod.numTerm(); tx++)
+			{
+				key.add(mod.printRowCaption(tx));
+				key.add((long long)mod.getExpD(tx));
+				for (size_t cx{}; cx < modelOrder; cx++)
+				{
+					key.add((long long)mod.getExp(tx, cx));
+				}
+			}
+			key.add(mod.critDim());
+			key.add(mod.canDim());
+			break;
+		case CHtmlReport::eSectionDimensions:
+			key.add((long long)mod.numCoord());
+			for (size_t fx{}; fx < modelOrder; fx++)
+			{
+				key.add(mod.printColumnCaption(fx));
+			}
+			key.add(mod.critDim());
+			key.add(mod.canDim());
+			break;
+		case CHtmlReport::eSectionComments:
+			key.add(mod.comment());
+			key.add(mod.references());
+			break;
+		default:
+			break;
 		}
-		else if (tx <= mod.numTerm())
+		return key.hash;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return Head of the report document
+	*******************************************************************************/
+	string htmlReportHead()
+	{
+		const bool xhtml{};
+		const char* Css{
+			"<style type=\"text/css\" media=\"all | print | screen\">\r\n"
+#if 0
+			"	body{font-size: 15; font-family: Arial, Helvetica, Sans-Serif; background: #FFFFFF;}\r\n"
+			"	h1{font-weight: bold; font-family: Times; font-size: 24pt; background-color: #E8E8D8;}\r\n"
+			"	h2{font-weight: bold; font-family: Times; font-size: 20pt; background-color: #E8E8D8;}\r\n"
+			"	h3{font-weight: bold; font-family: Times; font-size: 14pt; }\r\n"
+#endif
+			"</style>\r\n"};
+		const string prefix(xhtml ? "<?xml version=\"1.0\"?>\r\n<!DOCTYPE html SYSTEM \"mathml.dtd\">" : "");
+		const string htmlAttrs(xhtml ? "xmlns=\"http://www.w3.org/1999/xhtml\" "
+			"xmlns:math=\"http://www.w3.org/1998/Math/MathML\" "
+			"xmlns:xlink=\"http://www.w3.org/1999/xlink\""
+			: "");
+		return CHtml("Kanon-Output", Css, "", prefix, htmlAttrs).text();
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Section name, critical dimension, normal vector (and a note if they hold
+  for sigma = 0 only).
+	@side_effects CModelData::determineNormalVector()
+	*******************************************************************************/
+	string htmlHeaderSection(CModelData& mod)
+	{
+		CHtml html;
+		string name(trimWhite(mod.name()));
+		if (name.empty())
 		{
-			html.tableCell(toString("%d", tx), CHtml::bg("lightcyan"));
-			const string caption(mod.printRowCaption(tx - 1)/*.substr(0, 50)*/);
-			html.tableCell(toHtml(caption), CHtml::bg("whitesmoke"));
+			name = "Name?";
 		}
-		else
+		html.h1(toHtml(name));
+		mod.determineNormalVector();
+		html.para(toString("Critical dimension <i>d<sub>c</sub> = %s</i>, <i>model order = %d</i>, "
+			"normal vector <i>(%s)</i>.",
+			mod.printCriticalDimension().c_str(), mod.modelOrder(), mod.printSortedNormalVector().c_str()));
+		if (mod.hasSigma())
 		{
-			html.tableCell("&nbsp;", CHtml::bg("lightcyan"));
-			html.tableCell("Dimension of coordinate/field at <i>d<sub>c</sub></i>&nbsp;",
-				"align=\"center\" " + CHtml::bg("lightcyan"));
+			html.para("The exponents depend on <i>&sigma;</i>: all dimensions are given for <i>&sigma; = 0</i>.");
 		}
-		for (size_t cx{}; cx < modelOrder; cx++)
-		{	// Exponent columns
-			string text;
-			string attrs;
+		return html.text();
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Section exponent matrix, with the dimensions of the coupling constants.
+	*******************************************************************************/
+	string htmlMatrixSection(const CModelData& mod, size_t rxInteraction)
+	{
+		CHtml html;
+		const auto modelOrder{mod.modelOrder()};
+		// Exponent Matrix//
+		string coordFieldWarning(". ");
+		html.tag("table", "border = \"1\"");
+		html.tag1(1, "caption", "<b>Exponent matrix &nbsp;" + mod.getCoordsFieldsList() + "</b>");
+		for (size_t tx{}; tx <= mod.numTerm() + 1; tx++)
+		{	// tx=0 is the column header row, then follow exponents -
+			html.indent();
+			html.tag("tr");
 			if (tx == 0)
-			{	// Column header for coordinate/field cx
-				if (mod.isResponseField(cx))
-				{
-					text += "~";
-				}
-				else text += " ";
-				text += cx < mod.numCoord() ? "C" : "F";
-				text += toString(int(1 + (cx < mod.numCoord() ? cx : cx - mod.numCoord())));
-				attrs = "align=\"center\" " + CHtml::bg("lightcyan");
+			{
+				html.tableCell("&nbsp;", CHtml::bg("lightcyan"));
+				html.tableCell("Comment", CHtml::bg("lightcyan"));
 			}
 			else if (tx <= mod.numTerm())
-			{	// Display exponents
-				if (cx == 0)
-				{	// Exponent of d-dimensional coordinate
-					const int expD{mod.getExpD(cx)};
-					const int expC{mod.getExp(tx - 1, cx)};
-					string str;
-					if (expC != 0)
+			{
+				html.tableCell(toString("%d", tx), CHtml::bg("lightcyan"));
+				const string caption(mod.printRowCaption(tx - 1)/*.substr(0, 50)*/);
+				html.tableCell(toHtml(caption), CHtml::bg("whitesmoke"));
+			}
+			else
+			{
+				html.tableCell("&nbsp;", CHtml::bg("lightcyan"));
+				html.tableCell("Dimension of coordinate/field at <i>d<sub>c</sub></i>&nbsp;",
+					"align=\"center\" " + CHtml::bg("lightcyan"));
+			}
+			for (size_t cx{}; cx < modelOrder; cx++)
+			{	// Exponent columns
+				string text;
+				string attrs;
+				if (tx == 0)
+				{	// Column header for coordinate/field cx
+					if (mod.isResponseField(cx))
 					{
-						str = toString("%-d", expC);
-						if (expD > 0)
-						{
-							str += "+";
-						}
+						text += "~";
+					}
+					else text += " ";
+					text += cx < mod.numCoord() ? "C" : "F";
+					text += toString(int(1 + (cx < mod.numCoord() ? cx : cx - mod.numCoord())));
+					attrs = "align=\"center\" " + CHtml::bg("lightcyan");
+				}
+				else if (tx <= mod.numTerm())
+				{	// Display exponents
+					if (cx == 0)
+					{	// Exponent of d-dimensional coordinate
+						text += addI(printExp0(mod.getExp(tx - 1, cx), mod.getExpD(cx)));
 					}
-					if (expD < 0)
+					else
 					{
-						str += "-";
+						text += addI(toString("%-d", mod.getExp(tx - 1, cx)));
 					}
-					if (expD != 0)
+					attrs = "align=\"center\" ";
+					if (tx <= modelOrder)
 					{
-						int expDAbs{abs(expD)};
-						if (expDAbs != 1)
-						{
-							str += toString(abs(expDAbs));
-						}
-						str += "d";
+						attrs += CHtml::bg("cornsilk");
 					}
-					text += addI(str);
 				}
 				else
-				{
-					text += addI(toString("%-d", mod.getExp(tx - 1, cx)));
+				{	// Last row displays coordinate/field dimensions
+					const double dimAtCritDim(mod.getDimensionAtCritDim(cx));
+					text = addI(toString("%2.2f", dimAtCritDim));
+					if (fabs(dimAtCritDim) < 0.001)
+					{
+						text = "<font color=\"red\">" + text + "</font>";
+						coordFieldWarning = " (a zero value in principle signifies infinitely many marginal terms). ";
+					}
+					attrs += CHtml::bg("lightcyan");
 				}
-				attrs = "align=\"center\" ";
-				if (tx <= modelOrder)
-				{
-					attrs += CHtml::bg("cornsilk");
+				html.tableCell(text, attrs);
+			}
+			// Additional columns//
+			string text;
+			if (tx == 0)
+			{
+				html.tableCell("Type", "align=\"center\" " + CHtml::bg("lightcyan"));
+				html.tableCell(addI("[g]"), "align=\"center\" " + CHtml::bg("lightcyan"));
+			}
+			else if (tx <= mod.numTerm())
+			{
+				if (tx == rxInteraction + 1)
+				{	// Currently selected row, coupling constant
+	#ifdef __linux__
+					text = "&lArr;&nbsp;coupling";
+	#else
+					text = "&lt;&lt;&nbsp;coupling";
+	#endif
+					html.tableCell(text, "align=\"center\"");
+					const string text(mod.printHtmlDimensionOfCouplingConst(0));
+					html.tableCell(addI(text), "align=\"center\" " + CHtml::bg("lightcyan"));
+				}
+				else if (tx <= modelOrder)
+				{	// Other normal terms
+					text = "   kept fixed";
+					html.tableCell(addI(text), "align=\"center\"");
+					html.tableCell(addI("0"), "align=\"center\" " + CHtml::bg("lightcyan"));
+				}
+				else
+				{	// Extra term
+					text = mod.printRelevanceExtra(tx - 1, false);
+					html.tableCell(addI(text), "align=\"center\"");
+					html.tableCell(addI(mod.printRelevanceExtra(tx - 1, true)),
+						"align=\"center\" " + CHtml::bg("lightcyan"));
 				}
 			}
 			else
-			{	// Last row displays coordinate/field dimensions
-				const double dimAtCritDim(mod.getDimensionAtCritDim(cx));
-				text = addI(toString("%2.2f", dimAtCritDim));
-				if (fabs(dimAtCritDim) < 0.001)
-				{
-					text = "<font color=\"red\">" + text + "</font>";
-					coordFieldWarning = " (a zero value in principle signifies infinitely many marginal terms). ";
-				}
-				attrs += CHtml::bg("lightcyan");
+			{
+				html.tableCell("&nbsp;", CHtml::bg("lightcyan"));
+				html.tableCell("&nbsp;", CHtml::bg("lightcyan"));
 			}
-			html.tableCell(text, attrs);
-		}
-		// Additional columns//
-		string text;
-		if (tx == 0)
-		{
-			html.tableCell("Type", "align=\"center\" " + CHtml::bg("lightcyan"));
-			html.tableCell(addI("[g]"), "align=\"center\" " + CHtml::bg("lightcyan"));
+			html.end("tr", 1);
 		}
-		else if (tx <= mod.numTerm())
+		html.end("table");
+		html.para("The last column contains the dimensions <i>[g]</i> of the coupling constants "
+			"<i>(&epsilon; = d<sub>c</sub> - d)</i>.<br/>\r\n"
+			"The last row contains the canonical wave vector dimensions <i>[f]</i> of the coordinates/fields <i>f</i> at "
+			"the critical dimension" + coordFieldWarning +
+			"The general expressions are listed in the table:");
+		return html.text();
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Section canonical dimensions of coordinates and fields.
+	*******************************************************************************/
+	string htmlDimensionSection(const CModelData& mod)
+	{
+		CHtml html;
+		const auto modelOrder{mod.modelOrder()};
+		// General expressions for canonical dimensions of coordinates/fields//
+		html.tag("table", "border = \"1\"");
+		html.tag1(1, "caption", "<b>Canonical wave vector dimensions of coordinates and fields</b>");
+		html.indent(1);
+		html.tag("tr");
+		html.tableCell("Name", CHtml::bg("lightcyan"));
+		html.tableCell("Comment", CHtml::bg("lightcyan"));
+		html.tableCell("Canonical dimension", "align=\"center\" " + CHtml::bg("lightcyan"));
+		html.end("tr", 1);
+		for (size_t fx{}; fx < modelOrder; fx++)
 		{
-			if (tx == rxInteraction + 1)
-			{	// Currently selected row, coupling constant
-#ifdef __linux__
-				text = "&lArr;&nbsp;coupling";
-#else
-				text = "&lt;&lt;&nbsp;coupling";
-#endif
-				html.tableCell(text, "align=\"center\"");
-				const string text(mod.printHtmlDimensionOfCouplingConst(0));
-				html.tableCell(addI(text), "align=\"center\" " + CHtml::bg("lightcyan"));
-			}
-			else if (tx <= modelOrder)
-			{	// Other normal terms
-				text = "   kept fixed";
-				html.tableCell(addI(text), "align=\"center\"");
-				html.tableCell(addI("0"), "align=\"center\" " + CHtml::bg("lightcyan"));
+			html.indent(1);
+			html.tag("tr");
+			string text;
+			if (fx < mod.numCoord())
+			{
+				text = toString("\t[C%d]", fx + 1);
 			}
 			else
-			{	// Extra term
-				text = mod.printRelevanceExtra(tx - 1, false);
-				html.tableCell(addI(text), "align=\"center\"");
-				html.tableCell(addI(mod.printRelevanceExtra(tx - 1, true)),
-					"align=\"center\" " + CHtml::bg("lightcyan"));
+			{
+				text = toString("\t[F%d]", fx + 1 - mod.numCoord());
 			}
+			html.tableCell(text, CHtml::bg("lightcyan"));
+			html.tableCell(mod.printColumnCaption(fx).substr(0, 50),
+				CHtml::bg("whitesmoke"));
+			text = mod.printCanonicalDimension(fx);
+			// ToDo: Use color in case of non-positive value !
+			html.tableCell(addI(text), "align=\"center\"");
+			html.end("tr", 1);
 		}
-		else
+		html.end("table");
+		return html.text();
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Section comments and references.
+	*******************************************************************************/
+	string htmlCommentSection(const CModelData& mod)
+	{
+		CHtml html;
+		// Comment, References//
+		html.h2("Comments and references");
+		if (!mod.comment().empty())
+		{
+			html.para(replace(toHtml(mod.comment()), "\n", "<br/>", NUM_REP));
+		}
+		if (!mod.references().empty())
+		{
+			html.para(replace(toHtml(mod.references()), "\n", "<br/>", NUM_REP));
+		}
+		return html.text();
+	}
+}
+
+/* METHOD *********************************************************************/
+/**
+  Ctor
+*******************************************************************************/
+CHtmlReport::CHtmlReport()
+	: m_Sections()
+	, m_Keys()
+	, m_Valid()
+{
+}
+
+/* METHOD *********************************************************************/
+/**
+  Regenerates the sections of the edited model whose inputs changed.
+@precondition Canonical dimensions of model() determined.
+@param rxInteraction: Term used as coupling constant
+@return Bit (1 << ESection) set for each regenerated section
+*******************************************************************************/
+unsigned CHtmlReport::update(size_t rxInteraction)
+{
+	return update(model(), rxInteraction);
+}
+
+/* METHOD *********************************************************************/
+/**
+  As above, for any model; a list entry must be loaded completely (see
+  CModelData::ensureLoaded()).
+*******************************************************************************/
+unsigned CHtmlReport::update(CModelData& mod, size_t rxInteraction)
+{
+	PROFILE_SCOPE("htmlReportUpdate");
+	unsigned ret{};
+	for (size_t sx{}; sx < numSection; sx++)
+	{
+		const uint64_t key{sectionKey(mod, sx, rxInteraction)};
+		if (m_Valid[sx] && key == m_Keys[sx])
 		{
-			html.tableCell("&nbsp;", CHtml::bg("lightcyan"));
-			html.tableCell("&nbsp;", CHtml::bg("lightcyan"));
+			continue;
 		}
+		switch (sx)
+		{
+		case eSectionHeader:     m_Sections[sx] = htmlHeaderSection(mod); break;
+		case eSectionMatrix:     m_Sections[sx] = htmlMatrixSection(mod, rxInteraction); break;
+		case eSectionDimensions: m_Sections[sx] = htmlDimensionSection(mod); break;
+		case eSectionComments:   m_Sections[sx] = htmlCommentSection(mod); break;
+		default: break;
+		}
+		m_Keys[sx] = key;
+		m_Valid[sx] = true;
+		ret |= 1U << sx;
+		PROFILE_COUNT("htmlSectionsGenerated", 1);
+	}
+	return ret;
+}
+
+/* METHOD *********************************************************************/
+/**
+  Passes the complete document, head and sections in order, to sink.
+@precondition update()
+@param terms: Optional fragment following the header section (see htmlTermTable())
+*******************************************************************************/
+void CHtmlReport::write(const TSink& sink, const string& terms) const
+{
+	sink(htmlReportHead());
+	for (size_t sx{}; sx < numSection; sx++)
+	{
+		sink(m_Sections[sx]);
+		if (sx == eSectionHeader && !terms.empty())
+		{
+			sink(terms);
+		}
+	}
+	sink(CHtml::closing());
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Creates a HTML file with results.
+@precondition getModel() != 0.
+@param rxInteraction
+*******************************************************************************/
+string htmlModelOutput(size_t rxInteraction)
+{
+	CHtmlReport report;
+	report.update(rxInteraction);
+	string ret;
+	report.write([&ret](const string& text) { ret += text; });
+	return ret;
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Table of the terms of the Lagrangian as pictures.
+@param    mod: Model
+@param images: Per term an <img> tag (see CReportRenderer)
+*******************************************************************************/
+string htmlTermTable(const CModelData& mod, const std::vector<string>& images)
+{
+	CHtml html;
+	html.tag("table", "border = \"1\"");
+	html.tag1(1, "caption", "<b>Terms of the Lagrangian</b>");
+	for (size_t tx{}; tx < images.size(); tx++)
+	{
+		html.indent(1);
+		html.tag("tr");
+		html.tableCell(toString("%d", int(tx + 1)), CHtml::bg("lightcyan"));
+		html.tableCell(images[tx], tx < mod.modelOrder() ? CHtml::bg("cornsilk") : "");
 		html.end("tr", 1);
 	}
 	html.end("table");
-	html.para("The last column contains the dimensions <i>[g]</i> of the coupling constants "
-		"<i>(&epsilon; = d<sub>c</sub> - d)</i>.<br/>\r\n"
-		"The last row contains the canonical wave vector dimensions <i>[f]</i> of the coordinates/fields <i>f</i> at "
-		"the critical dimension" + coordFieldWarning +
-		"The general expressions are listed in the table:");
-	// General expressions for canonical dimensions of coordinates/fields//
+	return html.text();
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Creates a HTML page listing models of the library which differ only in the
+  order of terms, fields or coordinates (see CModelData::duplicates()).
+*******************************************************************************/
+string htmlDuplicateReport()
+{
+	const auto groups(CModelData::duplicates());
+	CHtml html("Kanon-Duplicates");
+	html.h1("Duplicate models");
+	html.para(toString("%u models, %u groups of equivalent models.",
+		unsigned(CModelData::size()), unsigned(groups.size())));
+	for (const auto& group : groups)
+	{
+		html.h3(CModelData::at(group[0]).canonicalHash().toString());
+		html.tag("table", "border = \"1\"");
+		for (const size_t ix : group)
+		{
+			const CModelData& mod(CModelData::at(ix));
+			html.indent();
+			html.tag("tr");
+			html.tableCell(toHtml(mod.name()), CHtml::bg("whitesmoke"));
+			html.tableCell(toHtml(mod.pathname()));
+			html.end("tr", 1);
+		}
+		html.end("table");
+	}
+	html.close();
+	return html.text();
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Creates a HTML page listing all candidate terms of the current model up to
+  the given limits, sorted by the dimension of their coupling constants (see
+  CModelData::enumerateOperators()).
+@param     maxDegree: Maximal sum of field exponents
+@param maxDerivative: Maximal number of derivatives
+*******************************************************************************/
+string htmlOperatorTable(unsigned maxDegree, unsigned maxDerivative)
+{
+	const CModelData& mod{model()};
+	const auto modelOrder{mod.modelOrder()};
+	const COperatorEnum ops(mod.enumerateOperators(maxDegree, maxDerivative));
+	std::vector<std::vector<int>> terms;
+	for (size_t tx{}; tx < mod.numTerm(); tx++)
+	{	// To mark candidates already present, the exponent of d last
+		std::vector<int> exps;
+		for (size_t cx{}; cx < modelOrder; cx++)
+		{
+			exps.push_back(mod.getExp(tx, cx));
+		}
+		exps.push_back(mod.getExpD(tx));
+		terms.push_back(exps);
+	}
+	CHtml html("Kanon-Operators");
+	html.h1(toHtml(trimWhite(mod.name())) + ": candidate terms");
+	html.para(toString("%u terms with at most %u fields and %u derivatives%s, "
+		"classified at <i>d<sub>c</sub> = %s</i>.",
+		unsigned(ops.size()), maxDegree, maxDerivative, ops.truncated() ? " (truncated)" : "",
+		mod.printCriticalDimension().c_str()));
 	html.tag("table", "border = \"1\"");
-	html.tag1(1, "caption", "<b>Canonical wave vector dimensions of coordinates and fields</b>");
-	html.indent(1);
+	html.indent();
 	html.tag("tr");
-	html.tableCell("Name", CHtml::bg("lightcyan"));
-	html.tableCell("Comment", CHtml::bg("lightcyan"));
-	html.tableCell("Canonical dimension", "align=\"center\" " + CHtml::bg("lightcyan"));
+	html.tableCell("&nbsp;", CHtml::bg("lightcyan"));
+	for (size_t cx{}; cx < modelOrder; cx++)
+	{	// Column header as in htmlModelOutput()
+		string text(mod.isResponseField(cx) ? "~" : " ");
+		text += cx < mod.numCoord() ? "C" : "F";
+		text += toString(int(1 + (cx < mod.numCoord() ? cx : cx - mod.numCoord())));
+		html.tableCell(text, "align=\"center\" " + CHtml::bg("lightcyan"));
+	}
+	html.tableCell("Type", "align=\"center\" " + CHtml::bg("lightcyan"));
+	html.tableCell(addI("[g]"), "align=\"center\" " + CHtml::bg("lightcyan"));
+	html.tableCell("In model", "align=\"center\" " + CHtml::bg("lightcyan"));
 	html.end("tr", 1);
-	for (size_t fx{}; fx < modelOrder; fx++)
+	const char* Types[]{"relevant", "marginal", "irrelevant"};
+	unsigned num{};
+	ops.stream([&](const COperatorEnum::SOperator& op)
 	{
-		html.indent(1);
-		html.tag("tr");
-		string text;
-		if (fx < mod.numCoord())
+		bool inModel{};
+		for (const auto& term : terms)
 		{
-			text = toString("\t[C%d]", fx + 1);
+			inModel = inModel || (std::equal(op.exps, op.exps + modelOrder, term.begin()) && term.back() == op.expD);
 		}
-		else
+		html.indent();
+		html.tag("tr");
+		html.tableCell(toString("%u", ++num), CHtml::bg("lightcyan"));
+		for (size_t cx{}; cx < modelOrder; cx++)
 		{
-			text = toString("\t[F%d]", fx + 1 - mod.numCoord());
+			html.tableCell(addI(cx == 0 ? printExp0(op.exps[cx], op.expD) : toString("%-d", op.exps[cx])),
+				"align=\"center\"");
 		}
-		html.tableCell(text, CHtml::bg("lightcyan"));
-		html.tableCell(mod.printColumnCaption(fx).substr(0, 50),
-			CHtml::bg("whitesmoke"));
-		text = mod.printCanonicalDimension(fx);
-		// ToDo: Use color in case of non-positive value !
-		html.tableCell(addI(text), "align=\"center\"");
+		html.tableCell(addI(Types[op.relevance]), "align=\"center\"");
+		html.tableCell(addI(CFormatFloat::bilinearHtml(op.dim, -op.dVal)),
+			"align=\"center\" " + CHtml::bg("lightcyan"));
+		html.tableCell(inModel ? "yes" : "&nbsp;", "align=\"center\"");
 		html.end("tr", 1);
-	}
+	});
 	html.end("table");
-	// Comment, References//
-	html.h2("Comments and references");
-	if (!mod.comment().empty())
-	{
-		html.para(replace(toHtml(mod.comment()), "\n", "<br/>", NUM_REP));
-	}
-	if (!mod.references().empty())
-	{
-		html.para(replace(toHtml(mod.references()), "\n", "<br/>", NUM_REP));
-	}
+	html.para("Each term is integrated over all coordinates. The last but one column contains the "
+		"dimension <i>[g]</i> of its coupling constant <i>(&epsilon; = d<sub>c</sub> - d)</i>.");
 	html.close();
 	return html.text();
 }
-
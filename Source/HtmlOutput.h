@@ -1,8 +1,48 @@
 #ifndef HTMLOUTPUT_H
 #define HTMLOUTPUT_H
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
+
+class CModelData;
+
+/* CLASS DECLARATION **********************************************************/
+/**
+  Report of the edited model (see model()), in sections. update() regenerates
+  only the sections whose inputs (exponent matrix, canonical dimensions,
+  coupling term, relevance of extra terms, captions, comments) changed since
+  the previous call; write() streams the complete document into a sink (e.g.
+  a file or a socket), section(ix) serves a browser document showing the
+  sections separately (see CDlgHtml::setSection()).
+*******************************************************************************/
+class CHtmlReport
+{
+public:
+	enum ESection
+	{
+		eSectionHeader,     // Name, critical dimension, normal vector
+		eSectionMatrix,     // Exponent matrix, dimensions of the coupling constants
+		eSectionDimensions, // Canonical dimensions of coordinates and fields
+		eSectionComments,   // Comments and references
+		numSection
+	};
+	typedef std::function<void(const std::string& text)> TSink;
+private:
+	std::string m_Sections[numSection];
+	uint64_t m_Keys[numSection];  // Hash of the inputs of the sections
+	bool m_Valid[numSection];
+public:
+	CHtmlReport();
+	unsigned update(size_t rxInteraction);
+	unsigned update(CModelData& mod, size_t rxInteraction);
+	const std::string& section(size_t sx) const { return m_Sections[sx]; }
+	void write(const TSink& sink, const std::string& terms = std::string()) const;
+};
 
 std::string htmlModelOutput(size_t rxInteraction);
+std::string htmlTermTable(const CModelData& mod, const std::vector<std::string>& images);
+std::string htmlDuplicateReport();
+std::string htmlOperatorTable(unsigned maxDegree, unsigned maxDerivative);
 
 #endif
-
@@ -7,6 +7,7 @@
 #include <stdexcept>
 #include <string>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QSignalMapper>
 #include <QtWidgets/QAction>
 #include <QtWidgets/QBoxLayout>
@@ -15,6 +16,7 @@
 #include <QtWidgets/QPushButton>
 #include <QtXml/QDomNode>
 #include <QUuid>
+#include "CProfiler.h"
 #include "Util.h"
 #include "strutil.h"
 
@@ -169,15 +171,18 @@ void throwAssert(const string& text, bool val)
 
 /* FUNCTION *******************************************************************/
 /**
-@return Directory of predefined *.kxm files (models).
+@return Directory of predefined *.kxm files (models), or the archive of them
+        (Data.kxa, see CModelArchive) if there is no directory.
 *******************************************************************************/
 string pathToData()
 {
 #ifdef __linux__
-	return "./Data";
+	const string dir("./Data");
 #else
-	return "../Data";
+	const string dir("../Data");
 #endif
+	const string archive(dir + ".kxa");
+	return !QFileInfo(dir.c_str()).isDir() && QFileInfo(archive.c_str()).isFile() ? archive : dir;
 }
 
 /* FUNCTION *******************************************************************/
@@ -236,7 +241,8 @@ bool stringMatchesFilter(const string& filter, const string& text, ECase caseSen
 
 /* FUNCTION *******************************************************************/
 /**
-	Opens an XML document.
+	Opens an XML document. The "xmlOpen" timer includes the read, "xmlParse"
+	is the parse only (also of contents read ahead, see CReadAhead).
 *
 @param      doc: [in/out]
 @param filename:
@@ -244,12 +250,28 @@ bool stringMatchesFilter(const string& filter, const string& text, ECase caseSen
 *******************************************************************************/
 void xmlOpen(QDomDocument& doc, const QString& filename)
 {
+	PROFILE_SCOPE("xmlOpen");
 	QFile file(filename);
 	if (!file.open(QIODevice::ReadOnly))
 	{
 		throwError("Cannot open " + filename);
 	}
-	const QString text(file.readAll());
+	xmlParse(doc, file.readAll(), filename);
+}
+
+/* FUNCTION *******************************************************************/
+/**
+	Parses an XML document read before, e.g. a member of an archive.
+*
+@param      doc: [in/out]
+@param     data: Content
+@param filename: Source, for messages
+@exception :
+*******************************************************************************/
+void xmlParse(QDomDocument& doc, const QByteArray& data, const QString& filename)
+{
+	PROFILE_SCOPE("xmlParse");
+	const QString text(data);
 	QString errMsg;
 	int errLine, errCol;
 	if (!doc.setContent(text, false, &errMsg, &errLine, &errCol))
@@ -56,6 +56,7 @@ std::string xmlGetTextData2(QDomNode&, const QString& name);
 
 std::string xmlRequireAttr(QDomNode&, const QString& name);
 void        xmlOpen(QDomDocument&, const QString& filename);
+void        xmlParse(QDomDocument&, const QByteArray& data, const QString& filename);
 
 #endif
 
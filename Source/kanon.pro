@@ -2,7 +2,9 @@
 # Automatically generated by qmake (2.01a) Sa Jun 12 17:10:59 2010
 # Windows: d:\qt\Qt-4.7.3-dev-lite-msvc2010-rs\Qt-4.7.3-dev-lite-msvc2010-rs
 ######################################################################
+QT += network
 QT += printsupport
+QT += svg
 QT += widgets
 QT += xml
 
@@ -10,6 +12,9 @@ RC_FILE = WinApp.rc
 
 CONFIG -= debug
 DEFINES += "_CRT_SECURE_NO_WARNINGS" # Windows
+#DEFINES += KANON_PROFILE # Timers/counters (Help menu, stderr at exit, -trace file)
+#QMAKE_CXXFLAGS += -O3 -mavx2 # Wider lanes in CBatchSolver (target CPUs must support AVX2)
+#CONFIG += c++17 # std::to_chars in toChars() (GCC >= 11, MSVC >= 2019), else snprintf()
 
 TEMPLATE = app
 TARGET = kanon
@@ -20,23 +25,36 @@ INCLUDEPATH += .
 RESOURCES = resources.qrc
 
 HEADERS += \
+	CBatchSolver.h \
 	CDlgCoordFieldSymbol.h \
 	CDlgHtml.h \
 	CDlgInput.h \
 	CDlgSelectBase.h \
 	CDlgSelectModel.h \
+	CEditHistory.h \
+	CExpMatrix.h \
+	CFactorCache.h \
 	CFormatFloat.h \
 	CFormula.h \
 	CGlyph.h \
 	CGuiMatrix.h \
 	CHelp.h \
+	CLuFactor.h \
 	CMmlWdgtBase.h \
 	CMmlWdgtCoordField.h \
 	CMmlWdgtMore.h \
 	CMmlWdgtOperator.h \
 	CMmlWdgtRow.h \
+	CModelArchive.h \
 	CModelData.h \
 	CNumerics.h \
+	COperatorEnum.h \
+	CProfiler.h \
+	CQueryServer.h \
+	CReadAhead.h \
+	CReportRenderer.h \
+	CSignatureIndex.h \
+	CSparseLu.h \
 	CWndMain.h \
 	CXmlCreator.h \
 	HtmlOutput.h \
@@ -44,23 +62,36 @@ HEADERS += \
 	Util.h \
 
 SOURCES += \
+	CBatchSolver.cpp \
 	CDlgCoordFieldSymbol.cpp \
 	CDlgHtml.cpp \
 	CDlgInput.cpp \
 	CDlgSelectBase.cpp \
 	CDlgSelectModel.cpp \
+	CEditHistory.cpp \
+	CExpMatrix.cpp \
+	CFactorCache.cpp \
 	CFormatFloat.cpp \
 	CFormula.cpp \
 	CGlyph.cpp \
 	CGuiMatrix.cpp \
 	CHelp.cpp \
+	CLuFactor.cpp \
 	CMmlWdgtBase.cpp \
 	CMmlWdgtCoordField.cpp \
 	CMmlWdgtMore.cpp \
 	CMmlWdgtOperator.cpp \
 	CMmlWdgtRow.cpp \
+	CModelArchive.cpp \
 	CModelData.cpp \
 	CNumerics.cpp \
+	COperatorEnum.cpp \
+	CProfiler.cpp \
+	CQueryServer.cpp \
+	CReadAhead.cpp \
+	CReportRenderer.cpp \
+	CSignatureIndex.cpp \
+	CSparseLu.cpp \
 	CWndMain.cpp \
 	CXmlCreator.cpp \
 	HtmlOutput.cpp \
@@ -0,0 +1,21 @@
+######################################################################
+# Test target: the application sources (see kanon.pro) without main.cpp,
+# plus the checks in test/. Run the binary, the exit code is the number
+# of failed checks.
+######################################################################
+include(kanon.pro)
+
+TARGET = kanontest
+CONFIG += console
+CONFIG -= app_bundle
+RC_FILE =
+
+HEADERS += \
+	test/Test.h \
+
+SOURCES -= main.cpp
+SOURCES += \
+	test/main.cpp \
+	test/TestFiles.cpp \
+	test/TestNumerics.cpp \
+	test/TestRender.cpp \
@@ -1,8 +1,308 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <QtGui/QGuiApplication>
 #include <QtWidgets/QApplication>
+#include "CGlyph.h"
+#include "CModelArchive.h"
+#include "CModelData.h"
+#include "CNumerics.h"
+#include "CProfiler.h"
+#include "CQueryServer.h"
+#include "CReportRenderer.h"
 #include "CWndMain.h"
+#include "Util.h"
 
+namespace
+{
+	/* FUNCTION *******************************************************************/
+	/**
+	  Loads and evaluates the model library without GUI (option -scan).
+	@param       path: Directory of the *.kxm files
+	@param exportPath: Optional file receiving the exponent matrices (see CExpMatrix::write())
+	@return Exit code
+	*******************************************************************************/
+	int scanLibrary(int argc, char** argv, const std::string& path, const std::string& exportPath)
+	{
+		QCoreApplication a(argc, argv);
+		CGlyphBase::initializeSymbolTable();
+		std::vector<std::string> errMsgs;
+		CModelData::loadLibrary(path, errMsgs);
+		for (const auto& errMsg : errMsgs)
+		{
+			fprintf(stderr, "%s\n", errMsg.c_str());
+		}
+		fprintf(stdout, "%u models in %s\n", unsigned(CModelData::size()), path.c_str());
+		for (const auto& group : CModelData::duplicates())
+		{	// Models differing only in the order of terms, fields or coordinates
+			fprintf(stdout, "Duplicates %s:\n", CModelData::at(group[0]).canonicalHash().toString().c_str());
+			for (const size_t ix : group)
+			{
+				fprintf(stdout, "\t%s\n", CModelData::at(ix).pathname().c_str());
+			}
+		}
+		for (size_t ix{}; ix < CModelData::size(); ix++)
+		{	// Canonical dimensions unreliable with the interaction the evaluation used
+			const CModelData& mod(CModelData::at(ix));
+			if (mod.rxInteraction() < 0)
+			{
+				continue;
+			}
+			const double rcond{CNumerics::reciprocalCondition(mod.expMatrix(), mod.rxInteraction())};
+			if (CNumerics::isIllConditioned(rcond))
+			{
+				fprintf(stdout, "Ill-conditioned (rcond %.1e, interaction %d): %s\n", rcond, mod.rxInteraction() + 1,
+					mod.pathname().c_str());
+			}
+		}
+		if (!exportPath.empty())
+		{
+			std::ofstream file(exportPath);
+			file << "# Kanon exponent matrices of " << path << "\n";
+			for (size_t ix{}; ix < CModelData::size(); ix++)
+			{
+				CModelData::at(ix).expMatrix().write(file, CModelData::at(ix).name());
+			}
+			if (!file)
+			{
+				fprintf(stderr, "Cannot write %s\n", exportPath.c_str());
+				return 1;
+			}
+		}
+		PROFILE_DUMP();
+		return errMsgs.empty() ? 0 : 1;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Packs the model library into an archive (option -pack).
+	@param         dir: Directory of the *.kxm files
+	@param archivePath: Archive, created or updated
+	@return Exit code
+	*******************************************************************************/
+	int packLibrary(int argc, char** argv, const std::string& dir, const std::string& archivePath)
+	{
+		QCoreApplication a(argc, argv);
+		std::vector<std::string> errMsgs;
+		size_t numCompressed{};
+		const bool ok{CModelArchive::pack(dir, archivePath, numCompressed, errMsgs)};
+		for (const auto& errMsg : errMsgs)
+		{
+			fprintf(stderr, "%s\n", errMsg.c_str());
+		}
+		if (ok)
+		{
+			fprintf(stdout, "%s: %u files compressed, unchanged ones copied\n", archivePath.c_str(),
+				unsigned(numCompressed));
+		}
+		PROFILE_DUMP();
+		return ok && errMsgs.empty() ? 0 : 1;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Renders the reports of the model library without GUI (option -render).
+	@param       path: Directory of the *.kxm files
+	@param     outDir: Directory receiving one file per model
+	@param numThreads: 0: One per core
+	@return Exit code
+	*******************************************************************************/
+	int renderLibrary(int argc, char** argv, const std::string& path, const std::string& outDir,
+		CReportRenderer::EFormat format, unsigned numThreads)
+	{
+		if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+		{	// Fonts and painting without display
+			qputenv("QT_QPA_PLATFORM", "offscreen");
+		}
+		QGuiApplication a(argc, argv);
+		CGlyphBase::initializeSymbolTable();
+		std::vector<std::string> errMsgs;
+		CModelData::loadLibrary(path, errMsgs);
+		const CReportRenderer renderer(outDir, format);
+		const size_t numRendered{renderer.renderLibrary(numThreads, errMsgs)};
+		for (const auto& errMsg : errMsgs)
+		{
+			fprintf(stderr, "%s\n", errMsg.c_str());
+		}
+		fprintf(stdout, "%u of %u models rendered to %s\n", unsigned(numRendered), unsigned(CModelData::size()),
+			outDir.c_str());
+		PROFILE_DUMP();
+		return errMsgs.empty() ? 0 : 1;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Keeps the evaluated library in memory and answers requests (option -serve).
+	@param   path: Directory of the *.kxm files
+	@param socket: Name of the local socket
+	@param  stdio: Serve stdin/stdout instead of the socket
+	@return Exit code
+	*******************************************************************************/
+	int serveLibrary(int argc, char** argv, const std::string& path, const std::string& socket, bool stdio)
+	{
+		QCoreApplication a(argc, argv);
+		CGlyphBase::initializeSymbolTable();
+		CQueryServer server(path);
+		if (stdio)
+		{
+			server.serveStdio();
+			PROFILE_DUMP();
+			return 0;
+		}
+		std::string errMsg;
+		if (!server.listen(socket.c_str(), errMsg))
+		{
+			fprintf(stderr, "%s\n", errMsg.c_str());
+			return 1;
+		}
+		const int ret{a.exec()};
+		PROFILE_DUMP();
+		return ret;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Sends a request to a running server (option -query), prints the reply.
+	@return Exit code
+	*******************************************************************************/
+	int queryServer(int argc, char** argv, const std::string& socket, const std::string& request)
+	{
+		QCoreApplication a(argc, argv);
+		const QByteArray reply(CQueryServer::query(socket.c_str(), request.c_str()));
+		if (reply.isEmpty())
+		{
+			fprintf(stderr, "No reply from %s\n", socket.c_str());
+			return 1;
+		}
+		fwrite(reply.constData(), 1, size_t(reply.size()), stdout);
+		return 0;
+	}
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Options:
+  -scan [dir]   Load and evaluate the model library without GUI; lists
+                duplicates and ill-conditioned models. dir may be an archive.
+  -pack file    Pack the library directory (-scan dir, default Data) into an
+                archive (*.kxa, see CModelArchive). Files unchanged since the
+                previous -pack are not compressed again.
+  -export file  With -scan: Write the exponent matrices (read by the Python
+                module, see python/kanonmodule.cpp).
+  -serve [dir]  Keep the evaluated library in memory, answer JSON requests
+                (see CQueryServer) on a local socket.
+  -stdio        With -serve: Answer requests from stdin instead.
+  -socket name  Socket of -serve and -query (default "kanon").
+  -query json   Send a request to a running server, print the reply.
+  -render [dir] Write the report of each model of the library (PDF, without
+                GUI; see CReportRenderer).
+  -out dir      With -render: Destination directory (default ".").
+  -svg          With -render: SVG instead of PDF.
+  -threads n    With -render: Number of threads (default: one per core).
+  -trace file   Write a Chrome trace (requires DEFINES += KANON_PROFILE).
+*******************************************************************************/
 int main(int argc, char** argv)
 {
+	bool scan{};
+	bool serve{};
+	bool stdio{};
+	bool render{};
+	unsigned numThreads{};
+	CReportRenderer::EFormat format{CReportRenderer::eFormatPdf};
+	std::string scanPath(pathToData());
+	std::string socket("kanon");
+	std::string request;
+	std::string exportPath;
+	std::string packPath;
+	std::string outDir(".");
+	if (const char* trace{getenv("KANON_TRACE")})
+	{
+		CProfiler::instance().setTraceFile(trace);
+	}
+	for (int ax{1}; ax < argc; ax++)
+	{
+		if (0 == strcmp(argv[ax], "-scan"))
+		{
+			scan = true;
+			if (ax + 1 < argc && argv[ax + 1][0] != '-')
+			{
+				scanPath = argv[++ax];
+			}
+		}
+		else if (0 == strcmp(argv[ax], "-serve"))
+		{
+			serve = true;
+			if (ax + 1 < argc && argv[ax + 1][0] != '-')
+			{
+				scanPath = argv[++ax];
+			}
+		}
+		else if (0 == strcmp(argv[ax], "-render"))
+		{
+			render = true;
+			if (ax + 1 < argc && argv[ax + 1][0] != '-')
+			{
+				scanPath = argv[++ax];
+			}
+		}
+		else if (0 == strcmp(argv[ax], "-out") && ax + 1 < argc)
+		{
+			outDir = argv[++ax];
+		}
+		else if (0 == strcmp(argv[ax], "-svg"))
+		{
+			format = CReportRenderer::eFormatSvg;
+		}
+		else if (0 == strcmp(argv[ax], "-threads") && ax + 1 < argc)
+		{
+			numThreads = unsigned(atoi(argv[++ax]));
+		}
+		else if (0 == strcmp(argv[ax], "-export") && ax + 1 < argc)
+		{
+			exportPath = argv[++ax];
+		}
+		else if (0 == strcmp(argv[ax], "-pack") && ax + 1 < argc)
+		{
+			packPath = argv[++ax];
+		}
+		else if (0 == strcmp(argv[ax], "-stdio"))
+		{
+			stdio = true;
+		}
+		else if (0 == strcmp(argv[ax], "-socket") && ax + 1 < argc)
+		{
+			socket = argv[++ax];
+		}
+		else if (0 == strcmp(argv[ax], "-query") && ax + 1 < argc)
+		{
+			request = argv[++ax];
+		}
+		else if (0 == strcmp(argv[ax], "-trace") && ax + 1 < argc)
+		{
+			CProfiler::instance().setTraceFile(argv[++ax]);
+		}
+	}
+	if (!packPath.empty())
+	{
+		return packLibrary(argc, argv, scanPath, packPath);
+	}
+	if (scan)
+	{
+		return scanLibrary(argc, argv, scanPath, exportPath);
+	}
+	if (render)
+	{
+		return renderLibrary(argc, argv, scanPath, outDir, format, numThreads);
+	}
+	if (serve)
+	{
+		return serveLibrary(argc, argv, scanPath, socket, stdio);
+	}
+	if (!request.empty())
+	{
+		return queryServer(argc, argv, socket, request);
+	}
 	QApplication a(argc, argv);
 	QFont font(QApplication::font());
 	font.setPointSize(10);
@@ -11,5 +311,7 @@ int main(int argc, char** argv)
 	CWndMain wnd;
 	wnd.show();
 	a.connect(&a, SIGNAL(lastWindowClosed()), &a, SLOT(quit()));
-	return a.exec();
+	const int ret{a.exec()};
+	PROFILE_DUMP();
+	return ret;
 }
@@ -0,0 +1,535 @@
+/******************************************************************************/
+/**
+@file         kanonmodule.cpp
+@copyright
+*
+@description  Python extension over the Qt-free numerics (CNumerics, CExpMatrix).
+*
+  import kanon
+  models = kanon.load("library.txt")     # Written by "kanon -scan -export library.txt"
+  kanon.evaluate_batch(models)           # Releases the GIL
+  m = models[0]
+  m.crit_dim, numpy.asarray(m.exps), numpy.asarray(m.can_dim), numpy.asarray(m.normal_vect)
+  kanon.Model(1, 1, [[-1, 2, 2], [-1, 0, 4]], "phi^4")   # Rows: expD, exponents
+*
+  Arrays are read only memoryviews of the data inside the model (no copy).
+  A model cannot be evaluated again while views of its results exist.
+*******************************************************************************/
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "CExpMatrix.h"
+#include "CNumerics.h"
+
+namespace
+{
+	/* CLASS DECLARATION **********************************************************/
+	/**
+	  kanon.Model
+	*******************************************************************************/
+	struct SPyModel
+	{
+		PyObject_HEAD
+		CExpMatrix* exps;
+		std::string* name;
+		SEvaluation* result;
+		std::vector<double>* canDim; // (1 + numTerm) x 2: constant, coefficient of d
+		Py_ssize_t views;            // Exported buffers
+		Py_ssize_t resultViews;      // Exported buffers of result arrays
+		bool evaluated;
+		bool busy;                   // Evaluated without GIL
+	};
+
+	/* CLASS DECLARATION **********************************************************/
+	/**
+	  Buffer exporter for an array inside a SPyModel (kept alive by owner).
+	*******************************************************************************/
+	struct SPyArray
+	{
+		PyObject_HEAD
+		SPyModel* owner;
+		void* data;
+		const char* format;
+		Py_ssize_t itemSize;
+		int ndim;
+		Py_ssize_t shape[2];
+		Py_ssize_t strides[2];
+		bool isResult;
+	};
+
+	PyTypeObject g_ModelType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+	PyTypeObject g_ArrayType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+	const SEvaluation InitialResult{CNumerics::INVALID_CRITDIM, -1, std::vector<SCanDim>(), std::vector<int>(), -1};
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Copies the canonical dimensions to the contiguous array of the model.
+	*******************************************************************************/
+	void takeResult(SPyModel* self)
+	{
+		self->canDim->clear();
+		for (const auto& dim : self->result->canDim)
+		{
+			self->canDim->push_back(dim.constVal);
+			self->canDim->push_back(dim.dVal);
+		}
+		self->evaluated = true;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return false (with a Python exception) if the results must not change
+	*******************************************************************************/
+	bool mayEvaluate(SPyModel* self)
+	{
+		if (self->busy)
+		{
+			PyErr_SetString(PyExc_RuntimeError, "model is being evaluated");
+			return false;
+		}
+		if (self->resultViews > 0)
+		{
+			PyErr_SetString(PyExc_BufferError, "results of the model are still referenced");
+			return false;
+		}
+		return true;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Creates a memoryview of an array inside the model.
+	*******************************************************************************/
+	PyObject* newView(SPyModel* owner, void* data, const char* format, Py_ssize_t itemSize,
+		Py_ssize_t rows, Py_ssize_t cols, bool isResult)
+	{
+		SPyArray* array{PyObject_New(SPyArray, &g_ArrayType)};
+		if (!array)
+		{
+			return nullptr;
+		}
+		Py_INCREF(owner);
+		array->owner = owner;
+		array->data = data;
+		array->format = format;
+		array->itemSize = itemSize;
+		array->ndim = cols > 0 ? 2 : 1;
+		array->shape[0] = rows;
+		array->shape[1] = cols;
+		array->strides[0] = cols > 0 ? cols * itemSize : itemSize;
+		array->strides[1] = itemSize;
+		array->isResult = isResult;
+		PyObject* view{PyMemoryView_FromObject(reinterpret_cast<PyObject*>(array))};
+		Py_DECREF(array);
+		return view;
+	}
+
+	//-----------------------------------------------------------------------------
+	// kanon.Array
+	//-----------------------------------------------------------------------------
+	void arrayDealloc(SPyArray* self)
+	{
+		Py_XDECREF(self->owner);
+		PyObject_Del(self);
+	}
+
+	int arrayGetBuffer(SPyArray* self, Py_buffer* view, int flags)
+	{
+		if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE)
+		{
+			PyErr_SetString(PyExc_BufferError, "kanon arrays are read only");
+			return -1;
+		}
+		static char empty{};
+		view->buf = self->data ? self->data : &empty;
+		view->obj = reinterpret_cast<PyObject*>(self);
+		Py_INCREF(self);
+		view->len = self->shape[0] * (self->ndim == 2 ? self->shape[1] : 1) * self->itemSize;
+		view->readonly = 1;
+		view->itemsize = self->itemSize;
+		view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(self->format) : nullptr;
+		view->ndim = self->ndim;
+		view->shape = self->shape;
+		view->strides = self->strides;
+		view->suboffsets = nullptr;
+		view->internal = nullptr;
+		self->owner->views++;
+		if (self->isResult)
+		{
+			self->owner->resultViews++;
+		}
+		return 0;
+	}
+
+	void arrayReleaseBuffer(SPyArray* self, Py_buffer*)
+	{
+		self->owner->views--;
+		if (self->isResult)
+		{
+			self->owner->resultViews--;
+		}
+	}
+
+	PyBufferProcs g_ArrayBuffer = {
+		reinterpret_cast<getbufferproc>(arrayGetBuffer),
+		reinterpret_cast<releasebufferproc>(arrayReleaseBuffer)
+	};
+
+	//-----------------------------------------------------------------------------
+	// kanon.Model
+	//-----------------------------------------------------------------------------
+	PyObject* modelNew(PyTypeObject* type, PyObject*, PyObject*)
+	{
+		SPyModel* self{reinterpret_cast<SPyModel*>(type->tp_alloc(type, 0))};
+		if (self)
+		{
+			self->exps = new CExpMatrix;
+			self->name = new std::string;
+			self->result = new SEvaluation(InitialResult);
+			self->canDim = new std::vector<double>;
+			self->views = 0;
+			self->resultViews = 0;
+			self->evaluated = false;
+			self->busy = false;
+		}
+		return reinterpret_cast<PyObject*>(self);
+	}
+
+	void modelDealloc(SPyModel* self)
+	{
+		delete self->exps;
+		delete self->name;
+		delete self->result;
+		delete self->canDim;
+		Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Model(num_coord, num_field, terms, name=""), each term a sequence
+	  [expD, exponent of coordinate 1, ..., exponent of the last field].
+	*******************************************************************************/
+	int modelInit(SPyModel* self, PyObject* args, PyObject* kwds)
+	{
+		static const char* keywords[]{"num_coord", "num_field", "terms", "name", nullptr};
+		Py_ssize_t numCoord{}, numField{};
+		PyObject* terms{};
+		const char* name{""};
+		if (!PyArg_ParseTupleAndKeywords(args, kwds, "nnO|s", const_cast<char**>(keywords),
+			&numCoord, &numField, &terms, &name))
+		{
+			return -1;
+		}
+		if (numCoord < 1 || numField < 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "at least one coordinate required");
+			return -1;
+		}
+		if (!mayEvaluate(self))
+		{
+			return -1;
+		}
+		if (self->views > 0)
+		{
+			PyErr_SetString(PyExc_BufferError, "exponents of the model are still referenced");
+			return -1;
+		}
+		self->exps->clear(size_t(numCoord), size_t(numField));
+		*self->name = name;
+		*self->result = InitialResult;
+		self->canDim->clear();
+		self->evaluated = false;
+		PyObject* seq{PySequence_Fast(terms, "terms must be a sequence")};
+		if (!seq)
+		{
+			return -1;
+		}
+		const size_t order{self->exps->order()};
+		std::vector<int> exp(order);
+		for (Py_ssize_t tx{}; tx < PySequence_Fast_GET_SIZE(seq); tx++)
+		{
+			PyObject* row{PySequence_Fast(PySequence_Fast_GET_ITEM(seq, tx), "term must be a sequence")};
+			if (!row)
+			{
+				Py_DECREF(seq);
+				return -1;
+			}
+			bool ok{PySequence_Fast_GET_SIZE(row) == Py_ssize_t(1 + order)};
+			int expD{};
+			for (Py_ssize_t cx{}; ok && cx <= Py_ssize_t(order); cx++)
+			{
+				const long val{PyLong_AsLong(PySequence_Fast_GET_ITEM(row, cx))};
+				ok = !(val == -1 && PyErr_Occurred());
+				(cx == 0 ? expD : exp[size_t(cx - 1)]) = int(val);
+			}
+			Py_DECREF(row);
+			if (!ok)
+			{
+				if (!PyErr_Occurred())
+				{
+					PyErr_Format(PyExc_ValueError, "term %zd: expD and %zu exponents expected", tx, order);
+				}
+				Py_DECREF(seq);
+				return -1;
+			}
+			self->exps->addTerm(exp, expD);
+		}
+		Py_DECREF(seq);
+		return 0;
+	}
+
+	PyObject* modelEvaluate(SPyModel* self, PyObject*)
+	{
+		if (!mayEvaluate(self))
+		{
+			return nullptr;
+		}
+		self->busy = true;
+		SEvaluation result(InitialResult);
+		bool ok{};
+		Py_BEGIN_ALLOW_THREADS
+		ok = CNumerics::evaluate(*self->exps, result);
+		Py_END_ALLOW_THREADS
+		self->busy = false;
+		std::swap(*self->result, result);
+		takeResult(self);
+		return PyBool_FromLong(ok);
+	}
+
+	PyObject* modelRepr(SPyModel* self)
+	{
+		return PyUnicode_FromFormat("<kanon.Model '%s', %zu coordinates, %zu fields, %zu terms>",
+			self->name->c_str(), self->exps->numCoord(), self->exps->numField(), self->exps->numTerm());
+	}
+
+	PyObject* getName(SPyModel* self, void*) { return PyUnicode_FromString(self->name->c_str()); }
+	PyObject* getNumCoord(SPyModel* self, void*) { return PyLong_FromSize_t(self->exps->numCoord()); }
+	PyObject* getNumField(SPyModel* self, void*) { return PyLong_FromSize_t(self->exps->numField()); }
+	PyObject* getNumTerm(SPyModel* self, void*) { return PyLong_FromSize_t(self->exps->numTerm()); }
+	PyObject* getEvaluated(SPyModel* self, void*) { return PyBool_FromLong(self->evaluated); }
+	PyObject* getRank(SPyModel* self, void*) { return PyLong_FromLong(self->result->rank); }
+
+	PyObject* getCritDim(SPyModel* self, void*)
+	{
+		if (self->result->critDim == CNumerics::INVALID_CRITDIM)
+		{
+			Py_RETURN_NONE;
+		}
+		return PyFloat_FromDouble(self->result->critDim);
+	}
+
+	PyObject* getExps(SPyModel* self, void*)
+	{
+		const CExpMatrix& exps(*self->exps);
+		return newView(self, const_cast<int*>(exps.exps().data()), "i", sizeof(int),
+			Py_ssize_t(exps.numTerm()), Py_ssize_t(exps.order()), false);
+	}
+
+	PyObject* getExpsD(SPyModel* self, void*)
+	{
+		const CExpMatrix& exps(*self->exps);
+		return newView(self, const_cast<int*>(exps.expsD().data()), "i", sizeof(int),
+			Py_ssize_t(exps.numTerm()), 0, false);
+	}
+
+	PyObject* getCanDim(SPyModel* self, void*)
+	{
+		if (self->busy)
+		{
+			PyErr_SetString(PyExc_RuntimeError, "model is being evaluated");
+			return nullptr;
+		}
+		return newView(self, self->canDim->data(), "d", sizeof(double),
+			Py_ssize_t(self->canDim->size() / 2), 2, true);
+	}
+
+	PyObject* getNormalVect(SPyModel* self, void*)
+	{
+		if (self->busy)
+		{
+			PyErr_SetString(PyExc_RuntimeError, "model is being evaluated");
+			return nullptr;
+		}
+		return newView(self, self->result->normalVect.data(), "i", sizeof(int),
+			Py_ssize_t(self->result->normalVect.size()), 0, true);
+	}
+
+	PyGetSetDef g_ModelGetSet[] = {
+		{"name", reinterpret_cast<getter>(getName), nullptr, "Model name", nullptr},
+		{"num_coord", reinterpret_cast<getter>(getNumCoord), nullptr, "Number of coordinates", nullptr},
+		{"num_field", reinterpret_cast<getter>(getNumField), nullptr, "Number of fields", nullptr},
+		{"num_term", reinterpret_cast<getter>(getNumTerm), nullptr, "Number of terms", nullptr},
+		{"exps", reinterpret_cast<getter>(getExps), nullptr,
+			"Exponents (terms x coordinates/fields, int32), column 0 without d", nullptr},
+		{"exps_d", reinterpret_cast<getter>(getExpsD), nullptr, "Coefficients of d (per term, int32)", nullptr},
+		{"evaluated", reinterpret_cast<getter>(getEvaluated), nullptr, "True after evaluation", nullptr},
+		{"crit_dim", reinterpret_cast<getter>(getCritDim), nullptr, "Critical dimension or None", nullptr},
+		{"rank", reinterpret_cast<getter>(getRank), nullptr, "Rank, -1 if not determined", nullptr},
+		{"can_dim", reinterpret_cast<getter>(getCanDim), nullptr,
+			"Canonical dimensions (1st coordinate, coordinates/fields, coupling constants) x "
+			"(constant, coefficient of d), float64", nullptr},
+		{"normal_vect", reinterpret_cast<getter>(getNormalVect), nullptr, "Normal vector (int32)", nullptr},
+		{nullptr, nullptr, nullptr, nullptr, nullptr}
+	};
+
+	PyMethodDef g_ModelMethods[] = {
+		{"evaluate", reinterpret_cast<PyCFunction>(modelEvaluate), METH_NOARGS,
+			"Determines critical and canonical dimensions, returns True on success"},
+		{nullptr, nullptr, 0, nullptr}
+	};
+
+	//-----------------------------------------------------------------------------
+	// Module functions
+	//-----------------------------------------------------------------------------
+	/* FUNCTION *******************************************************************/
+	/**
+	  load(path): Reads models written by "kanon -scan -export path".
+	*******************************************************************************/
+	PyObject* load(PyObject*, PyObject* args)
+	{
+		const char* path{};
+		if (!PyArg_ParseTuple(args, "s", &path))
+		{
+			return nullptr;
+		}
+		std::ifstream file(path);
+		if (!file)
+		{
+			PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+			return nullptr;
+		}
+		PyObject* list{PyList_New(0)};
+		std::string name, errMsg;
+		CExpMatrix exps;
+		while (list && exps.read(file, name, errMsg))
+		{
+			SPyModel* model{reinterpret_cast<SPyModel*>(modelNew(&g_ModelType, nullptr, nullptr))};
+			if (!model)
+			{
+				Py_CLEAR(list);
+				break;
+			}
+			*model->exps = exps;
+			*model->name = name;
+			if (PyList_Append(list, reinterpret_cast<PyObject*>(model)) < 0)
+			{
+				Py_CLEAR(list);
+			}
+			Py_DECREF(model);
+		}
+		if (list && !errMsg.empty())
+		{
+			Py_CLEAR(list);
+			PyErr_SetString(PyExc_ValueError, errMsg.c_str());
+		}
+		return list;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  evaluate_batch(models): Evaluates in batches (see CNumerics::evaluate())
+	  without holding the GIL.
+	*******************************************************************************/
+	PyObject* evaluateBatch(PyObject*, PyObject* args)
+	{
+		PyObject* arg{};
+		if (!PyArg_ParseTuple(args, "O", &arg))
+		{
+			return nullptr;
+		}
+		PyObject* seq{PySequence_Fast(arg, "sequence of kanon.Model expected")};
+		if (!seq)
+		{
+			return nullptr;
+		}
+		std::vector<SPyModel*> models;
+		std::vector<const CExpMatrix*> exps;
+		for (Py_ssize_t mx{}; mx < PySequence_Fast_GET_SIZE(seq); mx++)
+		{
+			PyObject* item{PySequence_Fast_GET_ITEM(seq, mx)};
+			if (!PyObject_TypeCheck(item, &g_ModelType))
+			{
+				PyErr_SetString(PyExc_TypeError, "sequence of kanon.Model expected");
+				Py_DECREF(seq);
+				return nullptr;
+			}
+			SPyModel* model{reinterpret_cast<SPyModel*>(item)};
+			if (!mayEvaluate(model))
+			{
+				Py_DECREF(seq);
+				return nullptr;
+			}
+			models.push_back(model);
+			exps.push_back(model->exps);
+		}
+		for (SPyModel* model : models)
+		{	// Duplicates in the sequence are fine, all belong to this call.
+			model->busy = true;
+		}
+		std::vector<SEvaluation> results;
+		Py_BEGIN_ALLOW_THREADS
+		CNumerics::evaluate(exps, results);
+		Py_END_ALLOW_THREADS
+		for (size_t mx{}; mx < models.size(); mx++)
+		{
+			models[mx]->busy = false;
+			std::swap(*models[mx]->result, results[mx]);
+			takeResult(models[mx]);
+		}
+		Py_DECREF(seq);
+		Py_RETURN_NONE;
+	}
+
+	PyMethodDef g_Methods[] = {
+		{"load", load, METH_VARARGS, "load(path) -> list of Model (file written by kanon -scan -export)"},
+		{"evaluate_batch", evaluateBatch, METH_VARARGS, "evaluate_batch(models): Evaluates without the GIL"},
+		{nullptr, nullptr, 0, nullptr}
+	};
+
+	PyModuleDef g_Module = {
+		PyModuleDef_HEAD_INIT, "kanon", "Critical and canonical dimensions of field theories", -1, g_Methods,
+		nullptr, nullptr, nullptr, nullptr
+	};
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Module initialization
+*******************************************************************************/
+PyMODINIT_FUNC PyInit_kanon()
+{
+	g_ArrayType.tp_name = "kanon.Array";
+	g_ArrayType.tp_basicsize = sizeof(SPyArray);
+	g_ArrayType.tp_dealloc = reinterpret_cast<destructor>(arrayDealloc);
+	g_ArrayType.tp_as_buffer = &g_ArrayBuffer;
+	g_ArrayType.tp_flags = Py_TPFLAGS_DEFAULT;
+	g_ArrayType.tp_doc = "Read only array inside a kanon.Model";
+	g_ModelType.tp_name = "kanon.Model";
+	g_ModelType.tp_basicsize = sizeof(SPyModel);
+	g_ModelType.tp_dealloc = reinterpret_cast<destructor>(modelDealloc);
+	g_ModelType.tp_repr = reinterpret_cast<reprfunc>(modelRepr);
+	g_ModelType.tp_flags = Py_TPFLAGS_DEFAULT;
+	g_ModelType.tp_doc = "Model(num_coord, num_field, terms, name=''), term = [expD, exponents...]";
+	g_ModelType.tp_methods = g_ModelMethods;
+	g_ModelType.tp_getset = g_ModelGetSet;
+	g_ModelType.tp_init = reinterpret_cast<initproc>(modelInit);
+	g_ModelType.tp_new = modelNew;
+	if (PyType_Ready(&g_ArrayType) < 0 || PyType_Ready(&g_ModelType) < 0)
+	{
+		return nullptr;
+	}
+	PyObject* module{PyModule_Create(&g_Module)};
+	if (!module)
+	{
+		return nullptr;
+	}
+	Py_INCREF(&g_ModelType);
+	if (PyModule_AddObject(module, "Model", reinterpret_cast<PyObject*>(&g_ModelType)) < 0)
+	{
+		Py_DECREF(&g_ModelType);
+		Py_DECREF(module);
+		return nullptr;
+	}
+	return module;
+}
@@ -0,0 +1,13 @@
+# Builds the Python extension "kanon" (see kanonmodule.cpp):
+#   python setup.py build_ext --inplace
+from setuptools import Extension, setup
+
+core = ['../CBatchSolver.cpp', '../CExpMatrix.cpp', '../CFactorCache.cpp', '../CLuFactor.cpp', '../CNumerics.cpp', '../CSparseLu.cpp', '../strutil.cpp']
+
+setup(
+	name='kanon',
+	version='1.0',
+	description='Critical and canonical dimensions of field theories',
+	ext_modules=[Extension('kanon', ['kanonmodule.cpp'] + core, include_dirs=['..'],
+		extra_compile_args=['-std=c++11'])],
+)
@@ -1,8 +1,14 @@
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib> // wcstombs()
 #include <cstring>
 #include "strutil.h"
+#if __cplusplus >= 201703L && defined(__has_include)
+# if __has_include(<charconv>)
+#  include <charconv>
+# endif
+#endif
 
 #define isAlNum(ch) isalnum((unsigned char)(ch))
 #ifdef _WIN32
@@ -509,6 +515,73 @@ string toLower(const string& str)
 	return ret;
 }
 
+/* FUNCTION *******************************************************************/
+/**
+  Formats into a caller provided buffer, without allocation. Uses
+  std::to_chars where the library provides it for floating point values.
+@param   buf: [out] Zero terminated text, truncated to size - 1 characters
+@param  size: Of buf
+@param   val: Value
+@param format: Number of decimals
+@return Length of the text
+*******************************************************************************/
+size_t toChars(char* buf, size_t size, double val, SFixedFormat format)
+{
+	if (size == 0)
+	{
+		return 0;
+	}
+#ifdef __cpp_lib_to_chars
+	const std::to_chars_result res{std::to_chars(buf, buf + size - 1, val, std::chars_format::fixed, format.precision)};
+	if (res.ec == std::errc())
+	{
+		*res.ptr = 0;
+		return size_t(res.ptr - buf);
+	}
+#endif
+	const int len{snprintf(buf, size, "%.*f", format.precision, val)};
+	return len < 0 ? 0 : std::min(size_t(len), size - 1);
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Formats into a caller provided buffer, without allocation.
+@param  buf: [out] Zero terminated text (size >= 21 holds any value)
+@param size: Of buf
+@return Length of the text, 0 if buf is too small
+*******************************************************************************/
+size_t toChars(char* buf, size_t size, long long val)
+{
+	char digits[24];
+	size_t num{};
+	unsigned long long mag{val < 0 ? 0ULL - (unsigned long long)val : (unsigned long long)val};
+	do
+	{
+		digits[num++] = char('0' + mag % 10);
+		mag /= 10;
+	} while (mag > 0);
+	const size_t len{num + (val < 0)};
+	if (len >= size)
+	{
+		if (size > 0)
+		{
+			*buf = 0;
+		}
+		return 0;
+	}
+	char* dst{buf};
+	if (val < 0)
+	{
+		*dst++ = '-';
+	}
+	while (num > 0)
+	{
+		*dst++ = digits[--num];
+	}
+	*dst = 0;
+	return len;
+}
+
 /* FUNCTION *******************************************************************/
 /**
   Converts number to string
@@ -516,16 +589,23 @@ string toLower(const string& str)
 string toString(int val, const char* format)
 {
 	char buf[128];
+	if (format[0] == '%' && format[1] == 'd' && format[2] == 0)
+	{	// Default format: without parsing, no allocation (short string)
+		return string(buf, toChars(buf, sizeof(buf), (long long)val));
+	}
 	sPrintF(buf, format, val);
 	return string(buf);
 }
 string toString(unsigned val, const char* format)
 {
 	char buf[128];
+	if (format[0] == '%' && format[1] == 'u' && format[2] == 0)
+	{
+		return string(buf, toChars(buf, sizeof(buf), (long long)val));
+	}
 	sPrintF(buf, format, val);
 	return string(buf);
 }
-
 #ifndef __GNUC__
 string toString(_int64 val, const char* format)
 {
@@ -538,6 +618,13 @@ string toString(_int64 val, const char* format)
 string toString(double val, const char* format)
 {
 	char buf[128];
+#ifdef __cpp_lib_to_chars
+	if (format[0] == '%' && format[1] == 'g' && format[2] == 0)
+	{	// As printf("%g")
+		const std::to_chars_result res{std::to_chars(buf, buf + sizeof(buf), val, std::chars_format::general, 6)};
+		return string(buf, res.ptr);
+	}
+#endif
 	sPrintF(buf, format, val);
 	return string(buf);
 }
@@ -8,6 +8,12 @@ std::string functions, sorted alphabetically
 
 using std::string;
 
+struct SFixedFormat // As printf("%.<precision>f"), known at compile time
+{
+	int precision;
+};
+const SFixedFormat Fixed3{3};
+
 string appendChar(const string&, size_t len, int ch = ' ');
 int    cmpmemi(const void*, const void*, int numByte);
 int    cmpstri(const string&, const string&);
@@ -32,6 +38,8 @@ string setLastChar(const string&, int ch = '/');
 void   split(std::vector<string>& result, const string& source, int sep, bool checkEscape = false);
 bool   startsWith(const string&, const string& start);
 string toAscii(const std::wstring&);
+size_t toChars(char* buf, size_t size, double val, SFixedFormat format);
+size_t toChars(char* buf, size_t size, long long val);
 string toLower(const string&);
 string toString(const char* format, ...);
 string toString(double, const char* format = "%g");
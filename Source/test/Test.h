@@ -0,0 +1,29 @@
+/******************************************************************************/
+/**
+@file         Test.h
+@copyright
+*
+@description  Checks of the test target (see kanontest.pro).
+*******************************************************************************/
+#ifndef TEST_H
+#define TEST_H
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+/* FUNCTION DECLARATIONS ******************************************************/
+bool check(bool ok, const char* text, const char* file, int line);
+inline bool nearlyEqual(double x, double y, double tolerance = 1E-9)
+{
+	return std::fabs(x - y) <= tolerance * std::max(1.0, std::fabs(x) + std::fabs(y));
+}
+
+// Counts and reports a failed condition, continues with the next check
+#define CHECK(cond) check((cond), #cond, __FILE__, __LINE__)
+
+void testFiles();
+void testNumerics();
+void testRender();
+
+#endif
@@ -0,0 +1,181 @@
+/******************************************************************************/
+/**
+@file         TestFiles.cpp
+@copyright
+*
+@description  Checks of the model archive and the read-ahead of files.
+*******************************************************************************/
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include "CModelArchive.h"
+#include "CReadAhead.h"
+#include "Test.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+	/* FUNCTION *******************************************************************/
+	/**
+	@return false if the file could not be written
+	*******************************************************************************/
+	bool writeFile(const QString& pathname, const QByteArray& data)
+	{
+		QFile file(pathname);
+		return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return Content of the n-th test file, empty for n = 0
+	*******************************************************************************/
+	QByteArray content(size_t n)
+	{
+		QByteArray ret;
+		for (size_t lx{}; lx < n; lx++)
+		{
+			ret += "<Monomial index=\"" + QByteArray::number(int(n)) + "\"/>\n";
+		}
+		return ret;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Archive: pack, open, find and read members, repack reusing the frames of
+	  unchanged files.
+	*******************************************************************************/
+	void testArchive()
+	{
+		QTemporaryDir temp;
+		CHECK(temp.isValid());
+		const QString dir(temp.path() + "/models");
+		CHECK(QDir().mkpath(dir));
+		const size_t numFile{5};
+		for (size_t fx{}; fx < numFile; fx++)
+		{
+			CHECK(writeFile(dir + QString("/m%1.kxm").arg(fx), content(fx * 100)));
+		}
+		CHECK(writeFile(dir + "/ignored.txt", "no model"));
+		const string path((temp.path() + "/models.kxa").toStdString());
+		size_t numCompressed{};
+		vector<string> errMsgs;
+		CHECK(CModelArchive::pack(dir.toStdString(), path, numCompressed, errMsgs));
+		CHECK(numCompressed == numFile);
+		CHECK(errMsgs.empty());
+		CHECK(CModelArchive::isArchive(path));
+		CHECK(!CModelArchive::isArchive(dir.toStdString()));
+		string errMsg;
+		std::shared_ptr<const CModelArchive> archive(CModelArchive::open(path, errMsg));
+		CHECK(archive && errMsg.empty());
+		if (!archive)
+		{
+			return;
+		}
+		CHECK(archive->entries().size() == numFile);
+		CHECK(archive->find("ignored.txt") == archive->entries().size());
+		vector<size_t> ixs;
+		for (size_t fx{numFile}; fx-- > 0; )
+		{
+			const size_t ix{archive->find("m" + std::to_string(fx) + ".kxm")};
+			CHECK(ix < archive->entries().size());
+			if (ix >= archive->entries().size())
+			{
+				return;
+			}
+			QByteArray data;
+			CHECK(archive->read(ix, data, errMsg) && data == content(fx * 100));
+			ixs.push_back(ix);
+		}
+		const vector<QByteArray> datas(archive->read(ixs, 2));
+		CHECK(datas.size() == numFile);
+		for (size_t dx{}; dx < datas.size(); dx++)
+		{
+			CHECK(datas[dx] == content((numFile - 1 - dx) * 100));
+		}
+		// Members are addressed like files of a directory
+		string archivePath, member;
+		CHECK(CModelArchive::splitPathname(archive->pathname(ixs[0]), archivePath, member));
+		CHECK(archivePath == archive->path() && member == "m4.kxm");
+		CHECK(!CModelArchive::splitPathname(dir.toStdString() + "/m4.kxm", archivePath, member));
+		CHECK(!CModelArchive::splitPathname(path + "/", archivePath, member));
+		CHECK(CModelArchive::open(path, errMsg) == archive);
+		// Unchanged files are not compressed again
+		archive.reset();
+		CHECK(CModelArchive::pack(dir.toStdString(), path, numCompressed, errMsgs));
+		CHECK(numCompressed == 0);
+		CHECK(writeFile(dir + "/m1.kxm", content(7)));
+		CHECK(QFile::remove(dir + "/m2.kxm"));
+		CHECK(CModelArchive::pack(dir.toStdString(), path, numCompressed, errMsgs));
+		CHECK(numCompressed == 1);
+		CHECK(errMsgs.empty());
+		archive = CModelArchive::open(path, errMsg);
+		CHECK(archive && archive->entries().size() == numFile - 1);
+		if (archive)
+		{
+			QByteArray data;
+			CHECK(archive->find("m2.kxm") == archive->entries().size());
+			CHECK(archive->read(archive->find("m1.kxm"), data, errMsg) && data == content(7));
+			CHECK(archive->read(archive->find("m3.kxm"), data, errMsg) && data == content(300));
+		}
+		// No archive
+		CHECK(!CModelArchive::open((dir + "/m3.kxm").toStdString(), errMsg) && !errMsg.empty());
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Read-ahead: more files than the window, in order, with an empty and a
+	  missing file; the reader may be destroyed before all files are consumed.
+	*******************************************************************************/
+	void testReadAhead()
+	{
+		QTemporaryDir temp;
+		CHECK(temp.isValid());
+		const size_t numFile{CReadAhead::MaxFiles * 3 + 1}, missing{40};
+		vector<string> pathnames;
+		for (size_t fx{}; fx < numFile; fx++)
+		{
+			const QString pathname(temp.path() + QString("/f%1.kxm").arg(fx));
+			if (fx != missing)
+			{	// File 0 is empty
+				CHECK(writeFile(pathname, content(fx)));
+			}
+			pathnames.push_back(pathname.toStdString());
+		}
+		{
+			CReadAhead reader(pathnames);
+			bool ordered{true};
+			for (size_t fx{}; fx < numFile; fx++)
+			{
+				QByteArray data;
+				const bool ok{reader.next(data)};
+				ordered = ordered && ok == (fx != missing) && data == (ok ? content(fx) : QByteArray());
+			}
+			CHECK(ordered);
+			QByteArray data("x");
+			CHECK(!reader.next(data) && data.isNull());
+		}
+		{	// Stopped while the window is full
+			CReadAhead reader(pathnames);
+			QByteArray data;
+			CHECK(reader.next(data) && data.isEmpty());
+		}
+		{	// Nothing consumed
+			CReadAhead reader(pathnames);
+		}
+		CReadAhead none({});
+		QByteArray data;
+		CHECK(!none.next(data));
+	}
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Checks of the file access (QtCore only).
+*******************************************************************************/
+void testFiles()
+{
+	testArchive();
+	testReadAhead();
+}
@@ -0,0 +1,572 @@
+/******************************************************************************/
+/**
+@file         TestNumerics.cpp
+@copyright
+*
+@description  Checks of the Qt-free numerics.
+*******************************************************************************/
+#include <complex>
+#include <random>
+#include <sstream>
+#include "CBatchSolver.h"
+#include "CExpMatrix.h"
+#include "CFactorCache.h"
+#include "CLuFactor.h"
+#include "CNumerics.h"
+#include "COperatorEnum.h"
+#include "CSparseLu.h"
+#include "matrix.h"
+#include "Test.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+	/* FUNCTION *******************************************************************/
+	/**
+	@return Model read from the text format of CExpMatrix::write()
+	*******************************************************************************/
+	CExpMatrix readModel(const string& text)
+	{
+		std::istringstream is(text);
+		CExpMatrix mod;
+		string name, errMsg;
+		CHECK(mod.read(is, name, errMsg));
+		return mod;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return Fixture: Integral d^dx ((nabla phi)^2 + phi^4), critical dimension 4
+	*******************************************************************************/
+	CExpMatrix phi4Model()
+	{
+		return readModel(
+			"model phi4\n"
+			"coords 1 fields 1\n"
+			"-1 2 2\n"
+			"-1 0 4\n"
+			"end\n");
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return Model of numField fields with gradient terms and couplings of
+	  neighbouring fields (large and sparse, see CSparseLu)
+	*******************************************************************************/
+	CExpMatrix chainModel(int numField)
+	{
+		std::ostringstream os;
+		os << "model chain\ncoords 1 fields " << numField << "\n";
+		for (int tx{}; tx < numField; tx++)
+		{
+			os << "-1 2";
+			for (int fx{}; fx < numField; fx++)
+			{
+				os << ' ' << (fx == tx ? 2 : 0);
+			}
+			os << "\n";
+		}
+		for (int tx{}; tx < numField; tx++)
+		{
+			os << "-1 0";
+			for (int fx{}; fx < numField; fx++)
+			{
+				os << ' ' << (fx == tx || fx == (tx + 1) % numField ? 2 : 0);
+			}
+			os << "\n";
+		}
+		os << "end\n";
+		return readModel(os.str());
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	@return The terms of mod in the given order
+	*******************************************************************************/
+	CExpMatrix permuted(const CExpMatrix& mod, const vector<size_t>& terms)
+	{
+		CExpMatrix ret(mod.numCoord(), mod.numField());
+		for (const size_t tx : terms)
+		{
+			ret.addTerm(vector<int>(mod.row(tx), mod.row(tx) + mod.order()), mod.getExpD(tx));
+		}
+		return ret;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Solves mod by solver and by CNumerics.
+	@return false if the results differ, or only one of them throws
+	*******************************************************************************/
+	bool sameSolution(CCouplingSolver& solver, const CExpMatrix& mod, int rxOfCoupling, bool& singular)
+	{
+		double critDim{}, critDimRef{};
+		vector<SCanDim> canDim, canDimRef;
+		bool thrown{}, thrownRef{};
+		try
+		{
+			solver.determineCanonicalDimensions(critDim, canDim, mod, rxOfCoupling);
+		}
+		catch (const std::exception&)
+		{
+			thrown = true;
+		}
+		try
+		{
+			CNumerics::determineCanonicalDimensions(critDimRef, canDimRef, mod, rxOfCoupling);
+		}
+		catch (const std::exception&)
+		{
+			thrownRef = true;
+		}
+		singular = thrownRef;
+		if (thrown || thrownRef)
+		{
+			return thrown == thrownRef;
+		}
+		// Infinite if the coupling constant does not depend on d
+		bool ret{(critDim == critDimRef || nearlyEqual(critDim, critDimRef, 1E-7)) && canDim.size() == canDimRef.size()};
+		for (size_t cx{}; ret && cx < canDim.size(); cx++)
+		{
+			ret = nearlyEqual(canDim[cx].constVal, canDimRef[cx].constVal, 1E-7)
+				&& nearlyEqual(canDim[cx].dVal, canDimRef[cx].dVal, 1E-7);
+		}
+		return ret;
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  The phi^4 fixture: d_c = 4, [phi] = (d - 2)/2 and [g] = 4 - d with phi^4
+	  as interaction.
+	*******************************************************************************/
+	void testPhi4()
+	{
+		const CExpMatrix mod(phi4Model());
+		double critDim{};
+		CHECK(CNumerics::determineCritDim(critDim, mod));
+		CHECK(nearlyEqual(critDim, 4.0));
+		vector<SCanDim> canDim;
+		CNumerics::determineCanonicalDimensions(critDim, canDim, mod, 1);
+		CHECK(nearlyEqual(critDim, 4.0));
+		CHECK(canDim.size() == 3);
+		if (canDim.size() == 3)
+		{
+			CHECK(nearlyEqual(canDim[0].value(critDim), 1.0));
+			CHECK(nearlyEqual(canDim[1].constVal, -1.0) && nearlyEqual(canDim[1].dVal, 0.5));
+			CHECK(nearlyEqual(canDim[2].constVal, 4.0) && nearlyEqual(canDim[2].dVal, -1.0));
+		}
+		SEvaluation result{};
+		CHECK(CNumerics::evaluate(mod, result));
+		CHECK(nearlyEqual(result.critDim, 4.0));
+		CHECK(result.rxInteraction >= 0);
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  CSparseLu against CLuFactor: solutions and determinant of a random
+	  sparse matrix, canonical dimensions of a large model.
+	*******************************************************************************/
+	void testSparseLu()
+	{
+		const size_t n{60};
+		std::mt19937 gen(1);
+		std::uniform_real_distribution<double> value(-1.0, 1.0);
+		vector<double> dense(n * n);
+		SCsrMatrix csr(n);
+		for (size_t rx{}; rx < n; rx++)
+		{
+			for (size_t cx{}; cx < n; cx++)
+			{
+				const bool nonZero{cx == rx || gen() % 10 == 0};
+				dense[rx * n + cx] = nonZero ? value(gen) + (cx == rx ? 4.0 : 0.0) : 0.0;
+				csr.append(rx, cx, dense[rx * n + cx]);
+			}
+		}
+		csr.finish();
+		CLuFactor lu;
+		CSparseLu sparseLu;
+		CHECK(lu.factorize(dense, n));
+		CHECK(sparseLu.factorize(csr));
+		vector<double> b(2 * n), bSparse;
+		for (auto& val : b)
+		{
+			val = value(gen);
+		}
+		bSparse = b;
+		lu.solve(b, 2);
+		sparseLu.solve(bSparse, 2);
+		double maxDiff{};
+		for (size_t ix{}; ix < b.size(); ix++)
+		{
+			maxDiff = std::max(maxDiff, std::fabs(b[ix] - bSparse[ix]));
+		}
+		CHECK(maxDiff < 1E-10);
+		CHECK(nearlyEqual(lu.det(), sparseLu.det(), 1E-8));
+		CHECK(sparseLu.rcond() > 0.0);
+		// Large model: sparse, unless the optional outputs force the dense path
+		const CExpMatrix mod(chainModel(60));
+		double critDim{}, critDimDense{};
+		vector<SCanDim> canDim, canDimDense;
+		matrix<double> expMatrix, invMatrix;
+		CNumerics::determineCanonicalDimensions(critDim, canDim, mod, 0);
+		CNumerics::determineCanonicalDimensions(critDimDense, canDimDense, mod, 0, &expMatrix, &invMatrix);
+		CHECK(nearlyEqual(critDim, critDimDense));
+		CHECK(canDim.size() == canDimDense.size());
+		for (size_t cx{}; cx < canDim.size() && cx < canDimDense.size(); cx++)
+		{
+			CHECK(nearlyEqual(canDim[cx].constVal, canDimDense[cx].constVal)
+				&& nearlyEqual(canDim[cx].dVal, canDimDense[cx].dVal));
+		}
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  CFactorCache: lookup by full key, least recently used entries dropped
+	  first, statistics; evaluations with and without cache agree.
+	*******************************************************************************/
+	void testFactorCache()
+	{
+		CFactorCache& cache(CFactorCache::instance());
+		cache.clear();
+		CFactorCache::SEntry entry;
+		entry.det0 = 2.0;
+		entry.rank = 3;
+		const vector<int> key1{1, 2, 3}, key2{1, 2, 4}, key3{5};
+		cache.insert(key1, entry);
+		entry.rank = 4;
+		cache.insert(key2, entry);
+		CFactorCache::SEntry found;
+		CHECK(cache.find(key1, found) && found.rank == 3 && found.det0 == 2.0);
+		CHECK(cache.find(key2, found) && found.rank == 4);
+		CHECK(!cache.find(key3, found));
+		CFactorCache::SStats stats(cache.stats());
+		CHECK(stats.hits == 2 && stats.misses == 1 && stats.numEntry == 2);
+		// Room for two entries: key1 is the least recently used one
+		cache.setCapacity(stats.bytes);
+		CHECK(cache.find(key2, found));
+		cache.insert(key3, entry);
+		CHECK(!cache.find(key1, found));
+		CHECK(cache.find(key2, found) && cache.find(key3, found));
+		CHECK(cache.stats().evictions == 1);
+		// Cached results equal computed ones
+		const vector<CExpMatrix> models{phi4Model(), chainModel(3), chainModel(60)};
+		cache.setCapacity(CFactorCache::DefaultCapacity);
+		cache.clear();
+		vector<SEvaluation> cached(models.size()), computed(models.size());
+		for (int pass{}; pass < 2; pass++)
+		{	// Misses, then hits
+			for (size_t mx{}; mx < models.size(); mx++)
+			{
+				CNumerics::evaluate(models[mx], cached[mx]);
+			}
+		}
+		CHECK(cache.stats().hits > 0);
+		cache.setCapacity(0);
+		for (size_t mx{}; mx < models.size(); mx++)
+		{
+			CNumerics::evaluate(models[mx], computed[mx]);
+			CHECK(nearlyEqual(cached[mx].critDim, computed[mx].critDim));
+			CHECK(cached[mx].normalVect == computed[mx].normalVect);
+		}
+		CHECK(cache.stats().numEntry == 0);
+		cache.setCapacity(CFactorCache::DefaultCapacity);
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  CBatchSolver against CLuFactor (one singular lane), and the batched
+	  CNumerics::evaluate() against the scalar one on random models.
+	*******************************************************************************/
+	void testBatchSolver()
+	{
+		const size_t n{5};
+		std::mt19937 gen(2);
+		std::uniform_int_distribution<int> value(-3, 3);
+		CBatchSolver solver(n, 1);
+		vector<vector<double>> matrices(CBatchSolver::Lanes, vector<double>(n * n));
+		for (size_t lx{}; lx < CBatchSolver::Lanes; lx++)
+		{
+			for (size_t rx{}; rx < n; rx++)
+			{
+				for (size_t cx{}; cx < n; cx++)
+				{	// Lane 0: two equal rows
+					matrices[lx][rx * n + cx] = lx == 0 && rx == 1 ? matrices[lx][cx] : value(gen);
+					solver.a(lx, rx, cx) = matrices[lx][rx * n + cx];
+				}
+				solver.b(lx, rx, 0) = double(rx);
+			}
+		}
+		solver.factorize();
+		solver.solve();
+		CHECK(solver.singular(0));
+		for (size_t lx{}; lx < CBatchSolver::Lanes; lx++)
+		{
+			CLuFactor lu;
+			if (!lu.factorize(matrices[lx], n))
+			{
+				CHECK(solver.singular(lx));
+				continue;
+			}
+			CHECK(!solver.singular(lx) && nearlyEqual(solver.det(lx), lu.det()));
+			vector<double> b(n);
+			for (size_t rx{}; rx < n; rx++)
+			{
+				b[rx] = double(rx);
+			}
+			lu.solve(b, 1);
+			for (size_t rx{}; rx < n; rx++)
+			{
+				CHECK(nearlyEqual(solver.x(lx, rx, 0), b[rx], 1E-8));
+			}
+		}
+		// Batches of same-size models, some without critical dimension
+		vector<CExpMatrix> models;
+		for (int mx{}; mx < 3 * CBatchSolver::Lanes; mx++)
+		{
+			const size_t numCoord{1 + gen() % 2}, numField{2 + gen() % 2};
+			CExpMatrix mod(numCoord, numField);
+			for (size_t tx{}; tx < numCoord + numField + gen() % 3; tx++)
+			{
+				vector<int> exp(numCoord + numField);
+				for (auto& val : exp)
+				{
+					val = int(gen() % 4);
+				}
+				mod.addTerm(exp, -1);
+			}
+			models.push_back(mod);
+		}
+		models.push_back(phi4Model());
+		vector<const CExpMatrix*> batch;
+		for (const auto& mod : models)
+		{
+			batch.push_back(&mod);
+		}
+		vector<SEvaluation> results;
+		CNumerics::evaluate(batch, results);
+		CHECK(results.size() == models.size());
+		for (size_t mx{}; mx < models.size() && mx < results.size(); mx++)
+		{
+			SEvaluation result{};
+			const bool valid{CNumerics::evaluate(models[mx], result)};
+			CHECK(valid == (results[mx].critDim != CNumerics::INVALID_CRITDIM));
+			CHECK(nearlyEqual(results[mx].critDim, result.critDim, 1E-8));
+			CHECK(results[mx].normalVect == result.normalVect);
+		}
+		CHECK(nearlyEqual(results.back().critDim, 4.0));
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  CCouplingSolver against CNumerics: one solver through swaps and moves to
+	  the front of the terms of a fixed model (relabeling and rank-1 updates),
+	  a singular E1, and a factorization after MaxUpdates updates.
+	*******************************************************************************/
+	void testCouplingSolver()
+	{
+		// Coordinate x; fields phi, psi: gradient terms, interactions
+		const CExpMatrix mod(readModel(
+			"model m\ncoords 1 fields 2\n"
+			"-1 2 2 0\n"
+			"-1 2 0 2\n"
+			"-1 0 2 2\n"
+			"-1 0 4 0\n"
+			"-1 0 0 4\n"
+			"-1 0 6 0\n"
+			"-1 0 2 1\n"
+			"end\n"));
+		const int rx{2}; // Coupling constant of the 3rd term
+		CCouplingSolver solver;
+		vector<size_t> terms{0, 1, 2, 3, 4, 5, 6};
+		bool singular{};
+		CHECK(sameSolution(solver, permuted(mod, terms), rx, singular) && !singular);
+		CHECK(solver.numUpdate() == 0);
+		// Coupled terms reordered (extra terms, the interaction): relabeled
+		std::swap(terms[4], terms[6]);
+		CHECK(sameSolution(solver, permuted(mod, terms), rx, singular) && !singular);
+		std::swap(terms[2], terms[3]);
+		CHECK(sameSolution(solver, permuted(mod, terms), rx, singular) && !singular);
+		CHECK(solver.numUpdate() == 0);
+		// A term of E1 exchanged with an extra term: rank-1 update
+		std::swap(terms[0], terms[5]);
+		CHECK(sameSolution(solver, permuted(mod, terms), rx, singular) && !singular);
+		CHECK(solver.numUpdate() == 1);
+		// Random swaps and moves to the front
+		std::mt19937 gen(3);
+		size_t numSingular{}, numFailed{};
+		for (int step{}; step < 200; step++)
+		{
+			const size_t from{gen() % terms.size()}, to{gen() % terms.size()};
+			if (gen() % 2 == 0)
+			{
+				std::swap(terms[from], terms[to]);
+			}
+			else
+			{
+				std::rotate(terms.begin(), terms.begin() + from, terms.begin() + from + 1);
+			}
+			numFailed += !sameSolution(solver, permuted(mod, terms), rx, singular);
+			numSingular += singular;
+		}
+		CHECK(numFailed == 0);
+		CHECK(numSingular > 0);
+		// phi^4 and phi^6 depend linearly: singular
+		const vector<size_t> singularTerms{3, 5, 2, 0, 1, 4, 6};
+		double critDim{};
+		vector<SCanDim> canDim;
+		bool thrown{};
+		try
+		{
+			solver.determineCanonicalDimensions(critDim, canDim, permuted(mod, singularTerms), rx);
+		}
+		catch (const std::exception&)
+		{
+			thrown = true;
+		}
+		CHECK(thrown);
+		// (nabla phi)^2 and phi^4 exchanged back and forth: one update each,
+		// then factorized again
+		terms = {0, 1, 2, 3, 4, 5, 6};
+		CHECK(sameSolution(solver, permuted(mod, terms), rx, singular) && !singular);
+		unsigned numUpdate{solver.numUpdate()};
+		for (int step{}; step <= CCouplingSolver::MaxUpdates; step++)
+		{
+			std::swap(terms[0], terms[3]);
+			CHECK(sameSolution(solver, permuted(mod, terms), rx, singular) && !singular);
+			CHECK(solver.numUpdate() == (numUpdate < CCouplingSolver::MaxUpdates ? numUpdate + 1 : 0));
+			numUpdate = solver.numUpdate();
+		}
+		CHECK(numUpdate == 0);
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Canonical hash: equal for permuted terms, fields and further coordinates,
+	  different for other models and for other coefficients of sigma.
+	*******************************************************************************/
+	void testCanonicalHash()
+	{
+		// Coordinates x, t; fields phi, psi
+		const CExpMatrix mod(readModel(
+			"model m\ncoords 2 fields 2\n"
+			"-1 2 -1 1 1\n"
+			"-1 0 -1 1 2\n"
+			"-1 0 -1 2 1\n"
+			"-1 0 -1 3 0\n"
+			"-1 4 -1 0 2\n"
+			"end\n"));
+		// Terms reordered among the first four, fields swapped
+		const CExpMatrix permuted(readModel(
+			"model p\ncoords 2 fields 2\n"
+			"-1 0 -1 1 2\n"
+			"-1 2 -1 1 1\n"
+			"-1 0 -1 0 3\n"
+			"-1 0 -1 2 1\n"
+			"-1 4 -1 2 0\n"
+			"end\n"));
+		const CExpMatrix other(readModel(
+			"model o\ncoords 2 fields 2\n"
+			"-1 2 -1 1 1\n"
+			"-1 0 -1 1 2\n"
+			"-1 0 -1 2 1\n"
+			"-1 0 -1 3 0\n"
+			"-1 4 -1 0 3\n"
+			"end\n"));
+		CHECK(mod.canonical() == permuted.canonical());
+		CHECK(mod.canonicalHash() == permuted.canonicalHash());
+		CHECK(!(mod.canonicalHash() == other.canonicalHash()));
+		CHECK(!(phi4Model().canonicalHash() == mod.canonicalHash()));
+		// Sigma in the gradient of the 1st term, permuted like the terms
+		CExpMatrix zeros(2, 2), sigma(2, 2), sigmaPermuted(2, 2);
+		for (size_t tx{}; tx < mod.numTerm(); tx++)
+		{
+			const vector<int> none(4), first{1, 0, 0, 0};
+			zeros.addTerm(none, 0);
+			sigma.addTerm(tx == 0 ? first : none, 0);
+			sigmaPermuted.addTerm(tx == 1 ? first : none, 0);
+		}
+		CHECK(mod.canonicalHash(zeros) == mod.canonicalHash());
+		CHECK(mod.canonicalHash(sigma) == permuted.canonicalHash(sigmaPermuted));
+		CHECK(!(mod.canonicalHash(sigma) == mod.canonicalHash()));
+		CHECK(!(mod.canonicalHash(sigma) == permuted.canonicalHash(sigma)));
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Operator enumeration for (nabla phi)^2 + phi^4 at d_c = 4: coupling
+	  dimension 4 - degree - derivatives, phi^4 and (nabla phi)^2 marginal.
+	*******************************************************************************/
+	void testOperatorEnum()
+	{
+		const CExpMatrix mod(phi4Model());
+		double critDim{};
+		vector<SCanDim> canDim;
+		CNumerics::determineCanonicalDimensions(critDim, canDim, mod, 1);
+		CHECK(nearlyEqual(critDim, 4.0));
+		vector<double> dimAtCritDim, dVal;
+		for (const SCanDim& dim : canDim)
+		{
+			dimAtCritDim.push_back(dim.value(critDim));
+			dVal.push_back(dim.dVal);
+		}
+		COperatorEnum ops({6, 2, true, false, false, false}, 1, {false});
+		// Degree 2..6, with 0 or 2 gradients
+		CHECK(ops.enumerate() == 10);
+		CHECK(!ops.truncated());
+		ops.classify(dimAtCritDim, dVal, critDim);
+		size_t numOp{}, num[3]{};
+		double lastDim{1E9};
+		bool sorted{true}, dimOk{true};
+		vector<std::pair<unsigned, unsigned>> marginal; // Degree, derivatives
+		ops.stream([&](const COperatorEnum::SOperator& op)
+		{
+			numOp++;
+			num[op.relevance]++;
+			sorted = sorted && op.dim <= lastDim;
+			lastDim = op.dim;
+			dimOk = dimOk && op.expD == -1 && op.exps[0] == int(op.derivative)
+				&& op.exps[1] == int(op.degree)
+				&& nearlyEqual(op.dim + 1.0, 4.0 - op.degree - op.derivative + 1.0)
+				&& nearlyEqual(op.dVal + 2.0, 1.0 - 0.5 * op.degree + 2.0);
+			if (op.relevance == COperatorEnum::eMarginal)
+			{
+				marginal.push_back({op.degree, op.derivative});
+			}
+		});
+		CHECK(numOp == 10);
+		CHECK(sorted);
+		CHECK(dimOk);
+		CHECK(num[COperatorEnum::eRelevant] == 2);   // phi^2, phi^3
+		CHECK(num[COperatorEnum::eMarginal] == 2);
+		CHECK(num[COperatorEnum::eIrrelevant] == 6);
+		// Same dimension: lower degree first
+		CHECK(marginal.size() == 2 && marginal[0] == std::make_pair(2u, 2u)
+			&& marginal[1] == std::make_pair(4u, 0u));
+		CHECK(COperatorEnum::relevance(0.0005) == COperatorEnum::eMarginal);
+		CHECK(COperatorEnum::relevance(-0.5) == COperatorEnum::eIrrelevant);
+		// Odd gradients admitted; a response field required in each term
+		COperatorEnum odd({6, 2, false, false, false, false}, 1, {false});
+		CHECK(odd.enumerate() == 15);
+		COperatorEnum dynamic({2, 0, true, false, true, false}, 1, {true, false});
+		CHECK(dynamic.enumerate() == 2); // phi~ phi, phi~^2
+		COperatorEnum absorbing({2, 0, true, false, true, true}, 1, {true, false});
+		CHECK(absorbing.enumerate() == 1);
+	}
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Runs the checks of the numerics.
+*******************************************************************************/
+void testNumerics()
+{
+	testPhi4();
+	testSparseLu();
+	testFactorCache();
+	testBatchSolver();
+	testCouplingSolver();
+	testCanonicalHash();
+	testOperatorEnum();
+}
@@ -0,0 +1,126 @@
+/******************************************************************************/
+/**
+@file         TestRender.cpp
+@copyright
+*
+@description  Checks of the report rendering (needs a QGuiApplication).
+*******************************************************************************/
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+#include "CFormula.h"
+#include "CModelData.h"
+#include "CReportRenderer.h"
+#include "Test.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+	/* FUNCTION *******************************************************************/
+	/**
+	@return Monomial integral d^dx (nabla^gradient) field_fx^exponent ...
+	*******************************************************************************/
+	QByteArray monomial(int gradient, const vector<std::pair<int, int>>& fieldExps)
+	{
+		QByteArray ret("<Monomial>\n<Factor type=\"coord\" index=\"0\" symbol=\"Integral\"/>\n");
+		if (gradient > 0)
+		{
+			ret += "<Factor type=\"coord\" index=\"0\" symbol=\"nabla\" exponent=\""
+				+ QByteArray::number(gradient) + "\"/>\n";
+		}
+		for (const auto& fieldExp : fieldExps)
+		{
+			ret += "<Factor type=\"field\" index=\"" + QByteArray::number(fieldExp.first)
+				+ "\" exponent=\"" + QByteArray::number(fieldExp.second) + "\"/>\n";
+		}
+		return ret + "</Monomial>\n";
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Writes a model file (see CModelData::saveData()).
+	@param fields: Symbols of the fields
+	@return false if the file could not be written
+	*******************************************************************************/
+	bool writeModel(const QString& pathname, const char* name, const vector<const char*>& fields,
+		const QByteArray& monomials)
+	{
+		QByteArray xml("<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>\n"
+			"<Kanon version=\"4\">\n<Name>");
+		xml += name;
+		xml += "</Name>\n<Coordinate symbol=\"x\"/>\n";
+		for (const char* field : fields)
+		{
+			xml += "<Field symbol=\"" + QByteArray(field) + "\"/>\n";
+		}
+		xml += monomials + "</Kanon>\n";
+		QFile file(pathname);
+		return file.open(QIODevice::WriteOnly) && file.write(xml) == xml.size();
+	}
+
+	/* FUNCTION *******************************************************************/
+	/**
+	  Renders a library with a model of two fields, (nabla phi)^2 + (nabla psi)^2
+	  + phi^2 psi^2, and one of a single field psi: each formula is painted
+	  against the coordinates and fields of its own model.
+	*******************************************************************************/
+	void testRenderLibrary()
+	{
+		QTemporaryDir temp;
+		CHECK(temp.isValid());
+		const QString dir(temp.path() + "/models");
+		CHECK(QDir().mkpath(dir));
+		CHECK(writeModel(dir + "/Two.kxm", "Two fields", {"phi", "psi"},
+			monomial(2, {{0, 2}}) + monomial(2, {{1, 2}}) + monomial(0, {{0, 2}, {1, 2}})));
+		CHECK(writeModel(dir + "/One.kxm", "One field", {"psi"},
+			monomial(2, {{0, 2}}) + monomial(0, {{0, 4}})));
+		vector<string> errMsgs;
+		CModelData::loadLibrary(dir.toStdString(), errMsgs);
+		CHECK(errMsgs.empty());
+		CHECK(CModelData::size() == 2);
+		if (CModelData::size() != 2)
+		{
+			return;
+		}
+		// Sorted by pathname
+		CModelData one(CModelData::at(0)), two(CModelData::at(1));
+		string errMsg;
+		CHECK(one.ensureLoaded(errMsg) && two.ensureLoaded(errMsg));
+		CHECK(one.numField() == 1 && two.numField() == 2);
+		// Exponents of the scan (without glyphs) as those of the full load
+		CHECK(one.expMatrix() == CModelData::at(0).expMatrix() && two.expMatrix() == CModelData::at(1).expMatrix());
+		CHECK(two.expMatrix().numTerm() == 3 && two.expMatrix().getExp(0, 0) == 2 && two.expMatrix().getExpD(0) == -1);
+		CHECK(nearlyEqual(two.critDim(), 4.0));
+		if (one.monomials().size() == 2 && two.monomials().size() == 3)
+		{	// Same first term, other field symbol
+			CHECK(one.monomials()[0].paintKey(one) != two.monomials()[0].paintKey(two));
+			CHECK(two.monomials()[0].paintKey(two) != two.monomials()[1].paintKey(two));
+		}
+		else
+		{
+			CHECK(false);
+		}
+		const string outDir((temp.path() + "/reports").toStdString());
+		const CReportRenderer renderer(outDir, CReportRenderer::eFormatSvg);
+		CHECK(renderer.renderLibrary(2, errMsgs) == 2);
+		CHECK(errMsgs.empty());
+		for (const CModelData* mod : {&one, &two})
+		{
+			const QFileInfo info(renderer.pathname(*mod).c_str());
+			CHECK(info.isFile() && info.size() > 0);
+		}
+		CHECK(renderer.render(two, errMsg) && errMsg.empty());
+	}
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Checks of the report rendering.
+*******************************************************************************/
+void testRender()
+{
+	testRenderLibrary();
+}
@@ -0,0 +1,48 @@
+/******************************************************************************/
+/**
+@file         main.cpp
+@copyright
+*
+@description  Runs the checks of the test target.
+*******************************************************************************/
+#include <cstdio>
+#include <QtGui/QGuiApplication>
+#include "CGlyph.h"
+#include "Test.h"
+
+namespace
+{
+	unsigned g_NumCheck{};
+	unsigned g_NumFailed{};
+}
+
+/* FUNCTION *******************************************************************/
+/**
+  Counts a check, reports it if it failed.
+@return ok
+*******************************************************************************/
+bool check(bool ok, const char* text, const char* file, int line)
+{
+	g_NumCheck++;
+	if (!ok)
+	{
+		g_NumFailed++;
+		fprintf(stderr, "%s(%d): Failed: %s\n", file, line, text);
+	}
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+	{	// Fonts and painting without display (as option -render)
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	QGuiApplication a(argc, argv);
+	CGlyphBase::initializeSymbolTable();
+	testNumerics();
+	testFiles();
+	testRender();
+	fprintf(stdout, "%u checks, %u failed\n", g_NumCheck, g_NumFailed);
+	return int(g_NumFailed);
+}